@@ -0,0 +1,152 @@
+#pragma once
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "jms/external/glm.hpp"
+#include "jms/graphics/culling.hpp"
+#include "jms/utils/executor.hpp"
+#include "jms/utils/simd.hpp"
+
+
+namespace jms {
+
+
+struct LodSettings {
+    // Screen height fractions in descending order; LOD i is the first with size >= lod_thresholds[i] and the last LOD,
+    // lod_thresholds.size(), is anything smaller.  At most 255 thresholds.
+    std::vector<float> lod_thresholds{};
+    // Visible objects smaller than this fraction of the screen height are culled as well; 0 keeps everything.
+    float min_screen_size{0.0f};
+};
+
+
+/***
+ * Frustum culls bounding spheres and picks a LOD per visible sphere from its projected size, split into chunks run by
+ * any executor (see jms::ParallelFor); e.g. a jms::ThreadPool or std::execution::par.
+ *
+ * Each chunk writes its visible indices into its own slice of a scratch array so no chunk waits on another.  The
+ * slices are then gathered, again in parallel, at offsets from a prefix sum of the chunk counts.  The result is
+ * identical to a serial pass; indices increase and lods[i] belongs to visible[i].
+ *
+ * The default chunk of 4096 spheres is 64 KiB of SoA input plus its outputs, sized to stay in L2 while culled.
+ */
+class CullLodJob {
+public:
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 4096;
+
+private:
+    size_t chunk_size{DEFAULT_CHUNK_SIZE};
+    std::vector<uint32_t> chunk_indices{};
+    std::vector<uint8_t> chunk_lods{};
+    std::vector<size_t> chunk_counts{};
+    std::vector<size_t> chunk_offsets{};
+    std::vector<uint32_t> visible{};
+    std::vector<uint8_t> lods{};
+
+public:
+    explicit CullLodJob(size_t chunk_size_in = DEFAULT_CHUNK_SIZE)
+    : chunk_size{std::max((chunk_size_in / simd::WIDTH) * simd::WIDTH, simd::WIDTH)}
+    {}
+    CullLodJob(const CullLodJob&) = delete;
+    CullLodJob(CullLodJob&&) noexcept = default;
+    ~CullLodJob() noexcept = default;
+    CullLodJob& operator=(const CullLodJob&) = delete;
+    CullLodJob& operator=(CullLodJob&&) noexcept = default;
+
+    /***
+     * view and projection are the camera's; projection is one of the Perspective_RH_* matrices, whose [1][1] scales
+     * view space height to NDC.  Returns the number of visible spheres.
+     */
+    template <typename Executor_t>
+    size_t Run(Executor_t&& executor,
+               const SphereSoA& spheres,
+               const glm::mat4& view,
+               const glm::mat4& projection,
+               const LodSettings& settings) {
+        if (settings.lod_thresholds.size() > std::numeric_limits<uint8_t>::max()) {
+            throw std::runtime_error{"CullLodJob: too many LOD thresholds."};
+        }
+        const size_t size = spheres.Size();
+        const size_t num_chunks = (size + chunk_size - 1) / chunk_size;
+        chunk_indices.resize(size);
+        chunk_lods.resize(size);
+        chunk_counts.assign(num_chunks, 0);
+        chunk_offsets.resize(num_chunks);
+
+        const Frustum frustum = ExtractFrustum(projection * view);
+        ParallelFor(executor, num_chunks, [&](size_t chunk) {
+            chunk_counts[chunk] = CullChunk(frustum, spheres, view, projection, settings, chunk);
+        });
+
+        size_t total = 0;
+        for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+            chunk_offsets[chunk] = total;
+            total += chunk_counts[chunk];
+        }
+        visible.resize(total);
+        lods.resize(total);
+        ParallelFor(executor, num_chunks, [this](size_t chunk) {
+            const size_t begin = chunk * chunk_size;
+            std::copy_n(chunk_indices.begin() + begin, chunk_counts[chunk], visible.begin() + chunk_offsets[chunk]);
+            std::copy_n(chunk_lods.begin() + begin, chunk_counts[chunk], lods.begin() + chunk_offsets[chunk]);
+        });
+        return total;
+    }
+
+    std::span<const uint32_t> Visible() const noexcept { return visible; }
+    std::span<const uint8_t> Lods() const noexcept { return lods; }
+    size_t ChunkSize() const noexcept { return chunk_size; }
+
+    // Fraction of the screen height covered by a sphere at view space depth; infinity with the camera inside it.
+    static float ScreenSize(float radius, float depth, float projection_scale) noexcept {
+        if (depth <= radius) { return std::numeric_limits<float>::infinity(); }
+        return radius * projection_scale / depth;
+    }
+
+    static uint8_t SelectLod(float screen_size, const std::vector<float>& lod_thresholds) noexcept {
+        uint8_t lod = 0;
+        while (lod < lod_thresholds.size() && screen_size < lod_thresholds[lod]) { ++lod; }
+        return lod;
+    }
+
+private:
+    size_t CullChunk(const Frustum& frustum,
+                     const SphereSoA& spheres,
+                     const glm::mat4& view,
+                     const glm::mat4& projection,
+                     const LodSettings& settings,
+                     size_t chunk) {
+        const size_t begin = chunk * chunk_size;
+        const size_t end = std::min(begin + chunk_size, spheres.Size());
+        uint32_t* indices = chunk_indices.data() + begin;
+        uint8_t* chunk_lod = chunk_lods.data() + begin;
+        const size_t num_visible = CullSpheres(frustum, spheres, begin, end, {indices, end - begin});
+
+        // Depth is view space z; the Perspective_RH_* cameras look down +z.
+        const glm::vec4 depth_row{view[0][2], view[1][2], view[2][2], view[3][2]};
+        const float projection_scale = projection[1][1];
+        size_t count = 0;
+        for (size_t j = 0; j < num_visible; ++j) {
+            const uint32_t i = indices[j];
+            const float depth = depth_row.x * spheres.x[i] + depth_row.y * spheres.y[i] + depth_row.z * spheres.z[i] +
+                                depth_row.w;
+            const float screen_size = ScreenSize(spheres.radius[i], depth, projection_scale);
+            if (screen_size < settings.min_screen_size) { continue; }
+            indices[count] = i;
+            chunk_lod[count] = SelectLod(screen_size, settings.lod_thresholds);
+            ++count;
+        }
+        return count;
+    }
+};
+
+
+}
@@ -0,0 +1,244 @@
+#pragma once
+
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+#include "jms/external/glm.hpp"
+#include "jms/utils/simd.hpp"
+
+
+namespace jms {
+
+
+/***
+ * Planes are (normal, d) with unit normals pointing inward; a point p is inside a plane when dot(normal, p) + d >= 0.
+ * The far plane is dropped for the infinite projections (Perspective_RH_ZI/OI) so num_planes is 5 or 6.
+ */
+struct Frustum {
+    std::array<glm::vec4, 6> planes{};
+    size_t num_planes{0};
+    bool has_far_plane{false};
+
+    bool TestSphere(const glm::vec3& center, float radius) const noexcept {
+        for (size_t i = 0; i < num_planes; ++i) {
+            if (glm::dot(glm::vec3{planes[i]}, center) + planes[i].w < -radius) { return false; }
+        }
+        return true;
+    }
+
+    // Conservative; boxes crossing the corner of two planes outside the frustum are kept.
+    bool TestAabb(const glm::vec3& center, const glm::vec3& extent) const noexcept {
+        for (size_t i = 0; i < num_planes; ++i) {
+            const glm::vec3 normal{planes[i]};
+            if (glm::dot(normal, center) + planes[i].w < -glm::dot(glm::abs(normal), extent)) { return false; }
+        }
+        return true;
+    }
+};
+
+
+// Structure of arrays inputs; every span has the same length.
+struct SphereSoA {
+    std::span<const float> x{};
+    std::span<const float> y{};
+    std::span<const float> z{};
+    std::span<const float> radius{};
+
+    size_t Size() const noexcept { return x.size(); }
+};
+
+
+struct AabbSoA {
+    std::span<const float> center_x{};
+    std::span<const float> center_y{};
+    std::span<const float> center_z{};
+    std::span<const float> extent_x{};
+    std::span<const float> extent_y{};
+    std::span<const float> extent_z{};
+
+    size_t Size() const noexcept { return center_x.size(); }
+};
+
+
+// Planes of any matrix built by the Perspective_RH_* functions, optionally multiplied by a view (and model) matrix.
+Frustum ExtractFrustum(const glm::mat4& m);
+// Writes the indices of visible objects in [begin, end) in increasing order; returns the number written.
+// visible must have room for end - begin indices.
+size_t CullSpheres(const Frustum& frustum, const SphereSoA& spheres, size_t begin, size_t end,
+                   std::span<uint32_t> visible);
+size_t CullSpheres(const Frustum& frustum, const SphereSoA& spheres, std::span<uint32_t> visible);
+size_t CullAabbs(const Frustum& frustum, const AabbSoA& aabbs, size_t begin, size_t end, std::span<uint32_t> visible);
+size_t CullAabbs(const Frustum& frustum, const AabbSoA& aabbs, std::span<uint32_t> visible);
+
+
+Frustum ExtractFrustum(const glm::mat4& m) {
+    // Reference: Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix; Gribb, Hartmann
+    auto Row = [&m](glm::length_t i) { return glm::vec4{m[0][i], m[1][i], m[2][i], m[3][i]}; };
+    auto NormalLength = [](const glm::vec4& plane) { return glm::length(glm::vec3{plane}); };
+    const glm::vec4 r0 = Row(0);
+    const glm::vec4 r1 = Row(1);
+    const glm::vec4 r2 = Row(2);
+    const glm::vec4 r3 = Row(3);
+
+    // Vulkan clip volume: -w <= x <= w, -w <= y <= w, 0 <= z <= w
+    Frustum out{};
+    for (const glm::vec4& plane : {r3 + r0, r3 - r0, r3 + r1, r3 - r1}) {
+        out.planes[out.num_planes++] = plane / NormalLength(plane);
+    }
+
+    // Which of z >= 0 and z <= w is near depends on reversed-Z.  Finite projections give opposite facing z planes.
+    // Infinite ones give a zero normal, or with the epsilon variants, a near zero normal facing the same way as the
+    // near plane whose plane lies behind the camera; either way that is the far plane and it never culls anything.
+    std::array<glm::vec4, 2> z_planes{r2, r3 - r2};
+    std::array<float, 2> z_lengths{NormalLength(z_planes[0]), NormalLength(z_planes[1])};
+    const bool is_same_facing = glm::dot(glm::vec3{z_planes[0]}, glm::vec3{z_planes[1]}) > 0.0f;
+    const bool is_infinite = is_same_facing || z_lengths[0] == 0.0f || z_lengths[1] == 0.0f;
+    for (size_t i = 0; i < z_planes.size(); ++i) {
+        if (is_infinite && z_lengths[i] <= z_lengths[1 - i]) { continue; }
+        out.planes[out.num_planes++] = z_planes[i] / z_lengths[i];
+    }
+    out.has_far_plane = !is_infinite;
+    return out;
+}
+
+
+namespace detail {
+
+
+inline void ValidateCullRange(std::string_view name, size_t size, size_t begin, size_t end, size_t num_visible) {
+    if (begin > end || end > size) {
+        throw std::runtime_error{std::format("{}: range [{}, {}) exceeds {} objects.\n", name, begin, end, size)};
+    }
+    if (num_visible < end - begin) {
+        throw std::runtime_error{std::format("{}: visible holds {} indices, need {}.\n",
+                                             name, num_visible, end - begin)};
+    }
+}
+
+
+} // namespace detail
+
+
+namespace detail {
+
+
+// Every plane is tested branch free; an early out per plane mispredicts on scattered scenes.
+template <size_t NUM_PLANES>
+size_t CullSpheres(const Frustum& frustum, const SphereSoA& spheres, size_t begin, size_t end, uint32_t* out) {
+    std::array<simd::Float, NUM_PLANES> nx{}, ny{}, nz{}, d{};
+    for (size_t p = 0; p < NUM_PLANES; ++p) {
+        nx[p] = simd::Broadcast(frustum.planes[p].x);
+        ny[p] = simd::Broadcast(frustum.planes[p].y);
+        nz[p] = simd::Broadcast(frustum.planes[p].z);
+        d[p] = simd::Broadcast(frustum.planes[p].w);
+    }
+    const simd::Float zero = simd::Broadcast(0.0f);
+
+    size_t count = 0;
+    size_t i = begin;
+    for (; i + simd::WIDTH <= end; i += simd::WIDTH) {
+        const simd::Float x = simd::Load(spheres.x.data() + i);
+        const simd::Float y = simd::Load(spheres.y.data() + i);
+        const simd::Float z = simd::Load(spheres.z.data() + i);
+        const simd::Float neg_radius = zero - simd::Load(spheres.radius.data() + i);
+        simd::Mask inside = simd::MulAdd(nx[0], x, simd::MulAdd(ny[0], y, simd::MulAdd(nz[0], z, d[0]))) >= neg_radius;
+        for (size_t p = 1; p < NUM_PLANES; ++p) {
+            const simd::Float dist = simd::MulAdd(nx[p], x, simd::MulAdd(ny[p], y, simd::MulAdd(nz[p], z, d[p])));
+            inside = inside & (dist >= neg_radius);
+        }
+        count = simd::CompactIndices(simd::MaskBits(inside), static_cast<uint32_t>(i), out, count);
+    }
+    for (; i < end; ++i) {
+        const glm::vec3 center{spheres.x[i], spheres.y[i], spheres.z[i]};
+        if (frustum.TestSphere(center, spheres.radius[i])) { out[count++] = static_cast<uint32_t>(i); }
+    }
+    return count;
+}
+
+
+template <size_t NUM_PLANES>
+size_t CullAabbs(const Frustum& frustum, const AabbSoA& aabbs, size_t begin, size_t end, uint32_t* out) {
+    std::array<simd::Float, NUM_PLANES> nx{}, ny{}, nz{}, ax{}, ay{}, az{}, d{};
+    for (size_t p = 0; p < NUM_PLANES; ++p) {
+        nx[p] = simd::Broadcast(frustum.planes[p].x);
+        ny[p] = simd::Broadcast(frustum.planes[p].y);
+        nz[p] = simd::Broadcast(frustum.planes[p].z);
+        ax[p] = simd::Broadcast(std::fabs(frustum.planes[p].x));
+        ay[p] = simd::Broadcast(std::fabs(frustum.planes[p].y));
+        az[p] = simd::Broadcast(std::fabs(frustum.planes[p].z));
+        d[p] = simd::Broadcast(frustum.planes[p].w);
+    }
+
+    size_t count = 0;
+    size_t i = begin;
+    for (; i + simd::WIDTH <= end; i += simd::WIDTH) {
+        const simd::Float cx = simd::Load(aabbs.center_x.data() + i);
+        const simd::Float cy = simd::Load(aabbs.center_y.data() + i);
+        const simd::Float cz = simd::Load(aabbs.center_z.data() + i);
+        const simd::Float ex = simd::Load(aabbs.extent_x.data() + i);
+        const simd::Float ey = simd::Load(aabbs.extent_y.data() + i);
+        const simd::Float ez = simd::Load(aabbs.extent_z.data() + i);
+        // dist + radius >= 0 where radius is the projection of the extents on the plane normal
+        auto Inside = [&](size_t p) {
+            const simd::Float dist = simd::MulAdd(nx[p], cx, simd::MulAdd(ny[p], cy, simd::MulAdd(nz[p], cz, d[p])));
+            return simd::MulAdd(ax[p], ex, simd::MulAdd(ay[p], ey, simd::MulAdd(az[p], ez, dist))) >=
+                   simd::Broadcast(0.0f);
+        };
+        simd::Mask inside = Inside(0);
+        for (size_t p = 1; p < NUM_PLANES; ++p) { inside = inside & Inside(p); }
+        count = simd::CompactIndices(simd::MaskBits(inside), static_cast<uint32_t>(i), out, count);
+    }
+    for (; i < end; ++i) {
+        const glm::vec3 center{aabbs.center_x[i], aabbs.center_y[i], aabbs.center_z[i]};
+        const glm::vec3 extent{aabbs.extent_x[i], aabbs.extent_y[i], aabbs.extent_z[i]};
+        if (frustum.TestAabb(center, extent)) { out[count++] = static_cast<uint32_t>(i); }
+    }
+    return count;
+}
+
+
+} // namespace detail
+
+
+size_t CullSpheres(const Frustum& frustum, const SphereSoA& spheres, size_t begin, size_t end,
+                   std::span<uint32_t> visible) {
+    const size_t size = spheres.Size();
+    if (spheres.y.size() != size || spheres.z.size() != size || spheres.radius.size() != size) {
+        throw std::runtime_error{"CullSpheres: SoA arrays differ in length."};
+    }
+    detail::ValidateCullRange("CullSpheres", size, begin, end, visible.size());
+    if (frustum.num_planes == 6) { return detail::CullSpheres<6>(frustum, spheres, begin, end, visible.data()); }
+    return detail::CullSpheres<5>(frustum, spheres, begin, end, visible.data());
+}
+
+
+size_t CullSpheres(const Frustum& frustum, const SphereSoA& spheres, std::span<uint32_t> visible) {
+    return CullSpheres(frustum, spheres, 0, spheres.Size(), visible);
+}
+
+
+size_t CullAabbs(const Frustum& frustum, const AabbSoA& aabbs, size_t begin, size_t end, std::span<uint32_t> visible) {
+    const size_t size = aabbs.Size();
+    if (aabbs.center_y.size() != size || aabbs.center_z.size() != size || aabbs.extent_x.size() != size ||
+        aabbs.extent_y.size() != size || aabbs.extent_z.size() != size) {
+        throw std::runtime_error{"CullAabbs: SoA arrays differ in length."};
+    }
+    detail::ValidateCullRange("CullAabbs", size, begin, end, visible.size());
+    if (frustum.num_planes == 6) { return detail::CullAabbs<6>(frustum, aabbs, begin, end, visible.data()); }
+    return detail::CullAabbs<5>(frustum, aabbs, begin, end, visible.data());
+}
+
+
+size_t CullAabbs(const Frustum& frustum, const AabbSoA& aabbs, std::span<uint32_t> visible) {
+    return CullAabbs(frustum, aabbs, 0, aabbs.Size(), visible);
+}
+
+
+}
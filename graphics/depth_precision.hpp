@@ -0,0 +1,116 @@
+#pragma once
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "jms/graphics/projection.hpp"
+
+
+namespace jms {
+
+
+// Depth buffer encodings; mirrors the depth aspect of the Vulkan depth formats.
+enum class DepthEncoding {
+    UNORM16,
+    UNORM24,
+    FLOAT32
+};
+
+
+/***
+ * step: view space distance to the next representable depth value farther away; what two surfaces need between
+ *       them to not z-fight.
+ * error: view space error of computing depth in float from the projection terms, before the depth buffer rounds it.
+ */
+struct DepthPrecisionSample {
+    float distance{0.0f};
+    float depth{0.0f};
+    double step{0.0};
+    double error{0.0};
+};
+
+
+// View space distance as projected by the Projection terms in double; the reference the float results are checked with.
+double LinearDepthExact(const Projection& projection, double depth) noexcept;
+DepthPrecisionSample AnalyzeDepthPrecision(const Projection& projection, DepthEncoding encoding, float distance);
+std::vector<DepthPrecisionSample> AnalyzeDepthPrecision(const Projection& projection,
+                                                        DepthEncoding encoding,
+                                                        std::span<const float> distances);
+// Smallest encoding whose step stays within max_relative_step * distance at every distance; nullopt when none does.
+std::optional<DepthEncoding> SelectDepthEncoding(const Projection& projection,
+                                                 std::span<const float> distances,
+                                                 double max_relative_step);
+
+
+double LinearDepthExact(const Projection& projection, double depth) noexcept {
+    const double z_scale = projection.z_scale;
+    const double z_offset = projection.z_offset;
+    if (projection.is_perspective) { return z_offset / (depth - z_scale); }
+    return (depth - z_offset) / z_scale;
+}
+
+
+DepthPrecisionSample AnalyzeDepthPrecision(const Projection& projection, DepthEncoding encoding, float distance) {
+    // The GPU computes z_c and w_c in float and divides; w_c is exactly distance for perspective.
+    const float depth = projection.Depth(distance);
+    const double clamped = std::clamp(static_cast<double>(depth), 0.0, 1.0);
+    // Depth decreases with distance when reversed.
+    const double farther = projection.is_reversed_z ? -1.0 : 1.0;
+
+    double next{0.0};
+    double stored{0.0};
+    switch (encoding) {
+        case DepthEncoding::UNORM16:
+        case DepthEncoding::UNORM24: {
+            const double max_value = (encoding == DepthEncoding::UNORM16) ? 65535.0 : 16777215.0;
+            const double q = std::round(clamped * max_value);
+            stored = q / max_value;
+            next = std::clamp(q + farther, 0.0, max_value) / max_value;
+            break;
+        }
+        case DepthEncoding::FLOAT32: {
+            stored = clamped;
+            next = std::nextafter(static_cast<float>(clamped), projection.is_reversed_z ? 0.0f : 1.0f);
+            break;
+        }
+    }
+
+    const double stored_distance = LinearDepthExact(projection, stored);
+    const double next_distance = LinearDepthExact(projection, next);
+    DepthPrecisionSample out{.distance=distance, .depth=depth};
+    out.step = (next == stored) ? std::numeric_limits<double>::infinity() : std::abs(next_distance - stored_distance);
+    out.error = std::abs(LinearDepthExact(projection, static_cast<double>(depth)) - static_cast<double>(distance));
+    return out;
+}
+
+
+std::vector<DepthPrecisionSample> AnalyzeDepthPrecision(const Projection& projection,
+                                                        DepthEncoding encoding,
+                                                        std::span<const float> distances) {
+    std::vector<DepthPrecisionSample> out{};
+    out.reserve(distances.size());
+    for (float distance : distances) { out.push_back(AnalyzeDepthPrecision(projection, encoding, distance)); }
+    return out;
+}
+
+
+std::optional<DepthEncoding> SelectDepthEncoding(const Projection& projection,
+                                                 std::span<const float> distances,
+                                                 double max_relative_step) {
+    for (DepthEncoding encoding : {DepthEncoding::UNORM16, DepthEncoding::UNORM24, DepthEncoding::FLOAT32}) {
+        bool is_enough = std::ranges::all_of(distances, [&](float distance) {
+            return AnalyzeDepthPrecision(projection, encoding, distance).step <= max_relative_step * distance;
+        });
+        if (is_enough) { return encoding; }
+    }
+    return std::nullopt;
+}
+
+
+}
@@ -1,9 +1,20 @@
 #pragma once
 
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <format>
 #include <limits>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
 
 #include "jms/external/glm.hpp"
+#include "jms/graphics/culling.hpp"
+#include "jms/utils/simd.hpp"
 
 
 namespace jms {
@@ -14,24 +25,27 @@ namespace jms {
 // Y axis is down; Z axis is into the screen
 
 // Depth range [1, inf]
-glm::mat4 Perspective_RH_OI(float fovy, float aspect_ratio, float near);
+// epsilon keeps rounding from clipping distant geometry; see Projection::Perspective_RH_OI for when 0 is safe.
+glm::mat4 Perspective_RH_OI(float fovy, float aspect_ratio, float near,
+                            float epsilon = std::numeric_limits<float>::epsilon());
 // Depth range [1, 0]
 glm::mat4 Perspective_RH_OZ(float fovy, float aspect_ratio, float near, float far);
 // Depth range [0, inf]
-glm::mat4 Perspective_RH_ZI(float fovy, float aspect_ratio, float near);
+glm::mat4 Perspective_RH_ZI(float fovy, float aspect_ratio, float near,
+                            float epsilon = std::numeric_limits<float>::epsilon());
 // Depth range [0, 1]
 glm::mat4 Perspective_RH_ZO(float fovy, float aspect_ratio, float near, float far);
 
 
-glm::mat4 Perspective_RH_OI(float fovy, float aspect_ratio, float near) {
+glm::mat4 Perspective_RH_OI(float fovy, float aspect_ratio, float near, float epsilon) {
     // Reference: Foundations of Game Engine Development by Eric Lengyel
     const float half_tan_fovy = glm::tan(fovy / 2.0f);
     glm::mat4 out{0.0f};
     out[0][0] = 1.0f / (half_tan_fovy * aspect_ratio);
     out[1][1] = 1.0f / half_tan_fovy;
-    out[2][2] = std::numeric_limits<float>::epsilon();
+    out[2][2] = epsilon;
     out[2][3] = 1.0f;
-    out[3][2] = near * (1.0f - std::numeric_limits<float>::epsilon());
+    out[3][2] = near * (1.0f - epsilon);
     return out;
 }
 
@@ -42,9 +56,9 @@ glm::mat4 Perspective_RH_OZ(float fovy, float aspect_ratio, float near, float fa
 }
 
 
-glm::mat4 Perspective_RH_ZI(float fovy, float aspect_ratio, float near) {
+glm::mat4 Perspective_RH_ZI(float fovy, float aspect_ratio, float near, float epsilon) {
     // Reference: Foundations of Game Engine Development by Eric Lengyel
-    const float e = 1.0f - std::numeric_limits<float>::epsilon();
+    const float e = 1.0f - epsilon;
     const float half_tan_fovy = glm::tan(fovy / 2.0f);
     glm::mat4 out{0.0f};
     out[0][0] = 1.0f / (half_tan_fovy * aspect_ratio);
@@ -68,6 +82,521 @@ glm::mat4 Perspective_RH_ZO(float fovy, float aspect_ratio, float near, float fa
 }
 
 
+namespace detail {
+
+
+// Taylor series in double; accurate to float precision for |x| < pi/2, which covers half of any field of view.
+constexpr double TanSeries(double x) noexcept {
+    double sin = 0.0;
+    double cos = 0.0;
+    double sin_term = x;
+    double cos_term = 1.0;
+    for (int n = 0; n < 20; ++n) {
+        sin += sin_term;
+        cos += cos_term;
+        sin_term *= -(x * x) / static_cast<double>((2 * n + 2) * (2 * n + 3));
+        cos_term *= -(x * x) / static_cast<double>((2 * n + 1) * (2 * n + 2));
+    }
+    return sin / cos;
+}
+
+
+} // namespace detail
+
+
+// std::tan at run time; a series when constant evaluated so fixed projections fold at compile time.
+constexpr float Tan(float x) noexcept {
+    if (std::is_constant_evaluated()) { return static_cast<float>(detail::TanSeries(static_cast<double>(x))); }
+    return std::tan(x);
+}
+
+
+/***
+ * Value type describing a projection by its non zero terms and how it maps depth.  The builders match the free
+ * Perspective_RH_* functions term for term and are constexpr, so a projection with fixed parameters is a constant;
+ * Matrix and Inverse build the glm matrices.
+ *
+ * Perspective: x_c = x_scale * x, y_c = y_scale * y, z_c = z_scale * z + z_offset, w_c = z
+ * Orthographic: x_c = x_scale * x + x_offset, y_c = y_scale * y + y_offset, z_c = z_scale * z + z_offset, w_c = 1
+ */
+struct Projection {
+    bool is_perspective{true};
+    // Depth 1 at near and 0 at far.
+    bool is_reversed_z{false};
+    bool is_infinite_far{false};
+    float near{0.0f};
+    // Infinity when is_infinite_far.
+    float far{0.0f};
+    float x_scale{1.0f};
+    float y_scale{1.0f};
+    float z_scale{1.0f};
+    float z_offset{0.0f};
+    float x_offset{0.0f};
+    float y_offset{0.0f};
+
+    // Depth range [0, 1]
+    static constexpr Projection Perspective_RH_ZO(float fovy, float aspect_ratio, float near, float far) noexcept {
+        const float half_tan_fovy = Tan(fovy / 2.0f);
+        return {.is_perspective=true, .is_reversed_z=false, .is_infinite_far=false, .near=near, .far=far,
+                .x_scale=1.0f / (half_tan_fovy * aspect_ratio), .y_scale=1.0f / half_tan_fovy,
+                .z_scale=far / (far - near), .z_offset=-(far * near) / (far - near)};
+    }
+
+    // Depth range [1, 0]
+    static constexpr Projection Perspective_RH_OZ(float fovy, float aspect_ratio, float near, float far) noexcept {
+        // Swapping near and far also swaps the depth range; see the notes below.
+        Projection out = Perspective_RH_ZO(fovy, aspect_ratio, far, near);
+        out.is_reversed_z = true;
+        out.near = near;
+        out.far = far;
+        return out;
+    }
+
+    // Depth range [0, inf]
+    static constexpr Projection Perspective_RH_ZI(float fovy, float aspect_ratio, float near,
+                                                  float epsilon = std::numeric_limits<float>::epsilon()) noexcept {
+        const float e = 1.0f - epsilon;
+        const float half_tan_fovy = Tan(fovy / 2.0f);
+        return {.is_perspective=true, .is_reversed_z=false, .is_infinite_far=true, .near=near,
+                .far=std::numeric_limits<float>::infinity(),
+                .x_scale=1.0f / (half_tan_fovy * aspect_ratio), .y_scale=1.0f / half_tan_fovy,
+                .z_scale=e, .z_offset=-near * e};
+    }
+
+    /***
+     * Depth range [1, inf]
+     * With epsilon 0 depth is exactly near / z and clip z is the constant near, so rounding can't push distant
+     * geometry past the far side of the clip volume; the epsilon is only needed by Perspective_RH_ZI, where
+     * z_c = z - near approaches w_c = z.  See depth_precision.hpp to compare both against the depth format.
+     */
+    static constexpr Projection Perspective_RH_OI(float fovy, float aspect_ratio, float near,
+                                                  float epsilon = std::numeric_limits<float>::epsilon()) noexcept {
+        const float half_tan_fovy = Tan(fovy / 2.0f);
+        return {.is_perspective=true, .is_reversed_z=true, .is_infinite_far=true, .near=near,
+                .far=std::numeric_limits<float>::infinity(),
+                .x_scale=1.0f / (half_tan_fovy * aspect_ratio), .y_scale=1.0f / half_tan_fovy,
+                .z_scale=epsilon, .z_offset=near * (1.0f - epsilon)};
+    }
+
+    /***
+     * x in [left, right] and y in [top, bottom] map to [-1, 1]; with Y down top < bottom.  Depth maps [near, far] to
+     * [0, 1], or to [1, 0] when is_reversed_z.
+     */
+    static constexpr Projection Orthographic_RH(float left, float right, float top, float bottom, float near, float far,
+                                                bool is_reversed_z = false) noexcept {
+        const float depth = far - near;
+        return {.is_perspective=false, .is_reversed_z=is_reversed_z, .is_infinite_far=false, .near=near, .far=far,
+                .x_scale=2.0f / (right - left), .y_scale=2.0f / (bottom - top),
+                .z_scale=(is_reversed_z ? -1.0f : 1.0f) / depth,
+                .z_offset=(is_reversed_z ? far : -near) / depth,
+                .x_offset=-(right + left) / (right - left), .y_offset=-(bottom + top) / (bottom - top)};
+    }
+
+    // NDC depth of a view space z
+    constexpr float Depth(float view_z) const noexcept {
+        if (is_perspective) { return z_scale + z_offset / view_z; }
+        return z_scale * view_z + z_offset;
+    }
+
+    // View space z of an NDC depth; the inverse of Depth.  Perspective depth 0 (or 1 reversed) of an infinite
+    // projection is at infinity.
+    constexpr float LinearDepth(float depth) const noexcept {
+        if (is_perspective) { return z_offset / (depth - z_scale); }
+        return (depth - z_offset) / z_scale;
+    }
+
+    // Maps an NDC depth to [0, 1] between near and far (0 at near) for any variant; 0 to 1 over [near, inf) as
+    // near / z when the far plane is infinite.
+    constexpr float NormalizedLinearDepth(float depth) const noexcept {
+        const float z = LinearDepth(depth);
+        if (is_infinite_far) { return 1.0f - near / z; }
+        return (z - near) / (far - near);
+    }
+
+    glm::mat4 Matrix() const noexcept {
+        glm::mat4 out{0.0f};
+        out[0][0] = x_scale;
+        out[1][1] = y_scale;
+        out[2][2] = z_scale;
+        out[3][2] = z_offset;
+        if (is_perspective) {
+            out[2][3] = 1.0f;
+        } else {
+            out[3][0] = x_offset;
+            out[3][1] = y_offset;
+            out[3][3] = 1.0f;
+        }
+        return out;
+    }
+
+    // Exact inverse from the terms; e.g. NDC (with depth) to view space for post processing.
+    glm::mat4 Inverse() const noexcept {
+        glm::mat4 out{0.0f};
+        out[0][0] = 1.0f / x_scale;
+        out[1][1] = 1.0f / y_scale;
+        if (is_perspective) {
+            // z = w_c; w = (z_c - z_scale * w_c) / z_offset
+            out[3][2] = 1.0f;
+            out[2][3] = 1.0f / z_offset;
+            out[3][3] = -z_scale / z_offset;
+        } else {
+            out[2][2] = 1.0f / z_scale;
+            out[3][0] = -x_offset / x_scale;
+            out[3][1] = -y_offset / y_scale;
+            out[3][2] = -z_offset / z_scale;
+            out[3][3] = 1.0f;
+        }
+        return out;
+    }
+};
+
+
+// Batch kernels: transform SoA points or AABBs by a clip matrix (e.g. Perspective_RH_* * view) and project them.
+// They run simd::WIDTH items per step: 8 lanes when built with -mavx2 (/arch:AVX2), otherwise the 4 lane SSE2 path
+// that every x86-64 target has.  GCC and Clang builds without -mavx2 also compile an 8 lane AVX2 copy and use it when
+// the CPU has AVX2 and FMA (JMS_SIMD_AVX2_DISPATCH); MSVC builds without /arch:AVX2 stay at 4 lanes.
+
+
+// Set when outside the Vulkan clip volume -w <= x <= w, -w <= y <= w, 0 <= z <= w or behind the eye (w <= 0).
+enum ClipFlag : uint8_t {
+    CLIP_NEG_X = 1u << 0,
+    CLIP_POS_X = 1u << 1,
+    CLIP_NEG_Y = 1u << 2,
+    CLIP_POS_Y = 1u << 3,
+    CLIP_NEG_Z = 1u << 4,
+    CLIP_POS_Z = 1u << 5,
+    CLIP_W = 1u << 6
+};
+
+
+struct PointSoA {
+    std::span<const float> x{};
+    std::span<const float> y{};
+    std::span<const float> z{};
+
+    size_t Size() const noexcept { return x.size(); }
+};
+
+
+// NDC x, y and depth (z / w); only meaningful without CLIP_W.
+struct ProjectedPointSoA {
+    std::span<float> x{};
+    std::span<float> y{};
+    std::span<float> depth{};
+    std::span<uint8_t> clip{};
+};
+
+
+/***
+ * NDC rectangle and depth range of the 8 projected corners.  clip_all is the AND of the corner flags; non zero means
+ * the box is entirely outside one plane.  clip_any is the OR; with CLIP_W set a corner is behind the eye so the
+ * rectangle is the whole screen [-1, 1] and depth is [0, 1].  The rectangle is not clamped to the screen.
+ */
+struct ProjectedAabbSoA {
+    std::span<float> min_x{};
+    std::span<float> min_y{};
+    std::span<float> max_x{};
+    std::span<float> max_y{};
+    std::span<float> min_depth{};
+    std::span<float> max_depth{};
+    std::span<uint8_t> clip_all{};
+    std::span<uint8_t> clip_any{};
+};
+
+
+uint8_t ClipFlags(const glm::vec4& clip) noexcept;
+void ProjectPoints(const glm::mat4& m, const PointSoA& points, const ProjectedPointSoA& out);
+void ProjectAabbs(const glm::mat4& m, const AabbSoA& aabbs, const ProjectedAabbSoA& out);
+
+
+uint8_t ClipFlags(const glm::vec4& clip) noexcept {
+    uint8_t flags = 0;
+    if (clip.x < -clip.w) { flags |= CLIP_NEG_X; }
+    if (clip.x > clip.w) { flags |= CLIP_POS_X; }
+    if (clip.y < -clip.w) { flags |= CLIP_NEG_Y; }
+    if (clip.y > clip.w) { flags |= CLIP_POS_Y; }
+    if (clip.z < 0.0f) { flags |= CLIP_NEG_Z; }
+    if (clip.z > clip.w) { flags |= CLIP_POS_Z; }
+    if (clip.w <= 0.0f) { flags |= CLIP_W; }
+    return flags;
+}
+
+
+namespace detail {
+
+
+// Clip space coordinates of L::WIDTH points; m is broadcast once per call.  L is simd::Lanes or simd::avx2::Lanes.
+template <typename L>
+struct ClipBatch {
+    typename L::Float x;
+    typename L::Float y;
+    typename L::Float z;
+    typename L::Float w;
+};
+
+
+template <typename L>
+struct BroadcastMatrix {
+    using Float = typename L::Float;
+
+    Float m[4][4];
+
+    JMS_SIMD_INLINE explicit BroadcastMatrix(const glm::mat4& a) noexcept {
+        for (glm::length_t c = 0; c < 4; ++c) {
+            for (glm::length_t r = 0; r < 4; ++r) { m[c][r] = L::Broadcast(a[c][r]); }
+        }
+    }
+
+    JMS_SIMD_INLINE Float Row(size_t r, const Float& x, const Float& y, const Float& z) const noexcept {
+        return L::MulAdd(m[0][r], x, L::MulAdd(m[1][r], y, L::MulAdd(m[2][r], z, m[3][r])));
+    }
+
+    JMS_SIMD_INLINE ClipBatch<L> Transform(const Float& x, const Float& y, const Float& z) const noexcept {
+        return {Row(0, x, y, z), Row(1, x, y, z), Row(2, x, y, z), Row(3, x, y, z)};
+    }
+
+    // Column c scaled by s; the clip space offset of moving s along axis c.
+    JMS_SIMD_INLINE ClipBatch<L> Column(size_t c, const Float& s) const noexcept {
+        return {m[c][0] * s, m[c][1] * s, m[c][2] * s, m[c][3] * s};
+    }
+};
+
+
+template <typename L>
+JMS_SIMD_INLINE typename L::Float Flag(const typename L::Mask& m, uint8_t flag,
+                                       const typename L::Float& zero) noexcept {
+    return L::Select(m, L::Broadcast(flag), zero);
+}
+
+
+// Flags as exact float sums of distinct bits so they are built without leaving SIMD registers.
+template <typename L>
+JMS_SIMD_INLINE typename L::Float ClipFlags(const ClipBatch<L>& c) noexcept {
+    const typename L::Float zero = L::Broadcast(0.0f);
+    const typename L::Float neg_w = zero - c.w;
+    return Flag<L>(c.x < neg_w, CLIP_NEG_X, zero) + Flag<L>(c.x > c.w, CLIP_POS_X, zero) +
+           Flag<L>(c.y < neg_w, CLIP_NEG_Y, zero) + Flag<L>(c.y > c.w, CLIP_POS_Y, zero) +
+           Flag<L>(c.z < zero, CLIP_NEG_Z, zero) + Flag<L>(c.z > c.w, CLIP_POS_Z, zero) +
+           Flag<L>(c.w <= zero, CLIP_W, zero);
+}
+
+
+template <typename L>
+JMS_SIMD_INLINE void StoreFlags(const typename L::Float& flags, uint8_t* out) noexcept {
+    float lanes[L::WIDTH];
+    L::Store(lanes, flags);
+    for (size_t lane = 0; lane < L::WIDTH; ++lane) { out[lane] = static_cast<uint8_t>(lanes[lane]); }
+}
+
+
+inline void RequireSize(std::string_view name, size_t size, size_t required) {
+    if (size < required) {
+        throw std::runtime_error{std::format("{}: output holds {} elements, need {}.\n", name, size, required)};
+    }
+}
+
+
+// Full batches of ProjectPoints; returns the index the scalar tail starts at.
+template <typename L>
+JMS_SIMD_INLINE size_t ProjectPointBatches(const glm::mat4& m,
+                                           const PointSoA& points,
+                                           const ProjectedPointSoA& out) noexcept {
+    using Float = typename L::Float;
+    const size_t size = points.Size();
+    const BroadcastMatrix<L> bm{m};
+    const Float one = L::Broadcast(1.0f);
+    size_t i = 0;
+    for (; i + L::WIDTH <= size; i += L::WIDTH) {
+        const ClipBatch<L> c = bm.Transform(L::Load(points.x.data() + i), L::Load(points.y.data() + i),
+                                            L::Load(points.z.data() + i));
+        const Float inv_w = one / c.w;
+        L::Store(out.x.data() + i, c.x * inv_w);
+        L::Store(out.y.data() + i, c.y * inv_w);
+        L::Store(out.depth.data() + i, c.z * inv_w);
+        StoreFlags<L>(ClipFlags(c), out.clip.data() + i);
+    }
+    return i;
+}
+
+
+// Full batches of ProjectAabbs; returns the index the scalar tail starts at.
+template <typename L>
+JMS_SIMD_INLINE size_t ProjectAabbBatches(const glm::mat4& m,
+                                          const AabbSoA& aabbs,
+                                          const ProjectedAabbSoA& out) noexcept {
+    using Float = typename L::Float;
+    using Mask = typename L::Mask;
+    const size_t size = aabbs.Size();
+    // Corners are center +- the extents along each axis; transformed once, the 8 corners are sums of 4 clip vectors.
+    const BroadcastMatrix<L> bm{m};
+    const Float zero = L::Broadcast(0.0f);
+    const Float one = L::Broadcast(1.0f);
+    const Float neg_one = L::Broadcast(-1.0f);
+    size_t i = 0;
+    for (; i + L::WIDTH <= size; i += L::WIDTH) {
+        const ClipBatch<L> center = bm.Transform(L::Load(aabbs.center_x.data() + i),
+                                                 L::Load(aabbs.center_y.data() + i),
+                                                 L::Load(aabbs.center_z.data() + i));
+        const ClipBatch<L> axes[3] = {bm.Column(0, L::Load(aabbs.extent_x.data() + i)),
+                                      bm.Column(1, L::Load(aabbs.extent_y.data() + i)),
+                                      bm.Column(2, L::Load(aabbs.extent_z.data() + i))};
+
+        Float min_x = L::Broadcast(std::numeric_limits<float>::max());
+        Float min_y = min_x;
+        Float min_depth = min_x;
+        Float max_x = zero - min_x;
+        Float max_y = max_x;
+        Float max_depth = max_x;
+        // Bitwise AND/OR of float flag sums isn't available; count the corners outside each plane instead.
+        Float outside[7]{zero, zero, zero, zero, zero, zero, zero};
+        Mask any_behind = zero > one;
+        for (uint32_t corner = 0; corner < 8; ++corner) {
+            ClipBatch<L> c = center;
+            for (size_t axis = 0; axis < 3; ++axis) {
+                const bool is_neg = (corner >> axis) & 1u;
+                c.x = is_neg ? c.x - axes[axis].x : c.x + axes[axis].x;
+                c.y = is_neg ? c.y - axes[axis].y : c.y + axes[axis].y;
+                c.z = is_neg ? c.z - axes[axis].z : c.z + axes[axis].z;
+                c.w = is_neg ? c.w - axes[axis].w : c.w + axes[axis].w;
+            }
+            const Float inv_w = one / c.w;
+            const Float nx = c.x * inv_w;
+            const Float ny = c.y * inv_w;
+            const Float nz = c.z * inv_w;
+            min_x = L::Min(min_x, nx);
+            max_x = L::Max(max_x, nx);
+            min_y = L::Min(min_y, ny);
+            max_y = L::Max(max_y, ny);
+            min_depth = L::Min(min_depth, nz);
+            max_depth = L::Max(max_depth, nz);
+
+            const Float neg_w = zero - c.w;
+            const Mask is_behind = c.w <= zero;
+            const Mask masks[7] = {c.x < neg_w, c.x > c.w, c.y < neg_w, c.y > c.w, c.z < zero, c.z > c.w,
+                                   is_behind};
+            for (size_t k = 0; k < 7; ++k) { outside[k] = outside[k] + L::Select(masks[k], one, zero); }
+            any_behind = any_behind | is_behind;
+        }
+
+        const Float eight = L::Broadcast(8.0f);
+        Float clip_all = zero;
+        Float clip_any = zero;
+        for (size_t k = 0; k < 7; ++k) {
+            const Float bit = L::Broadcast(static_cast<float>(1u << k));
+            clip_all = clip_all + L::Select(outside[k] >= eight, bit, zero);
+            clip_any = clip_any + L::Select(outside[k] > zero, bit, zero);
+        }
+        L::Store(out.min_x.data() + i, L::Select(any_behind, neg_one, min_x));
+        L::Store(out.min_y.data() + i, L::Select(any_behind, neg_one, min_y));
+        L::Store(out.max_x.data() + i, L::Select(any_behind, one, max_x));
+        L::Store(out.max_y.data() + i, L::Select(any_behind, one, max_y));
+        L::Store(out.min_depth.data() + i, L::Select(any_behind, zero, min_depth));
+        L::Store(out.max_depth.data() + i, L::Select(any_behind, one, max_depth));
+        StoreFlags<L>(clip_all, out.clip_all.data() + i);
+        StoreFlags<L>(clip_any, out.clip_any.data() + i);
+    }
+    return i;
+}
+
+
+#if defined(JMS_SIMD_AVX2_DISPATCH)
+
+// The batches compiled for AVX2 and FMA; only called when simd::avx2::HasAvx2().
+[[JMS_SIMD_AVX2_TARGET, gnu::flatten]]
+inline size_t ProjectPointBatchesAvx2(const glm::mat4& m, const PointSoA& points,
+                                      const ProjectedPointSoA& out) noexcept {
+    return ProjectPointBatches<simd::avx2::Lanes>(m, points, out);
+}
+
+
+[[JMS_SIMD_AVX2_TARGET, gnu::flatten]]
+inline size_t ProjectAabbBatchesAvx2(const glm::mat4& m, const AabbSoA& aabbs, const ProjectedAabbSoA& out) noexcept {
+    return ProjectAabbBatches<simd::avx2::Lanes>(m, aabbs, out);
+}
+
+#endif
+
+
+} // namespace detail
+
+
+void ProjectPoints(const glm::mat4& m, const PointSoA& points, const ProjectedPointSoA& out) {
+    const size_t size = points.Size();
+    if (points.y.size() != size || points.z.size() != size) {
+        throw std::runtime_error{"ProjectPoints: SoA arrays differ in length."};
+    }
+    for (size_t out_size : {out.x.size(), out.y.size(), out.depth.size(), out.clip.size()}) {
+        detail::RequireSize("ProjectPoints", out_size, size);
+    }
+
+#if defined(JMS_SIMD_AVX2_DISPATCH)
+    size_t i = simd::avx2::HasAvx2() ? detail::ProjectPointBatchesAvx2(m, points, out) :
+                                       detail::ProjectPointBatches<simd::Lanes>(m, points, out);
+#else
+    size_t i = detail::ProjectPointBatches<simd::Lanes>(m, points, out);
+#endif
+    for (; i < size; ++i) {
+        const glm::vec4 c = m * glm::vec4{points.x[i], points.y[i], points.z[i], 1.0f};
+        const float inv_w = 1.0f / c.w;
+        out.x[i] = c.x * inv_w;
+        out.y[i] = c.y * inv_w;
+        out.depth[i] = c.z * inv_w;
+        out.clip[i] = ClipFlags(c);
+    }
+}
+
+
+void ProjectAabbs(const glm::mat4& m, const AabbSoA& aabbs, const ProjectedAabbSoA& out) {
+    const size_t size = aabbs.Size();
+    if (aabbs.center_y.size() != size || aabbs.center_z.size() != size || aabbs.extent_x.size() != size ||
+        aabbs.extent_y.size() != size || aabbs.extent_z.size() != size) {
+        throw std::runtime_error{"ProjectAabbs: SoA arrays differ in length."};
+    }
+    for (size_t out_size : {out.min_x.size(), out.min_y.size(), out.max_x.size(), out.max_y.size(),
+                            out.min_depth.size(), out.max_depth.size(), out.clip_all.size(), out.clip_any.size()}) {
+        detail::RequireSize("ProjectAabbs", out_size, size);
+    }
+
+#if defined(JMS_SIMD_AVX2_DISPATCH)
+    size_t i = simd::avx2::HasAvx2() ? detail::ProjectAabbBatchesAvx2(m, aabbs, out) :
+                                       detail::ProjectAabbBatches<simd::Lanes>(m, aabbs, out);
+#else
+    size_t i = detail::ProjectAabbBatches<simd::Lanes>(m, aabbs, out);
+#endif
+    for (; i < size; ++i) {
+        const glm::vec3 center{aabbs.center_x[i], aabbs.center_y[i], aabbs.center_z[i]};
+        const glm::vec3 extent{aabbs.extent_x[i], aabbs.extent_y[i], aabbs.extent_z[i]};
+        glm::vec3 min_ndc{std::numeric_limits<float>::max()};
+        glm::vec3 max_ndc{-std::numeric_limits<float>::max()};
+        uint8_t clip_all = 0x7f;
+        uint8_t clip_any = 0;
+        for (uint32_t corner = 0; corner < 8; ++corner) {
+            const glm::vec3 sign{(corner & 1u) ? -1.0f : 1.0f, (corner & 2u) ? -1.0f : 1.0f,
+                                 (corner & 4u) ? -1.0f : 1.0f};
+            const glm::vec4 c = m * glm::vec4{center + sign * extent, 1.0f};
+            const glm::vec3 ndc = glm::vec3{c} / c.w;
+            min_ndc = glm::min(min_ndc, ndc);
+            max_ndc = glm::max(max_ndc, ndc);
+            const uint8_t flags = ClipFlags(c);
+            clip_all &= flags;
+            clip_any |= flags;
+        }
+        if (clip_any & CLIP_W) {
+            min_ndc = {-1.0f, -1.0f, 0.0f};
+            max_ndc = {1.0f, 1.0f, 1.0f};
+        }
+        out.min_x[i] = min_ndc.x;
+        out.min_y[i] = min_ndc.y;
+        out.max_x[i] = max_ndc.x;
+        out.max_y[i] = max_ndc.y;
+        out.min_depth[i] = min_ndc.z;
+        out.max_depth[i] = max_ndc.z;
+        out.clip_all[i] = clip_all;
+        out.clip_any[i] = clip_any;
+    }
+}
+
+
 // Reference: https://vincent-p.github.io/posts/vulkan_perspective_matrix/
 // Reference: Foundations of Game Engine Development by Eric Lengyel
 /*
@@ -0,0 +1,273 @@
+#pragma once
+
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "jms/external/glm.hpp"
+#include <glm/gtc/quaternion.hpp>
+
+#include "jms/utils/simd.hpp"
+
+
+namespace jms {
+
+
+// Half open range of node indices, [begin, end).
+struct TransformRange {
+    uint32_t begin{0};
+    uint32_t end{0};
+};
+
+
+/***
+ * Scene graph transforms with local translation, rotation and scale in structure of arrays form and world matrices
+ * recomputed only under nodes whose local transform changed.  world = parent world * translate * rotate * scale.
+ *
+ * Parents come before their children (Add takes an existing parent) so the nodes are in topological order.  Update
+ * walks the dirty nodes in index order and recomputes each one's subtree through the child lists; a dirty node inside
+ * an already updated subtree is skipped, so every world matrix is computed at most once.  Nothing changed costs
+ * nothing: Update and Upload only touch dirty nodes and the ranges of updated matrices.
+ *
+ * Upload scatters the updated matrices of the last Update into a mapped buffer holding every node's world matrix,
+ * e.g. a storage buffer indexed by node.  DirtyRanges are the byte ranges to flush (non-coherent memory) or copy from
+ * a staging buffer.  A buffer per frame in flight needs the ranges of every Update since that copy was last written;
+ * either keep one device local buffer updated through copies or MarkAllDirty when switching copies is simpler.
+ */
+class TransformHierarchy {
+public:
+    static constexpr uint32_t NO_PARENT = std::numeric_limits<uint32_t>::max();
+
+private:
+    std::vector<float> translation_x{};
+    std::vector<float> translation_y{};
+    std::vector<float> translation_z{};
+    std::vector<float> rotation_x{};
+    std::vector<float> rotation_y{};
+    std::vector<float> rotation_z{};
+    std::vector<float> rotation_w{};
+    std::vector<float> scale_x{};
+    std::vector<float> scale_y{};
+    std::vector<float> scale_z{};
+    std::vector<uint32_t> parents{};
+    // Child lists; NO_PARENT ends a list.
+    std::vector<uint32_t> first_children{};
+    std::vector<uint32_t> next_siblings{};
+    std::vector<glm::mat4> world{};
+    std::vector<uint8_t> is_dirty{};
+    std::vector<uint32_t> dirty_nodes{};
+    std::vector<uint32_t> updated{};
+    std::vector<uint32_t> stack{};
+    std::vector<TransformRange> dirty_ranges{};
+
+public:
+    TransformHierarchy() noexcept = default;
+    TransformHierarchy(const TransformHierarchy&) = default;
+    TransformHierarchy(TransformHierarchy&&) noexcept = default;
+    ~TransformHierarchy() noexcept = default;
+    TransformHierarchy& operator=(const TransformHierarchy&) = default;
+    TransformHierarchy& operator=(TransformHierarchy&&) noexcept = default;
+
+    void Reserve(size_t capacity) {
+        for (auto* v : SoA()) { v->reserve(capacity); }
+        for (auto* v : {&parents, &first_children, &next_siblings}) { v->reserve(capacity); }
+        world.reserve(capacity);
+        is_dirty.reserve(capacity);
+    }
+
+    uint32_t Add(uint32_t parent,
+                 const glm::vec3& translation = glm::vec3{0.0f},
+                 const glm::quat& rotation = glm::quat{1.0f, 0.0f, 0.0f, 0.0f},
+                 const glm::vec3& scale = glm::vec3{1.0f}) {
+        if (parent != NO_PARENT && parent >= Size()) {
+            throw std::runtime_error{std::format("TransformHierarchy::Add: parent {} >= size {}.\n", parent, Size())};
+        }
+        if (Size() >= NO_PARENT) { throw std::runtime_error{"TransformHierarchy::Add: too many nodes."}; }
+        const auto index = static_cast<uint32_t>(Size());
+        for (auto* v : SoA()) { v->push_back(0.0f); }
+        parents.push_back(parent);
+        first_children.push_back(NO_PARENT);
+        next_siblings.push_back(NO_PARENT);
+        if (parent != NO_PARENT) {
+            next_siblings[index] = first_children[parent];
+            first_children[parent] = index;
+        }
+        world.push_back(glm::mat4{1.0f});
+        is_dirty.push_back(0);
+        SetLocal(index, translation, rotation, scale);
+        return index;
+    }
+
+    size_t Size() const noexcept { return parents.size(); }
+    uint32_t Parent(uint32_t index) const { CheckIndex(index); return parents[index]; }
+
+    void SetLocal(uint32_t index, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) {
+        SetTranslation(index, translation);
+        SetRotation(index, rotation);
+        SetScale(index, scale);
+    }
+
+    void SetTranslation(uint32_t index, const glm::vec3& translation) {
+        MarkDirty(index);
+        translation_x[index] = translation.x;
+        translation_y[index] = translation.y;
+        translation_z[index] = translation.z;
+    }
+
+    void SetRotation(uint32_t index, const glm::quat& rotation) {
+        MarkDirty(index);
+        const glm::quat q = glm::normalize(rotation);
+        rotation_x[index] = q.x;
+        rotation_y[index] = q.y;
+        rotation_z[index] = q.z;
+        rotation_w[index] = q.w;
+    }
+
+    void SetScale(uint32_t index, const glm::vec3& scale) {
+        MarkDirty(index);
+        scale_x[index] = scale.x;
+        scale_y[index] = scale.y;
+        scale_z[index] = scale.z;
+    }
+
+    glm::vec3 Translation(uint32_t index) const {
+        CheckIndex(index);
+        return {translation_x[index], translation_y[index], translation_z[index]};
+    }
+
+    glm::quat Rotation(uint32_t index) const {
+        CheckIndex(index);
+        return {rotation_w[index], rotation_x[index], rotation_y[index], rotation_z[index]};
+    }
+
+    glm::vec3 Scale(uint32_t index) const {
+        CheckIndex(index);
+        return {scale_x[index], scale_y[index], scale_z[index]};
+    }
+
+    // As of the last Update.
+    const glm::mat4& World(uint32_t index) const { CheckIndex(index); return world[index]; }
+    std::span<const glm::mat4> Worlds() const noexcept { return world; }
+
+    void MarkAllDirty() {
+        for (uint32_t i = 0; i < Size(); ++i) {
+            if (parents[i] == NO_PARENT) { MarkDirty(i); }
+        }
+    }
+
+    // Recomputes the world matrices under dirty nodes; returns the number recomputed.
+    size_t Update() {
+        updated.clear();
+        dirty_ranges.clear();
+        if (dirty_nodes.empty()) { return 0; }
+
+        std::ranges::sort(dirty_nodes);
+        for (uint32_t root : dirty_nodes) {
+            if (!is_dirty[root]) { continue; }
+            stack.push_back(root);
+            while (!stack.empty()) {
+                const uint32_t i = stack.back();
+                stack.pop_back();
+                UpdateWorld(i);
+                is_dirty[i] = 0;
+                updated.push_back(i);
+                for (uint32_t child = first_children[i]; child != NO_PARENT; child = next_siblings[child]) {
+                    stack.push_back(child);
+                }
+            }
+        }
+        dirty_nodes.clear();
+
+        std::ranges::sort(updated);
+        dirty_ranges.push_back({updated.front(), updated.front() + 1});
+        for (size_t j = 1; j < updated.size(); ++j) {
+            if (updated[j] == dirty_ranges.back().end) {
+                ++dirty_ranges.back().end;
+            } else {
+                dirty_ranges.push_back({updated[j], updated[j] + 1});
+            }
+        }
+        return updated.size();
+    }
+
+    // Node ranges updated by the last Update; byte ranges are [begin * stride, (end - 1) * stride + 64).
+    std::span<const TransformRange> DirtyRanges() const noexcept { return dirty_ranges; }
+
+    // Writes the matrices updated by the last Update to out[i * stride]; out holds a matrix for every node.
+    void Upload(std::span<std::byte> out, size_t stride = sizeof(glm::mat4)) const {
+        if (stride < sizeof(glm::mat4)) {
+            throw std::runtime_error{std::format("TransformHierarchy::Upload: stride {} is less than {}.\n",
+                                                 stride, sizeof(glm::mat4))};
+        }
+        if (Size() && out.size() < (Size() - 1) * stride + sizeof(glm::mat4)) {
+            throw std::runtime_error{std::format("TransformHierarchy::Upload: {} bytes can't hold {} matrices.\n",
+                                                 out.size(), Size())};
+        }
+        for (const TransformRange& range : dirty_ranges) {
+            if (stride == sizeof(glm::mat4)) {
+                std::memcpy(out.data() + range.begin * stride, std::addressof(world[range.begin]),
+                            (range.end - range.begin) * sizeof(glm::mat4));
+                continue;
+            }
+            for (uint32_t i = range.begin; i < range.end; ++i) {
+                std::memcpy(out.data() + i * stride, std::addressof(world[i]), sizeof(glm::mat4));
+            }
+        }
+    }
+
+private:
+    std::array<std::vector<float>*, 10> SoA() noexcept {
+        return {&translation_x, &translation_y, &translation_z, &rotation_x, &rotation_y, &rotation_z, &rotation_w,
+                &scale_x, &scale_y, &scale_z};
+    }
+
+    void CheckIndex(uint32_t index) const {
+        if (index >= Size()) {
+            throw std::runtime_error{std::format("TransformHierarchy: index {} >= size {}.\n", index, Size())};
+        }
+    }
+
+    void MarkDirty(uint32_t index) {
+        CheckIndex(index);
+        if (is_dirty[index]) { return; }
+        is_dirty[index] = 1;
+        dirty_nodes.push_back(index);
+    }
+
+    void UpdateWorld(uint32_t i) noexcept {
+        const float x = rotation_x[i], y = rotation_y[i], z = rotation_z[i], w = rotation_w[i];
+        const float sx = scale_x[i], sy = scale_y[i], sz = scale_z[i];
+        glm::mat4 local{1.0f};
+        local[0][0] = (1.0f - 2.0f * (y * y + z * z)) * sx;
+        local[0][1] = 2.0f * (x * y + w * z) * sx;
+        local[0][2] = 2.0f * (x * z - w * y) * sx;
+        local[1][0] = 2.0f * (x * y - w * z) * sy;
+        local[1][1] = (1.0f - 2.0f * (x * x + z * z)) * sy;
+        local[1][2] = 2.0f * (y * z + w * x) * sy;
+        local[2][0] = 2.0f * (x * z + w * y) * sz;
+        local[2][1] = 2.0f * (y * z - w * x) * sz;
+        local[2][2] = (1.0f - 2.0f * (x * x + y * y)) * sz;
+        local[3][0] = translation_x[i];
+        local[3][1] = translation_y[i];
+        local[3][2] = translation_z[i];
+
+        if (parents[i] == NO_PARENT) {
+            world[i] = local;
+            return;
+        }
+        simd::MultiplyMat4(std::addressof(world[parents[i]][0][0]), std::addressof(local[0][0]),
+                           std::addressof(world[i][0][0]));
+    }
+};
+
+
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "jms/external/glm.hpp"
+
+
+namespace jms {
+
+
+// Unpacked vertex; bitangent = cross(normal, tangent.xyz) * tangent.w with tangent.w = +1 or -1.
+struct MeshVertex {
+    glm::vec3 position{0.0f};
+    glm::vec3 normal{0.0f, 0.0f, 1.0f};
+    glm::vec4 tangent{1.0f, 0.0f, 0.0f, 1.0f};
+    glm::vec2 uv{0.0f};
+};
+
+
+/***
+ * 20 bytes against MeshVertex's 48, in one interleaved binding (see vulkan::PackedVertexInput):
+ * position: R16G16B16A16_UNORM within the mesh AABB; w is the bitangent sign, 1 for +1 and 0 for -1.
+ * normal, tangent: R16G16_SNORM octahedral.
+ * uv: R16G16_SFLOAT.
+ *
+ * Round trip error: position half a step, extent / 131070, per axis plus float rounding; normal and tangent under
+ * 0.008 degrees; uv as float to half rounding, 2^-11 relative for normal values.
+ *
+ * GLSL:
+ *     vec3 OctahedralDecode(vec2 e) {
+ *         vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+ *         float t = max(-n.z, 0.0);
+ *         n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+ *         return normalize(n);
+ *     }
+ *     vec3 position = in_position.xyz * dequantization.position_scale.xyz + dequantization.position_offset.xyz;
+ *     float bitangent_sign = in_position.w * 2.0 - 1.0;
+ */
+struct PackedVertex {
+    std::array<uint16_t, 4> position{};
+    std::array<int16_t, 2> normal{};
+    std::array<int16_t, 2> tangent{};
+    std::array<uint16_t, 2> uv{};
+};
+static_assert(sizeof(PackedVertex) == 20);
+
+
+// position = packed.xyz * position_scale + position_offset.  vec4s so it drops into std140 or push constants as is.
+struct VertexDequantization {
+    glm::vec4 position_scale{1.0f, 1.0f, 1.0f, 0.0f};
+    glm::vec4 position_offset{0.0f, 0.0f, 0.0f, 0.0f};
+
+    // Scale and translate; multiply into the model matrix to use packed positions with no extra shader work.
+    glm::mat4 Matrix() const noexcept {
+        glm::mat4 out{1.0f};
+        out[0][0] = position_scale.x;
+        out[1][1] = position_scale.y;
+        out[2][2] = position_scale.z;
+        out[3][0] = position_offset.x;
+        out[3][1] = position_offset.y;
+        out[3][2] = position_offset.z;
+        return out;
+    }
+};
+
+
+struct PackedMesh {
+    std::vector<PackedVertex> vertices{};
+    VertexDequantization dequantization{};
+};
+
+
+// IEEE binary16 with round to nearest even; overflow goes to infinity and NaN stays NaN.
+constexpr uint16_t FloatToHalf(float value) noexcept;
+constexpr float HalfToFloat(uint16_t half) noexcept;
+uint16_t QuantizeUnorm16(float value) noexcept;
+int16_t QuantizeSnorm16(float value) noexcept;
+// As the GPU reads R16_UNORM and R16_SNORM.
+constexpr float DequantizeUnorm16(uint16_t value) noexcept;
+constexpr float DequantizeSnorm16(int16_t value) noexcept;
+// Unit vector to the [-1, 1] square and back.
+glm::vec2 OctahedralEncode(const glm::vec3& n) noexcept;
+glm::vec3 OctahedralDecode(const glm::vec2& e) noexcept;
+// Best of the four snorm16 roundings around the exact encoding, by decoded angle.
+std::array<int16_t, 2> PackOctahedralSnorm16(const glm::vec3& n) noexcept;
+glm::vec3 UnpackOctahedralSnorm16(const std::array<int16_t, 2>& packed) noexcept;
+// Position dequantization covering the AABB of the vertices; a flat axis gets a zero scale.
+VertexDequantization ComputeVertexDequantization(std::span<const MeshVertex> vertices) noexcept;
+PackedVertex PackVertex(const MeshVertex& vertex, const VertexDequantization& dequantization) noexcept;
+MeshVertex UnpackVertex(const PackedVertex& vertex, const VertexDequantization& dequantization) noexcept;
+PackedMesh PackVertices(std::span<const MeshVertex> vertices);
+
+
+constexpr uint16_t FloatToHalf(float value) noexcept {
+    const uint32_t bits = std::bit_cast<uint32_t>(value);
+    const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+    const uint32_t abs = bits & 0x7fffffffu;
+    if (abs >= 0x7f800000u) { return sign | 0x7c00u | ((abs > 0x7f800000u) ? 0x200u : 0u); }
+    // 65520 and up round to infinity
+    if (abs >= 0x477ff000u) { return sign | 0x7c00u; }
+    if (abs >= 0x38800000u) {
+        // Rebias the exponent from 127 to 15 and round away the low 13 mantissa bits; a carry bumps the exponent.
+        const uint32_t rebiased = abs - 0x38000000u;
+        return sign | static_cast<uint16_t>((rebiased + 0xfffu + ((rebiased >> 13) & 1u)) >> 13);
+    }
+    // Subnormal half, in units of 2^-24; 2^-25 and below round to zero.
+    if (abs <= 0x33000000u) { return sign; }
+    const uint32_t mantissa = (abs & 0x7fffffu) | 0x800000u;
+    const uint32_t shift = 126u - (abs >> 23);
+    const uint32_t remainder = mantissa & ((1u << shift) - 1u);
+    const uint32_t halfway = 1u << (shift - 1u);
+    uint32_t out = mantissa >> shift;
+    if (remainder > halfway || (remainder == halfway && (out & 1u))) { ++out; }
+    return sign | static_cast<uint16_t>(out);
+}
+
+
+constexpr float HalfToFloat(uint16_t half) noexcept {
+    const uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1fu;
+    const uint32_t mantissa = half & 0x3ffu;
+    if (exponent == 0x1fu) { return std::bit_cast<float>(sign | 0x7f800000u | (mantissa << 13)); }
+    if (exponent == 0) {
+        const float out = static_cast<float>(mantissa) * 0x1p-24f;
+        return sign ? -out : out;
+    }
+    return std::bit_cast<float>(sign | ((exponent + 112u) << 23) | (mantissa << 13));
+}
+
+
+uint16_t QuantizeUnorm16(float value) noexcept {
+    return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+
+int16_t QuantizeSnorm16(float value) noexcept {
+    return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+
+constexpr float DequantizeUnorm16(uint16_t value) noexcept { return static_cast<float>(value) / 65535.0f; }
+
+
+constexpr float DequantizeSnorm16(int16_t value) noexcept {
+    return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+}
+
+
+glm::vec2 OctahedralEncode(const glm::vec3& n) noexcept {
+    const float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (l1 == 0.0f) { return glm::vec2{0.0f}; }
+    const glm::vec2 p{n.x / l1, n.y / l1};
+    if (n.z >= 0.0f) { return p; }
+    // Fold the lower hemisphere over the diagonals.
+    return {(1.0f - std::abs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f),
+            (1.0f - std::abs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f)};
+}
+
+
+glm::vec3 OctahedralDecode(const glm::vec2& e) noexcept {
+    glm::vec3 n{e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y)};
+    const float t = std::max(-n.z, 0.0f);
+    n.x += (n.x >= 0.0f) ? -t : t;
+    n.y += (n.y >= 0.0f) ? -t : t;
+    return glm::normalize(n);
+}
+
+
+std::array<int16_t, 2> PackOctahedralSnorm16(const glm::vec3& n) noexcept {
+    const glm::vec2 e = OctahedralEncode(n) * 32767.0f;
+    const glm::vec3 unit = glm::normalize(n);
+    std::array<int16_t, 2> best{};
+    float best_dot = -std::numeric_limits<float>::infinity();
+    for (float x : {std::floor(e.x), std::ceil(e.x)}) {
+        for (float y : {std::floor(e.y), std::ceil(e.y)}) {
+            const std::array<int16_t, 2> candidate{static_cast<int16_t>(std::clamp(x, -32767.0f, 32767.0f)),
+                                                   static_cast<int16_t>(std::clamp(y, -32767.0f, 32767.0f))};
+            const float dot = glm::dot(UnpackOctahedralSnorm16(candidate), unit);
+            if (dot > best_dot) {
+                best_dot = dot;
+                best = candidate;
+            }
+        }
+    }
+    return best;
+}
+
+
+glm::vec3 UnpackOctahedralSnorm16(const std::array<int16_t, 2>& packed) noexcept {
+    return OctahedralDecode({DequantizeSnorm16(packed[0]), DequantizeSnorm16(packed[1])});
+}
+
+
+VertexDequantization ComputeVertexDequantization(std::span<const MeshVertex> vertices) noexcept {
+    if (vertices.empty()) { return {}; }
+    glm::vec3 min{vertices.front().position};
+    glm::vec3 max{vertices.front().position};
+    for (const MeshVertex& vertex : vertices) {
+        min = glm::min(min, vertex.position);
+        max = glm::max(max, vertex.position);
+    }
+    return {.position_scale=glm::vec4{max - min, 0.0f}, .position_offset=glm::vec4{min, 0.0f}};
+}
+
+
+PackedVertex PackVertex(const MeshVertex& vertex, const VertexDequantization& dequantization) noexcept {
+    PackedVertex out{};
+    for (glm::length_t i = 0; i < 3; ++i) {
+        const float scale = dequantization.position_scale[i];
+        const float t = (scale > 0.0f) ? (vertex.position[i] - dequantization.position_offset[i]) / scale : 0.0f;
+        out.position[i] = QuantizeUnorm16(t);
+    }
+    out.position[3] = (vertex.tangent.w < 0.0f) ? 0 : std::numeric_limits<uint16_t>::max();
+    out.normal = PackOctahedralSnorm16(vertex.normal);
+    out.tangent = PackOctahedralSnorm16(glm::vec3{vertex.tangent});
+    out.uv = {FloatToHalf(vertex.uv.x), FloatToHalf(vertex.uv.y)};
+    return out;
+}
+
+
+MeshVertex UnpackVertex(const PackedVertex& vertex, const VertexDequantization& dequantization) noexcept {
+    MeshVertex out{};
+    for (glm::length_t i = 0; i < 3; ++i) {
+        out.position[i] = DequantizeUnorm16(vertex.position[i]) * dequantization.position_scale[i] +
+                          dequantization.position_offset[i];
+    }
+    out.normal = UnpackOctahedralSnorm16(vertex.normal);
+    const float bitangent_sign = DequantizeUnorm16(vertex.position[3]) * 2.0f - 1.0f;
+    out.tangent = glm::vec4{UnpackOctahedralSnorm16(vertex.tangent), bitangent_sign};
+    out.uv = {HalfToFloat(vertex.uv[0]), HalfToFloat(vertex.uv[1])};
+    return out;
+}
+
+
+PackedMesh PackVertices(std::span<const MeshVertex> vertices) {
+    PackedMesh out{.dequantization=ComputeVertexDequantization(vertices)};
+    out.vertices.reserve(vertices.size());
+    for (const MeshVertex& vertex : vertices) { out.vertices.push_back(PackVertex(vertex, out.dequantization)); }
+    return out;
+}
+
+
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+namespace jms {
+namespace memory {
+
+
+// Lifetime [first, last] is inclusive and measured in any monotonic unit; e.g. pass position within a frame.
+template <typename SizeType=size_t>
+struct AliasInterval {
+    SizeType size{0};
+    SizeType alignment{1};
+    size_t first{0};
+    size_t last{0};
+};
+
+
+template <typename SizeType=size_t>
+struct AliasPacking {
+    std::vector<SizeType> offsets{};
+    SizeType total_size{0};
+};
+
+
+template <typename SizeType>
+constexpr bool IsLifetimeOverlapping(const AliasInterval<SizeType>& a, const AliasInterval<SizeType>& b) noexcept {
+    return a.first <= b.last && b.first <= a.last;
+}
+
+
+/***
+ * Packs intervals into a single block such that two intervals whose lifetimes overlap never share memory.  Intervals
+ * are placed largest first at the lowest aligned offset that fits between the already placed intervals they overlap
+ * in time (greedy interval graph coloring with sizes); this is the usual heuristic for transient render targets and
+ * typically lands close to the peak of the live set.
+ */
+template <typename SizeType>
+AliasPacking<SizeType> PackAliasIntervals(const std::vector<AliasInterval<SizeType>>& intervals) {
+    AliasPacking<SizeType> packing{.offsets=std::vector<SizeType>(intervals.size(), 0), .total_size=0};
+    std::vector<size_t> order(intervals.size());
+    std::iota(order.begin(), order.end(), static_cast<size_t>(0));
+    std::ranges::stable_sort(order, [&intervals](size_t a, size_t b) { return intervals[a].size > intervals[b].size; });
+
+    std::vector<size_t> placed{};
+    placed.reserve(intervals.size());
+    std::vector<std::pair<SizeType, SizeType>> occupied{};
+    for (size_t i : order) {
+        const AliasInterval<SizeType>& interval = intervals[i];
+        if (interval.first > interval.last) { throw std::runtime_error{"AliasInterval lifetime is reversed."}; }
+        if (interval.alignment < 1) { throw std::runtime_error{"AliasInterval requires a positive alignment."}; }
+        occupied.clear();
+        for (size_t j : placed) {
+            if (IsLifetimeOverlapping(interval, intervals[j])) {
+                occupied.emplace_back(packing.offsets[j], packing.offsets[j] + intervals[j].size);
+            }
+        }
+        std::ranges::sort(occupied);
+
+        auto AlignUp = [a=interval.alignment](SizeType v) { return ((v + a - 1) / a) * a; };
+        SizeType offset = 0;
+        for (const auto& [begin, end] : occupied) {
+            if (offset + interval.size <= begin) { break; }
+            offset = std::max(offset, AlignUp(end));
+        }
+        packing.offsets[i] = offset;
+        packing.total_size = std::max(packing.total_size, offset + interval.size);
+        placed.push_back(i);
+    }
+    return packing;
+}
+
+
+// Sum of all sizes; the memory required without aliasing.
+template <typename SizeType>
+SizeType UnaliasedSize(const std::vector<AliasInterval<SizeType>>& intervals) {
+    return std::accumulate(intervals.begin(), intervals.end(), SizeType{0},
+                           [](SizeType sum, const auto& i) { return sum + i.size; });
+}
+
+
+/***
+ * Pairs (earlier, later) of intervals sharing memory in the packing.  The later interval must not touch the memory
+ * until the GPU is done with the earlier; i.e. an execution dependency is required between them.
+ */
+template <typename SizeType>
+std::vector<std::pair<size_t, size_t>> AliasedPairs(const std::vector<AliasInterval<SizeType>>& intervals,
+                                                    const AliasPacking<SizeType>& packing) {
+    std::vector<std::pair<size_t, size_t>> pairs{};
+    for (size_t a = 0; a < intervals.size(); ++a) {
+        for (size_t b = 0; b < intervals.size(); ++b) {
+            if (intervals[a].last >= intervals[b].first) { continue; }
+            bool memory_overlap = packing.offsets[a] < packing.offsets[b] + intervals[b].size &&
+                                  packing.offsets[b] < packing.offsets[a] + intervals[a].size;
+            if (memory_overlap) { pairs.emplace_back(a, b); }
+        }
+    }
+    return pairs;
+}
+
+
+} // namespace memory
+} // namespace jms
@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "jms/memory/aliasing.hpp"
+#include "check.hpp"
+
+
+using namespace jms::memory;
+using Interval = AliasInterval<size_t>;
+using Pairs = std::vector<std::pair<size_t, size_t>>;
+
+
+namespace {
+
+
+// Largest sum of sizes live at any one time; no packing can be smaller.
+size_t PeakLiveSize(const std::vector<Interval>& intervals) {
+    size_t peak = 0;
+    for (const Interval& at : intervals) {
+        size_t live = 0;
+        for (const Interval& interval : intervals) {
+            if (interval.first <= at.first && at.first <= interval.last) { live += interval.size; }
+        }
+        peak = std::max(peak, live);
+    }
+    return peak;
+}
+
+
+// Aligned offsets, within total_size, and no shared memory between intervals alive at the same time.
+bool IsValidPacking(const std::vector<Interval>& intervals, const AliasPacking<size_t>& packing) {
+    if (packing.offsets.size() != intervals.size()) { return false; }
+    for (size_t a = 0; a < intervals.size(); ++a) {
+        if (packing.offsets[a] % intervals[a].alignment) { return false; }
+        if (packing.offsets[a] + intervals[a].size > packing.total_size) { return false; }
+        for (size_t b = a + 1; b < intervals.size(); ++b) {
+            bool memory_overlap = packing.offsets[a] < packing.offsets[b] + intervals[b].size &&
+                                  packing.offsets[b] < packing.offsets[a] + intervals[a].size;
+            if (memory_overlap && IsLifetimeOverlapping(intervals[a], intervals[b])) { return false; }
+        }
+    }
+    return true;
+}
+
+
+bool ThrowsRuntimeError(const std::vector<Interval>& intervals) {
+    try {
+        PackAliasIntervals(intervals);
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+
+void TestDisjoint() {
+    const std::vector<Interval> intervals{{.size=256, .first=0, .last=1}, {.size=256, .first=2, .last=3}};
+    const auto packing = PackAliasIntervals(intervals);
+    JMS_CHECK(packing.offsets == std::vector<size_t>{0, 0});
+    JMS_CHECK(packing.total_size == 256);
+    JMS_CHECK(IsValidPacking(intervals, packing));
+    JMS_CHECK(AliasedPairs(intervals, packing) == Pairs{{0, 1}});
+}
+
+
+void TestOverlapping() {
+    // Lifetimes [0, 2] and [1, 3] share 1 and 2; an interval ending where the other starts overlaps too.
+    const std::vector<Interval> intervals{{.size=128, .first=1, .last=3}, {.size=256, .first=0, .last=2},
+                                          {.size=64, .first=3, .last=4}};
+    const auto packing = PackAliasIntervals(intervals);
+    JMS_CHECK(packing.offsets == std::vector<size_t>{256, 0, 0});
+    JMS_CHECK(packing.total_size == 384);
+    JMS_CHECK(IsValidPacking(intervals, packing));
+    JMS_CHECK(UnaliasedSize(intervals) == 448);
+    JMS_CHECK(AliasedPairs(intervals, packing) == Pairs{{1, 2}});
+}
+
+
+void TestAlignment() {
+    const std::vector<Interval> intervals{{.size=100, .alignment=4, .first=0, .last=1},
+                                          {.size=64, .alignment=256, .first=1, .last=2},
+                                          {.size=16, .alignment=64, .first=2, .last=2}};
+    const auto packing = PackAliasIntervals(intervals);
+    // 64 at 256 rather than 100; 16 fits below it at 0 since the 100 byte interval is dead by then.
+    JMS_CHECK(packing.offsets == std::vector<size_t>{0, 256, 0});
+    JMS_CHECK(packing.total_size == 320);
+    JMS_CHECK(IsValidPacking(intervals, packing));
+}
+
+
+void TestPeakSize() {
+    const std::vector<Interval> intervals{{.size=1024, .alignment=256, .first=0, .last=2},
+                                          {.size=512, .alignment=256, .first=0, .last=0},
+                                          {.size=512, .alignment=256, .first=1, .last=2},
+                                          {.size=1024, .alignment=256, .first=3, .last=4},
+                                          {.size=256, .alignment=256, .first=4, .last=4}};
+    const auto packing = PackAliasIntervals(intervals);
+    JMS_CHECK(packing.offsets == std::vector<size_t>{0, 1024, 1024, 0, 1024});
+    JMS_CHECK(IsValidPacking(intervals, packing));
+    JMS_CHECK(PeakLiveSize(intervals) == 1536);
+    JMS_CHECK(packing.total_size == 1536);
+    JMS_CHECK(UnaliasedSize(intervals) == 3328);
+    JMS_CHECK(AliasedPairs(intervals, packing) == Pairs{{0, 3}, {1, 2}, {1, 4}, {2, 4}});
+}
+
+
+void TestInvalid() {
+    JMS_CHECK(ThrowsRuntimeError({{.size=16, .first=2, .last=1}}));
+    JMS_CHECK(ThrowsRuntimeError({{.size=16, .alignment=0, .first=0, .last=1}}));
+    JMS_CHECK(PackAliasIntervals(std::vector<Interval>{}).total_size == 0);
+}
+
+
+}
+
+
+int main() {
+    TestDisjoint();
+    TestOverlapping();
+    TestAlignment();
+    TestPeakSize();
+    TestInvalid();
+    return jms::tests::Result();
+}
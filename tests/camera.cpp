@@ -0,0 +1,101 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "jms/external/glm.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "jms/vulkan/camera.hpp"
+#include "check.hpp"
+
+
+using jms::vulkan::Camera;
+
+
+namespace {
+
+
+// Camera::View before orientation became a quaternion: yaw, pitch then roll with glm::rotate.
+glm::mat4 EulerRotation(const glm::vec3& angles) {
+    glm::mat4 rotation{1.0f};
+    rotation = glm::rotate(rotation, angles.z, glm::vec3(0.0f, 0.0f, 1.0f));
+    rotation = glm::rotate(rotation, angles.x, glm::vec3(1.0f, 0.0f, 0.0f));
+    rotation = glm::rotate(rotation, angles.y, glm::vec3(0.0f, 1.0f, 0.0f));
+    return rotation;
+}
+
+
+glm::mat4 InverseView(const glm::vec3& position, const glm::mat4& rotation) {
+    return glm::inverse(glm::translate(glm::mat4{1.0f}, position) * rotation);
+}
+
+
+bool IsNear(const glm::mat4& a, const glm::mat4& b, float tolerance) {
+    for (glm::length_t c = 0; c < 4; ++c) {
+        for (glm::length_t r = 0; r < 4; ++r) {
+            if (!(std::abs(a[c][r] - b[c][r]) <= tolerance)) { return false; }
+        }
+    }
+    return true;
+}
+
+
+// glm::inverse is general and in float; the error grows with the translation.
+float Tolerance(const glm::vec3& position) { return 1e-5f * (1.0f + glm::length(position)); }
+
+
+void TestViewMatchesInverse() {
+    const glm::mat4 projection = glm::perspective(1.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+    std::mt19937 rng{7};
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> angle(-3.14159f, 3.14159f);
+    for (int i = 0; i < 1000; ++i) {
+        const glm::vec3 p{position(rng), position(rng), position(rng)};
+        const glm::vec3 angles{angle(rng), angle(rng), angle(rng)};
+        const Camera camera{projection, p, angles};
+        const float tolerance = Tolerance(p);
+        JMS_CHECK(IsNear(camera.View(), InverseView(p, glm::mat4_cast(camera.Orientation())), tolerance));
+        JMS_CHECK(IsNear(camera.View(), InverseView(p, EulerRotation(angles)), tolerance));
+        JMS_CHECK(IsNear(camera.ViewProjection(), projection * InverseView(p, EulerRotation(angles)),
+                         tolerance * 4.0f));
+    }
+}
+
+
+void TestCacheInvalidation() {
+    const glm::mat4 projection = glm::perspective(1.0f, 1.0f, 0.1f, 100.0f);
+    Camera camera{projection, glm::vec3{1.0f, 2.0f, 3.0f}, glm::vec3{0.1f, 0.2f, 0.3f}};
+    auto IsFresh = [&camera]() {
+        const glm::mat4 expected = InverseView(camera.Position(), glm::mat4_cast(camera.Orientation()));
+        const float tolerance = Tolerance(camera.Position());
+        return IsNear(camera.View(), expected, tolerance) &&
+               IsNear(camera.ViewProjection(), camera.Projection() * expected, tolerance * 4.0f);
+    };
+    JMS_CHECK(IsFresh());
+
+    camera.SetPosition(glm::vec3{-5.0f, 0.5f, 8.0f});
+    JMS_CHECK(IsFresh());
+    camera.SetRotation(glm::vec3{-0.4f, 1.2f, 2.5f});
+    JMS_CHECK(IsFresh());
+    camera.SetOrientation(glm::angleAxis(0.7f, glm::vec3{0.0f, 1.0f, 0.0f}));
+    JMS_CHECK(IsFresh());
+    camera.Update(glm::vec3{0.0f, 0.0f, -1.0f}, glm::vec3{0.05f, 0.0f, 0.1f});
+    JMS_CHECK(IsFresh());
+    camera.SetProjection(glm::perspective(0.5f, 2.0f, 1.0f, 10.0f));
+    JMS_CHECK(IsFresh());
+
+    // Cached values are returned by reference until the next change.
+    const glm::mat4* view = &camera.View();
+    JMS_CHECK(&camera.View() == view);
+}
+
+
+}
+
+
+int main() {
+    TestViewMatchesInverse();
+    TestCacheInvalidation();
+    return jms::tests::Result();
+}
@@ -0,0 +1,95 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "jms/external/glm.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "jms/vulkan/camera.hpp"
+
+
+using jms::vulkan::Camera;
+
+
+namespace {
+
+
+constexpr size_t NUM_CAMERAS = 100'000;
+constexpr int NUM_FRAMES = 20;
+
+
+// Camera::View before the quaternion and cache: three glm::rotate, a translate and a general glm::inverse.
+glm::mat4 InverseViewProjection(const glm::mat4& projection, const glm::vec3& position, const glm::vec3& angles) {
+    glm::mat4 rotation{1.0f};
+    rotation = glm::rotate(rotation, angles.z, glm::vec3(0.0f, 0.0f, 1.0f));
+    rotation = glm::rotate(rotation, angles.x, glm::vec3(1.0f, 0.0f, 0.0f));
+    rotation = glm::rotate(rotation, angles.y, glm::vec3(0.0f, 1.0f, 0.0f));
+    return projection * glm::inverse(glm::translate(glm::mat4{1.0f}, position) * rotation);
+}
+
+
+template <typename Fn>
+void Time(const char* name, Fn&& fn) {
+    float checksum = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < NUM_FRAMES; ++frame) { checksum += fn(frame); }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%-40s %8.2f ns/camera (checksum %g)\n", name, elapsed.count() / (NUM_FRAMES * NUM_CAMERAS),
+                static_cast<double>(checksum));
+}
+
+
+}
+
+
+/***
+ * ViewProjection for 100k cameras a frame: the old glm::inverse path against Camera's cached analytic view, both
+ * with every camera moving each frame and with none moving.
+ */
+int main() {
+    const glm::mat4 projection = glm::perspective(1.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+    std::mt19937 rng{1};
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> angle(-3.14159f, 3.14159f);
+    std::vector<glm::vec3> positions(NUM_CAMERAS);
+    std::vector<glm::vec3> angles(NUM_CAMERAS);
+    std::vector<Camera> cameras{};
+    cameras.reserve(NUM_CAMERAS);
+    for (size_t i = 0; i < NUM_CAMERAS; ++i) {
+        positions[i] = glm::vec3{position(rng), position(rng), position(rng)};
+        angles[i] = glm::vec3{angle(rng), angle(rng), angle(rng)};
+        cameras.emplace_back(projection, positions[i], angles[i]);
+    }
+    const glm::vec3 step{0.01f, 0.0f, 0.0f};
+
+    Time("glm::inverse, moving", [&](int frame) {
+        float sum = 0.0f;
+        for (size_t i = 0; i < NUM_CAMERAS; ++i) {
+            sum += InverseViewProjection(projection, positions[i] + step * static_cast<float>(frame), angles[i])[3][0];
+        }
+        return sum;
+    });
+    Time("Camera::ViewProjection, moving", [&](int frame) {
+        float sum = 0.0f;
+        for (size_t i = 0; i < NUM_CAMERAS; ++i) {
+            cameras[i].SetPosition(positions[i] + step * static_cast<float>(frame));
+            sum += cameras[i].ViewProjection()[3][0];
+        }
+        return sum;
+    });
+    Time("Camera::View, moving", [&](int frame) {
+        float sum = 0.0f;
+        for (size_t i = 0; i < NUM_CAMERAS; ++i) {
+            cameras[i].SetPosition(positions[i] + step * static_cast<float>(frame));
+            sum += cameras[i].View()[3][0];
+        }
+        return sum;
+    });
+    Time("Camera::ViewProjection, static (cached)", [&](int) {
+        float sum = 0.0f;
+        for (const Camera& camera : cameras) { sum += camera.ViewProjection()[3][0]; }
+        return sum;
+    });
+    return 0;
+}
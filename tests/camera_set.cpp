@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "jms/external/glm.hpp"
+#include <glm/gtc/quaternion.hpp>
+
+#include "jms/graphics/projection.hpp"
+#include "jms/utils/simd.hpp"
+#include "jms/vulkan/camera.hpp"
+#include "jms/vulkan/camera_set.hpp"
+#include "check.hpp"
+
+
+using namespace jms;
+using namespace jms::vulkan;
+
+
+namespace {
+
+
+// Not a multiple of WIDTH, so the last batch is partial.
+constexpr size_t NUM_CAMERAS = 5 * simd::WIDTH + 3;
+// A multiple of 16 past sizeof(CameraGpuData) = 208 and not 256, the usual minUniformBufferOffsetAlignment.
+constexpr size_t STRIDE = 240;
+constexpr std::byte SENTINEL{0xcd};
+
+
+glm::quat RandomOrientation(std::mt19937& rng) {
+    std::normal_distribution<float> normal{};
+    return glm::normalize(glm::quat{normal(rng), normal(rng), normal(rng), normal(rng)});
+}
+
+
+// Perspective, reversed infinite and orthographic in turn.
+Projection MakeProjection(size_t i) {
+    switch (i % 3) {
+    case 0: return Projection::Perspective_RH_ZO(1.0f, 1.5f, 0.1f, 100.0f);
+    case 1: return Projection::Perspective_RH_OI(0.7f, 1.0f, 0.5f);
+    default: return Projection::Orthographic_RH(-4.0f, 6.0f, -2.0f, 3.0f, 1.0f, 21.0f, i % 2 == 0);
+    }
+}
+
+
+float MaxAbs(const glm::mat4& a) {
+    float out = 0.0f;
+    for (glm::length_t c = 0; c < 4; ++c) {
+        for (glm::length_t r = 0; r < 4; ++r) { out = std::max(out, std::abs(a[c][r])); }
+    }
+    return out;
+}
+
+
+bool IsNear(const glm::mat4& a, const glm::mat4& b, float tolerance) {
+    for (glm::length_t c = 0; c < 4; ++c) {
+        for (glm::length_t r = 0; r < 4; ++r) {
+            if (!(std::abs(a[c][r] - b[c][r]) <= tolerance)) { return false; }
+        }
+    }
+    return true;
+}
+
+
+CameraGpuData Read(const std::vector<std::byte>& bytes, size_t i, size_t stride) {
+    CameraGpuData data{};
+    std::memcpy(&data, bytes.data() + i * stride, sizeof(CameraGpuData));
+    return data;
+}
+
+
+// Each camera's block against Camera::View and Projection::Matrix() * view; the padding between blocks is untouched.
+void CheckUpdate(const CameraSet& set, const std::vector<Projection>& projections, size_t stride) {
+    std::vector<std::byte> bytes((set.Size() - 1) * stride + sizeof(CameraGpuData), SENTINEL);
+    set.Update(bytes, stride);
+    for (size_t i = 0; i < set.Size(); ++i) {
+        const CameraGpuData data = Read(bytes, i, stride);
+        const Camera camera{projections[i].Matrix(), set.Position(i), set.Orientation(i)};
+        // As in tests/camera.cpp, the error grows with the translation.
+        const float tolerance = 1e-5f * (1.0f + glm::length(set.Position(i)));
+        JMS_CHECK(IsNear(data.view, camera.View(), tolerance));
+        JMS_CHECK(IsNear(data.projection, projections[i].Matrix(), 1e-6f * MaxAbs(projections[i].Matrix())));
+        JMS_CHECK(IsNear(data.view_projection, projections[i].Matrix() * camera.View(),
+                         4.0f * tolerance * (1.0f + MaxAbs(projections[i].Matrix()))));
+        JMS_CHECK(data.position == glm::vec4{set.Position(i), 1.0f});
+        const std::byte* padding = bytes.data() + i * stride + sizeof(CameraGpuData);
+        const std::byte* end = bytes.data() + std::min((i + 1) * stride, bytes.size());
+        JMS_CHECK(std::all_of(padding, end, [](std::byte b) { return b == SENTINEL; }));
+    }
+}
+
+
+void TestUpdate() {
+    std::mt19937 rng{47};
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    for (size_t size : {NUM_CAMERAS, simd::WIDTH, static_cast<size_t>(1)}) {
+        CameraSet set{};
+        std::vector<Projection> projections{};
+        for (size_t i = 0; i < size; ++i) {
+            projections.push_back(MakeProjection(i));
+            const glm::vec3 p{position(rng), position(rng), position(rng)};
+            JMS_CHECK(set.Add(projections.back(), p, RandomOrientation(rng)) == i);
+        }
+        JMS_CHECK(set.Size() == size);
+        CheckUpdate(set, projections, STRIDE);
+        CheckUpdate(set, projections, sizeof(CameraGpuData));
+
+        // Changing one camera's projection type and pose shows up in the next Update.
+        const size_t last = size - 1;
+        projections[last] = MakeProjection(last + 2);
+        set.SetProjection(last, projections[last]);
+        set.SetPosition(last, glm::vec3{1.0f, -2.0f, 3.0f});
+        set.SetOrientation(last, glm::angleAxis(0.4f, glm::vec3{0.0f, 1.0f, 0.0f}));
+        CheckUpdate(set, projections, STRIDE);
+    }
+}
+
+
+void TestErrors() {
+    auto Throws = [](auto&& fn) {
+        try {
+            fn();
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    CameraSet set{};
+    // Nothing to write; any buffer will do.
+    set.Update({});
+    for (size_t i = 0; i < 3; ++i) { set.Add(MakeProjection(i), glm::vec3{0.0f}, glm::quat{1.0f, 0.0f, 0.0f, 0.0f}); }
+    std::vector<std::byte> bytes(2 * STRIDE + sizeof(CameraGpuData), SENTINEL);
+    set.Update(bytes, STRIDE);
+    JMS_CHECK(Throws([&] { set.Update(bytes, sizeof(CameraGpuData) - 16); }));
+    JMS_CHECK(Throws([&] { set.Update(std::span{bytes}.first(bytes.size() - 1), STRIDE); }));
+    JMS_CHECK(Throws([&] { set.SetPosition(3, glm::vec3{0.0f}); }));
+    JMS_CHECK(Throws([&] { set.Orientation(3); }));
+    set.Clear();
+    JMS_CHECK(set.Size() == 0);
+    set.Update({});
+}
+
+
+}
+
+
+int main() {
+    TestUpdate();
+    TestErrors();
+    return jms::tests::Result();
+}
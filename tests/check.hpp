@@ -0,0 +1,36 @@
+#pragma once
+
+
+#include <cstdio>
+#include <source_location>
+
+
+namespace jms {
+namespace tests {
+
+
+inline int failures = 0;
+
+
+// Prints the failed expression with its location; main returns Result().
+inline bool Check(bool condition, const char* expression,
+                  std::source_location location = std::source_location::current()) {
+    if (!condition) {
+        ++failures;
+        std::fprintf(stderr, "%s:%u: check failed: %s\n", location.file_name(), location.line(), expression);
+    }
+    return condition;
+}
+
+
+inline int Result() {
+    if (failures) { std::fprintf(stderr, "%d check(s) failed\n", failures); }
+    return failures ? 1 : 0;
+}
+
+
+}
+}
+
+
+#define JMS_CHECK(...) ::jms::tests::Check(static_cast<bool>(__VA_ARGS__), #__VA_ARGS__)
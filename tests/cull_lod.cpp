@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <execution>
+#include <limits>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "jms/external/glm.hpp"
+
+#include "jms/graphics/cull_lod.hpp"
+#include "jms/graphics/culling.hpp"
+#include "jms/graphics/projection.hpp"
+#include "jms/utils/executor.hpp"
+#include "check.hpp"
+
+
+using namespace jms;
+
+
+namespace {
+
+
+// Not a multiple of any chunk size; the last chunk is partial and ends in a scalar tail.
+constexpr size_t NUM_SPHERES = 3 * CullLodJob::DEFAULT_CHUNK_SIZE + 37;
+
+
+struct Scene {
+    std::vector<float> x{};
+    std::vector<float> y{};
+    std::vector<float> z{};
+    std::vector<float> radius{};
+    glm::mat4 view{1.0f};
+    glm::mat4 projection{Perspective_RH_ZO(1.0f, 1.5f, 0.1f, 200.0f)};
+    LodSettings settings{.lod_thresholds={0.2f, 0.05f, 0.01f}, .min_screen_size=0.002f};
+
+    SphereSoA Spheres() const { return {.x=x, .y=y, .z=z, .radius=radius}; }
+};
+
+
+Scene MakeScene(size_t size) {
+    Scene scene{};
+    std::mt19937 rng{3};
+    std::uniform_real_distribution<float> xy(-150.0f, 150.0f);
+    std::uniform_real_distribution<float> depth(-50.0f, 250.0f);
+    std::uniform_real_distribution<float> radius(0.01f, 5.0f);
+    for (size_t i = 0; i < size; ++i) {
+        scene.x.push_back(xy(rng));
+        scene.y.push_back(xy(rng));
+        scene.z.push_back(depth(rng));
+        scene.radius.push_back(radius(rng));
+    }
+    // Moves the spheres 10 along -z in view space.
+    scene.view[3][2] = -10.0f;
+    return scene;
+}
+
+
+struct Result {
+    std::vector<uint32_t> visible{};
+    std::vector<uint8_t> lods{};
+};
+
+
+// Serial pass: one CullSpheres over everything then the per sphere screen size and LOD in order.
+Result SerialPass(const Scene& scene) {
+    const SphereSoA spheres = scene.Spheres();
+    std::vector<uint32_t> culled(spheres.Size());
+    culled.resize(CullSpheres(ExtractFrustum(scene.projection * scene.view), spheres, culled));
+    Result out{};
+    for (uint32_t i : culled) {
+        const float depth = scene.view[0][2] * spheres.x[i] + scene.view[1][2] * spheres.y[i] +
+                            scene.view[2][2] * spheres.z[i] + scene.view[3][2];
+        const float screen_size = CullLodJob::ScreenSize(spheres.radius[i], depth, scene.projection[1][1]);
+        if (screen_size < scene.settings.min_screen_size) { continue; }
+        out.visible.push_back(i);
+        out.lods.push_back(CullLodJob::SelectLod(screen_size, scene.settings.lod_thresholds));
+    }
+    return out;
+}
+
+
+template <typename Executor_t>
+bool IsSameAsSerial(Executor_t&& executor, size_t chunk_size, const Scene& scene, const Result& expected) {
+    CullLodJob job{chunk_size};
+    const size_t count = job.Run(executor, scene.Spheres(), scene.view, scene.projection, scene.settings);
+    // A second run reuses the scratch arrays.
+    const size_t count_again = job.Run(executor, scene.Spheres(), scene.view, scene.projection, scene.settings);
+    return count == expected.visible.size() && count_again == count &&
+           std::ranges::equal(job.Visible(), expected.visible) && std::ranges::equal(job.Lods(), expected.lods);
+}
+
+
+void TestMatchesSerial() {
+    const Scene scene = MakeScene(NUM_SPHERES);
+    const Result expected = SerialPass(scene);
+    // Enough of each outcome for the comparison to mean something.
+    JMS_CHECK(expected.visible.size() > NUM_SPHERES / 10 && expected.visible.size() < NUM_SPHERES / 2);
+    JMS_CHECK(std::ranges::count(expected.lods, 0) > 0 && std::ranges::count(expected.lods, 3) > 0);
+
+    for (size_t chunk_size : {CullLodJob::DEFAULT_CHUNK_SIZE, static_cast<size_t>(100), NUM_SPHERES * 2}) {
+        ThreadPool single{1};
+        ThreadPool pool{4};
+        JMS_CHECK(IsSameAsSerial(single, chunk_size, scene, expected));
+        JMS_CHECK(IsSameAsSerial(pool, chunk_size, scene, expected));
+        JMS_CHECK(IsSameAsSerial(std::execution::par, chunk_size, scene, expected));
+        JMS_CHECK(IsSameAsSerial(std::execution::seq, chunk_size, scene, expected));
+    }
+}
+
+
+void TestEmpty() {
+    const Scene scene = MakeScene(0);
+    ThreadPool pool{2};
+    CullLodJob job{};
+    JMS_CHECK(job.Run(pool, scene.Spheres(), scene.view, scene.projection, scene.settings) == 0);
+    JMS_CHECK(job.Visible().empty() && job.Lods().empty());
+}
+
+
+void TestSelectLod() {
+    const std::vector<float> thresholds{0.2f, 0.05f, 0.01f};
+    JMS_CHECK(CullLodJob::SelectLod(0.5f, thresholds) == 0);
+    JMS_CHECK(CullLodJob::SelectLod(0.2f, thresholds) == 0);
+    JMS_CHECK(CullLodJob::SelectLod(0.1f, thresholds) == 1);
+    JMS_CHECK(CullLodJob::SelectLod(0.01f, thresholds) == 2);
+    JMS_CHECK(CullLodJob::SelectLod(0.001f, thresholds) == 3);
+    JMS_CHECK(CullLodJob::ScreenSize(1.0f, 0.5f, 1.0f) == std::numeric_limits<float>::infinity());
+}
+
+
+}
+
+
+int main() {
+    TestMatchesSerial();
+    TestEmpty();
+    TestSelectLod();
+    return jms::tests::Result();
+}
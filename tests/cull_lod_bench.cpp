@@ -0,0 +1,74 @@
+#include <chrono>
+#include <cstdio>
+#include <execution>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "jms/external/glm.hpp"
+
+#include "jms/graphics/cull_lod.hpp"
+#include "jms/graphics/culling.hpp"
+#include "jms/graphics/projection.hpp"
+#include "jms/utils/executor.hpp"
+
+
+using namespace jms;
+
+
+namespace {
+
+
+constexpr size_t NUM_SPHERES = 1'000'000;
+constexpr int NUM_RUNS = 20;
+
+
+template <typename Executor_t>
+double MillisecondsPerRun(Executor_t&& executor, CullLodJob& job, const SphereSoA& spheres, const glm::mat4& view,
+                          const glm::mat4& projection, const LodSettings& settings) {
+    size_t checksum = job.Run(executor, spheres, view, projection, settings);
+    auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < NUM_RUNS; ++run) { checksum += job.Run(executor, spheres, view, projection, settings); }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    if (checksum == 0) { std::printf("nothing visible\n"); }
+    return elapsed.count() / NUM_RUNS;
+}
+
+
+}
+
+
+// CullLodJob::Run on 1M spheres with a ThreadPool of 1 to 32 threads, plus the standard execution policies.
+int main() {
+    std::mt19937 rng{5};
+    std::uniform_real_distribution<float> xy(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> depth(-100.0f, 1000.0f);
+    std::uniform_real_distribution<float> radius(0.1f, 10.0f);
+    std::vector<float> x(NUM_SPHERES), y(NUM_SPHERES), z(NUM_SPHERES), r(NUM_SPHERES);
+    for (size_t i = 0; i < NUM_SPHERES; ++i) {
+        x[i] = xy(rng);
+        y[i] = xy(rng);
+        z[i] = depth(rng);
+        r[i] = radius(rng);
+    }
+    const SphereSoA spheres{.x=x, .y=y, .z=z, .radius=r};
+    const glm::mat4 view{1.0f};
+    const glm::mat4 projection = Perspective_RH_ZO(1.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+    const LodSettings settings{.lod_thresholds={0.2f, 0.05f, 0.01f}, .min_screen_size=0.001f};
+    CullLodJob job{};
+
+    std::printf("%zu spheres, chunk %zu, %u hardware threads\n", NUM_SPHERES, job.ChunkSize(),
+                std::thread::hardware_concurrency());
+    double single = 0.0;
+    for (size_t num_threads : {1, 2, 4, 8, 16, 32}) {
+        ThreadPool pool{num_threads};
+        const double ms = MillisecondsPerRun(pool, job, spheres, view, projection, settings);
+        if (num_threads == 1) { single = ms; }
+        std::printf("ThreadPool %2zu threads   %8.3f ms   %5.2fx\n", num_threads, ms, single / ms);
+    }
+    const double seq = MillisecondsPerRun(std::execution::seq, job, spheres, view, projection, settings);
+    std::printf("std::execution::seq      %8.3f ms   %5.2fx\n", seq, single / seq);
+    const double par = MillisecondsPerRun(std::execution::par, job, spheres, view, projection, settings);
+    std::printf("std::execution::par      %8.3f ms   %5.2fx\n", par, single / par);
+    return 0;
+}
@@ -0,0 +1,316 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "jms/external/glm.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "jms/graphics/culling.hpp"
+#include "jms/graphics/projection.hpp"
+#include "jms/utils/simd.hpp"
+#include "check.hpp"
+
+
+using namespace jms;
+
+
+namespace {
+
+
+// Not a multiple of simd::WIDTH so the scalar tail runs too.
+constexpr size_t NUM_OBJECTS = 256 * simd::WIDTH + 5;
+constexpr float FOVY = 1.0f;
+constexpr float ASPECT_RATIO = 1.5f;
+constexpr float NEAR = 0.5f;
+constexpr float FAR = 60.0f;
+
+
+struct Case {
+    std::string_view name{};
+    glm::mat4 projection{};
+    bool has_far_plane{false};
+};
+
+
+std::vector<Case> Cases() {
+    return {
+        {"ZO", Perspective_RH_ZO(FOVY, ASPECT_RATIO, NEAR, FAR), true},
+        {"OZ", Perspective_RH_OZ(FOVY, ASPECT_RATIO, NEAR, FAR), true},
+        {"ZI", Perspective_RH_ZI(FOVY, ASPECT_RATIO, NEAR), false},
+        {"ZI epsilon 0", Perspective_RH_ZI(FOVY, ASPECT_RATIO, NEAR, 0.0f), false},
+        {"OI", Perspective_RH_OI(FOVY, ASPECT_RATIO, NEAR), false},
+        {"OI epsilon 0", Perspective_RH_OI(FOVY, ASPECT_RATIO, NEAR, 0.0f), false}
+    };
+}
+
+
+glm::mat4 View() {
+    glm::mat4 view = glm::translate(glm::mat4{1.0f}, glm::vec3{3.0f, -2.0f, 5.0f});
+    view = glm::rotate(view, 0.7f, glm::vec3{0.0f, 1.0f, 0.0f});
+    return glm::rotate(view, -0.3f, glm::vec3{1.0f, 0.0f, 0.0f});
+}
+
+
+/***
+ * The Vulkan clip volume -w <= x <= w, -w <= y <= w, 0 <= z <= w written as 6 linear functions of the world space
+ * point, in double and straight from the matrix rows.  Scaled to unit normals they are signed distances.  A zero
+ * normal (the far side of an infinite projection) is a constant that never culls and is left out.
+ */
+struct ClipPlane {
+    std::array<double, 3> normal{};
+    double d{0.0};
+
+    double Distance(const glm::vec3& p) const noexcept {
+        return normal[0] * p.x + normal[1] * p.y + normal[2] * p.z + d;
+    }
+};
+
+
+std::vector<ClipPlane> ClipPlanes(const glm::mat4& m) {
+    auto Row = [&m](glm::length_t r) {
+        return std::array<double, 4>{m[0][r], m[1][r], m[2][r], m[3][r]};
+    };
+    const auto x = Row(0);
+    const auto y = Row(1);
+    const auto z = Row(2);
+    const auto w = Row(3);
+    std::vector<ClipPlane> out{};
+    auto Add = [&out](std::array<double, 4> f) {
+        const double length = std::sqrt(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+        // An epsilon variant's far side has a normal around 1e-7 of the others; a plane that far behind the camera
+        // only matters for objects already behind the near plane.
+        if (length < 1e-4) { return; }
+        out.push_back({.normal={f[0] / length, f[1] / length, f[2] / length}, .d=f[3] / length});
+    };
+    auto Combine = [](const std::array<double, 4>& a, double sa, const std::array<double, 4>& b, double sb) {
+        return std::array<double, 4>{sa * a[0] + sb * b[0], sa * a[1] + sb * b[1], sa * a[2] + sb * b[2],
+                                     sa * a[3] + sb * b[3]};
+    };
+    Add(Combine(w, 1.0, x, 1.0));
+    Add(Combine(w, 1.0, x, -1.0));
+    Add(Combine(w, 1.0, y, 1.0));
+    Add(Combine(w, 1.0, y, -1.0));
+    Add(z);
+    Add(Combine(w, 1.0, z, -1.0));
+    return out;
+}
+
+
+bool IsPointInClipVolume(const glm::mat4& m, const glm::vec3& p) {
+    const glm::vec4 c = m * glm::vec4{p, 1.0f};
+    return -c.w <= c.x && c.x <= c.w && -c.w <= c.y && c.y <= c.w && 0.0f <= c.z && c.z <= c.w;
+}
+
+
+struct Objects {
+    std::vector<float> x{};
+    std::vector<float> y{};
+    std::vector<float> z{};
+    std::vector<float> radius{};
+    std::vector<float> extent_x{};
+    std::vector<float> extent_y{};
+    std::vector<float> extent_z{};
+
+    void Add(const glm::vec3& center, float r, const glm::vec3& extent) {
+        x.push_back(center.x);
+        y.push_back(center.y);
+        z.push_back(center.z);
+        radius.push_back(r);
+        extent_x.push_back(extent.x);
+        extent_y.push_back(extent.y);
+        extent_z.push_back(extent.z);
+    }
+
+    size_t Size() const noexcept { return x.size(); }
+    glm::vec3 Center(size_t i) const { return {x[i], y[i], z[i]}; }
+    glm::vec3 Extent(size_t i) const { return {extent_x[i], extent_y[i], extent_z[i]}; }
+    SphereSoA Spheres() const { return {.x=x, .y=y, .z=z, .radius=radius}; }
+    AabbSoA Aabbs() const {
+        return {.center_x=x, .center_y=y, .center_z=z, .extent_x=extent_x, .extent_y=extent_y, .extent_z=extent_z};
+    }
+};
+
+
+/***
+ * Objects just inside and just outside each plane, starting from random points inside the frustum and moved along
+ * the plane normal, plus random ones anywhere around it including behind the camera.  The first objects are points
+ * (radius and extents 0).
+ */
+Objects MakeObjects(const glm::mat4& view, const std::vector<ClipPlane>& planes, size_t size) {
+    std::mt19937 rng{29};
+    std::uniform_real_distribution<float> unit(-0.8f, 0.8f);
+    std::uniform_real_distribution<float> depth(2.0f * NEAR, 0.8f * FAR);
+    std::uniform_real_distribution<float> around(-80.0f, 80.0f);
+    std::uniform_real_distribution<float> size_distribution(0.0f, 2.0f);
+    std::uniform_real_distribution<float> margin(0.01f, 0.5f);
+    const glm::mat4 inverse_view = glm::inverse(view);
+    const float tan_half = std::tan(FOVY / 2.0f);
+
+    Objects out{};
+    for (size_t i = 0; i < size; ++i) {
+        const bool is_point = i < size / 4;
+        const float r = is_point ? 0.0f : size_distribution(rng);
+        const glm::vec3 extent = is_point ? glm::vec3{0.0f} :
+                                            glm::vec3{size_distribution(rng), size_distribution(rng),
+                                                      size_distribution(rng)};
+        if (i % 3 == 2) {
+            out.Add(glm::vec3{around(rng), around(rng), around(rng)}, r, extent);
+            continue;
+        }
+        // View space +z is forward.
+        const float vz = depth(rng);
+        const glm::vec3 inside{inverse_view * glm::vec4{unit(rng) * vz * tan_half * ASPECT_RATIO,
+                                                        unit(rng) * vz * tan_half, vz, 1.0f}};
+        const ClipPlane& plane = planes[i % planes.size()];
+        // Sphere distance -r +- margin from the plane; outside when negative.
+        const float sign = (i % 2) ? 1.0f : -1.0f;
+        const double target = -static_cast<double>(r) + sign * margin(rng);
+        const double move = target - plane.Distance(inside);
+        const glm::vec3 normal{static_cast<float>(plane.normal[0]), static_cast<float>(plane.normal[1]),
+                               static_cast<float>(plane.normal[2])};
+        out.Add(inside + normal * static_cast<float>(move), r, extent);
+    }
+    return out;
+}
+
+
+// Reference answers; EITHER when float rounding could go either way.
+enum class Expected {
+    VISIBLE,
+    CULLED,
+    EITHER
+};
+
+
+Expected ExpectedForDistances(const std::vector<double>& margins) {
+    const double min_margin = *std::ranges::min_element(margins);
+    if (std::abs(min_margin) < 1e-3) { return Expected::EITHER; }
+    return (min_margin >= 0.0) ? Expected::VISIBLE : Expected::CULLED;
+}
+
+
+Expected ExpectedSphere(const std::vector<ClipPlane>& planes, const glm::vec3& center, float r) {
+    std::vector<double> margins{};
+    for (const ClipPlane& plane : planes) { margins.push_back(plane.Distance(center) + r); }
+    return ExpectedForDistances(margins);
+}
+
+
+Expected ExpectedAabb(const std::vector<ClipPlane>& planes, const glm::vec3& center, const glm::vec3& extent) {
+    std::vector<double> margins{};
+    for (const ClipPlane& plane : planes) {
+        const double radius = std::abs(plane.normal[0]) * extent.x + std::abs(plane.normal[1]) * extent.y +
+                              std::abs(plane.normal[2]) * extent.z;
+        margins.push_back(plane.Distance(center) + radius);
+    }
+    return ExpectedForDistances(margins);
+}
+
+
+// visible holds increasing indices; every object in [begin, end) is compared with its reference answer.
+template <typename ExpectedF>
+bool MatchesReference(std::span<const uint32_t> visible, size_t begin, size_t end, ExpectedF&& ExpectedFn,
+                      size_t& num_visible, size_t& num_culled) {
+    if (!std::ranges::is_sorted(visible) || std::ranges::adjacent_find(visible) != visible.end()) { return false; }
+    auto it = visible.begin();
+    for (size_t i = begin; i < end; ++i) {
+        const bool is_visible = (it != visible.end() && *it == i);
+        if (is_visible) { ++it; }
+        switch (ExpectedFn(i)) {
+        case Expected::VISIBLE:
+            if (!is_visible) { return false; }
+            ++num_visible;
+            break;
+        case Expected::CULLED:
+            if (is_visible) { return false; }
+            ++num_culled;
+            break;
+        case Expected::EITHER:
+            break;
+        }
+    }
+    return it == visible.end();
+}
+
+
+void TestCase(const Case& c) {
+    const glm::mat4 view = View();
+    const glm::mat4 m = c.projection * view;
+    const Frustum frustum = ExtractFrustum(m);
+    const std::vector<ClipPlane> planes = ClipPlanes(m);
+    JMS_CHECK(frustum.has_far_plane == c.has_far_plane);
+    JMS_CHECK(frustum.num_planes == (c.has_far_plane ? 6 : 5));
+    JMS_CHECK(planes.size() == frustum.num_planes);
+
+    const Objects objects = MakeObjects(view, planes, NUM_OBJECTS);
+    const SphereSoA spheres = objects.Spheres();
+    const AabbSoA aabbs = objects.Aabbs();
+    std::vector<uint32_t> visible(NUM_OBJECTS);
+
+    // Points straight against the clip volume; only those clearly inside or outside.
+    size_t num_points = 0;
+    for (size_t i = 0; i < NUM_OBJECTS && objects.radius[i] == 0.0f && objects.extent_x[i] == 0.0f; ++i) {
+        if (ExpectedSphere(planes, objects.Center(i), 0.0f) == Expected::EITHER) { continue; }
+        ++num_points;
+        JMS_CHECK(frustum.TestSphere(objects.Center(i), 0.0f) == IsPointInClipVolume(m, objects.Center(i)));
+        JMS_CHECK(frustum.TestAabb(objects.Center(i), glm::vec3{0.0f}) == IsPointInClipVolume(m, objects.Center(i)));
+    }
+    JMS_CHECK(num_points > NUM_OBJECTS / 8);
+
+    auto ExpectedSphereFn = [&](size_t i) { return ExpectedSphere(planes, objects.Center(i), objects.radius[i]); };
+    auto ExpectedAabbFn = [&](size_t i) { return ExpectedAabb(planes, objects.Center(i), objects.Extent(i)); };
+    // The whole range, then one starting and ending off a SIMD boundary.
+    for (auto [begin, end] : {std::pair<size_t, size_t>{0, NUM_OBJECTS}, {3, NUM_OBJECTS - simd::WIDTH - 1}}) {
+        size_t num_visible = 0;
+        size_t num_culled = 0;
+        size_t count = CullSpheres(frustum, spheres, begin, end, visible);
+        JMS_CHECK(MatchesReference(std::span{visible}.first(count), begin, end, ExpectedSphereFn, num_visible,
+                                   num_culled));
+        JMS_CHECK(num_visible > (end - begin) / 5 && num_culled > (end - begin) / 5);
+
+        num_visible = 0;
+        num_culled = 0;
+        count = CullAabbs(frustum, aabbs, begin, end, visible);
+        JMS_CHECK(MatchesReference(std::span{visible}.first(count), begin, end, ExpectedAabbFn, num_visible,
+                                   num_culled));
+        JMS_CHECK(num_visible > (end - begin) / 5 && num_culled > (end - begin) / 5);
+    }
+}
+
+
+void TestRange() {
+    const Frustum frustum = ExtractFrustum(Perspective_RH_ZO(FOVY, ASPECT_RATIO, NEAR, FAR));
+    const std::vector<float> values(10, 1.0f);
+    const SphereSoA spheres{.x=values, .y=values, .z=values, .radius=values};
+    std::vector<uint32_t> visible(10);
+    auto Throws = [](auto&& fn) {
+        try {
+            fn();
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    JMS_CHECK(Throws([&] { CullSpheres(frustum, spheres, 4, 11, visible); }));
+    JMS_CHECK(Throws([&] { CullSpheres(frustum, spheres, 5, 4, visible); }));
+    JMS_CHECK(Throws([&] { CullSpheres(frustum, spheres, 0, 10, std::span{visible}.first(9)); }));
+    JMS_CHECK(CullSpheres(frustum, spheres, 4, 4, visible) == 0);
+}
+
+
+}
+
+
+int main() {
+    for (const Case& c : Cases()) { TestCase(c); }
+    TestRange();
+    return jms::tests::Result();
+}
@@ -0,0 +1,66 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "jms/external/glm.hpp"
+
+#include "jms/graphics/culling.hpp"
+#include "jms/graphics/projection.hpp"
+#include "jms/utils/simd.hpp"
+
+
+using namespace jms;
+
+
+namespace {
+
+
+constexpr size_t NUM_OBJECTS = 1'000'000;
+constexpr int NUM_RUNS = 50;
+
+
+template <typename Cull_t>
+double ObjectsPerSecond(Cull_t&& cull) {
+    size_t checksum = cull();
+    auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < NUM_RUNS; ++run) { checksum += cull(); }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (checksum == 0) { std::printf("nothing visible\n"); }
+    return static_cast<double>(NUM_OBJECTS) * NUM_RUNS / elapsed.count();
+}
+
+
+}
+
+
+// CullSpheres and CullAabbs on 1M objects on one thread, with a finite (6 plane) and an infinite (5 plane) frustum.
+int main() {
+    std::mt19937 rng{5};
+    std::uniform_real_distribution<float> xy(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> depth(-100.0f, 1000.0f);
+    std::uniform_real_distribution<float> radius(0.1f, 10.0f);
+    std::vector<float> x(NUM_OBJECTS), y(NUM_OBJECTS), z(NUM_OBJECTS), r(NUM_OBJECTS);
+    for (size_t i = 0; i < NUM_OBJECTS; ++i) {
+        x[i] = xy(rng);
+        y[i] = xy(rng);
+        z[i] = depth(rng);
+        r[i] = radius(rng);
+    }
+    const SphereSoA spheres{.x=x, .y=y, .z=z, .radius=r};
+    const AabbSoA aabbs{.center_x=x, .center_y=y, .center_z=z, .extent_x=r, .extent_y=r, .extent_z=r};
+    std::vector<uint32_t> visible(NUM_OBJECTS);
+
+    std::printf("%zu objects, simd width %zu\n", NUM_OBJECTS, simd::WIDTH);
+    const Frustum finite = ExtractFrustum(Perspective_RH_ZO(1.0f, 16.0f / 9.0f, 0.1f, 1000.0f));
+    const Frustum infinite = ExtractFrustum(Perspective_RH_OI(1.0f, 16.0f / 9.0f, 0.1f));
+    for (const Frustum* frustum : {&finite, &infinite}) {
+        const double sphere_rate = ObjectsPerSecond([&] { return CullSpheres(*frustum, spheres, visible); });
+        const double aabb_rate = ObjectsPerSecond([&] { return CullAabbs(*frustum, aabbs, visible); });
+        std::printf("%zu planes   CullSpheres %8.3f G/s   CullAabbs %8.3f G/s\n", frustum->num_planes,
+                    sphere_rate * 1e-9, aabb_rate * 1e-9);
+    }
+    return 0;
+}
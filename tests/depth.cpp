@@ -0,0 +1,135 @@
+#include <cmath>
+#include <optional>
+#include <vector>
+
+#include "jms/graphics/depth_precision.hpp"
+#include "jms/graphics/projection.hpp"
+#include "jms/vulkan/depth.hpp"
+#include "jms/vulkan/graphics_rendering_state.hpp"
+#include "check.hpp"
+
+
+using namespace jms;
+using namespace jms::vulkan;
+
+
+namespace {
+
+
+constexpr float FOVY = 1.0f;
+constexpr float ASPECT_RATIO = 1.5f;
+constexpr float NEAR = 0.1f;
+constexpr float FAR = 100.0f;
+
+
+// Reversed-Z keeps greater depth and clears to 0; the others keep less and clear to 1.
+void TestMakeDepthSetup() {
+    const Projection projections[] = {
+        Projection::Perspective_RH_ZO(FOVY, ASPECT_RATIO, NEAR, FAR),
+        Projection::Perspective_RH_OZ(FOVY, ASPECT_RATIO, NEAR, FAR),
+        Projection::Perspective_RH_ZI(FOVY, ASPECT_RATIO, NEAR),
+        Projection::Perspective_RH_OI(FOVY, ASPECT_RATIO, NEAR),
+        Projection::Orthographic_RH(-1.0f, 1.0f, -1.0f, 1.0f, NEAR, FAR, true)
+    };
+    for (const Projection& projection : projections) {
+        const DepthSetup setup = MakeDepthSetup(projection);
+        JMS_CHECK(setup.format == vk::Format::eD32Sfloat);
+        if (projection.is_reversed_z) {
+            JMS_CHECK(setup.compare_op == vk::CompareOp::eGreater && setup.clear_depth == 0.0f);
+        } else {
+            JMS_CHECK(setup.compare_op == vk::CompareOp::eLess && setup.clear_depth == 1.0f);
+        }
+        // Clearing to the setup's value then drawing at near passes the compare op.
+        const float near_depth = projection.Depth(projection.near);
+        JMS_CHECK(projection.is_reversed_z ? near_depth > setup.clear_depth : near_depth < setup.clear_depth);
+    }
+    JMS_CHECK(MakeDepthSetup(projections[1], vk::Format::eD16Unorm).format == vk::Format::eD16Unorm);
+}
+
+
+void TestApplyDepthSetup() {
+    const DepthSetup reversed = MakeDepthSetup(Projection::Perspective_RH_OI(FOVY, ASPECT_RATIO, NEAR));
+    GraphicsRenderingState state{};
+    ApplyDepthSetup(state, reversed);
+    JMS_CHECK(state.depth_attachment.has_value());
+    JMS_CHECK(state.depth_attachment->imageLayout == vk::ImageLayout::eDepthAttachmentOptimal);
+    JMS_CHECK(state.depth_attachment->loadOp == vk::AttachmentLoadOp::eClear);
+    JMS_CHECK(state.depth_attachment->storeOp == vk::AttachmentStoreOp::eDontCare);
+    JMS_CHECK(state.depth_attachment->clearValue.depthStencil.depth == 0.0f);
+    JMS_CHECK(state.depth_test_enabled && state.depth_write_enabled);
+    JMS_CHECK(state.depth_compare_op == vk::CompareOp::eGreater);
+
+    // An existing attachment keeps its ops; only the clear value changes.
+    state.depth_attachment->loadOp = vk::AttachmentLoadOp::eLoad;
+    state.depth_attachment->storeOp = vk::AttachmentStoreOp::eStore;
+    ApplyDepthSetup(state, MakeDepthSetup(Projection::Perspective_RH_ZO(FOVY, ASPECT_RATIO, NEAR, FAR)));
+    JMS_CHECK(state.depth_attachment->loadOp == vk::AttachmentLoadOp::eLoad);
+    JMS_CHECK(state.depth_attachment->storeOp == vk::AttachmentStoreOp::eStore);
+    JMS_CHECK(state.depth_attachment->clearValue.depthStencil.depth == 1.0f);
+    JMS_CHECK(state.depth_compare_op == vk::CompareOp::eLess);
+}
+
+
+void TestDepthFormats() {
+    JMS_CHECK(DepthFormats(DepthEncoding::FLOAT32, false) == std::vector<vk::Format>{vk::Format::eD32Sfloat});
+    JMS_CHECK(DepthFormats(DepthEncoding::FLOAT32, true) == std::vector<vk::Format>{vk::Format::eD32SfloatS8Uint});
+    JMS_CHECK(DepthFormats(DepthEncoding::UNORM24, false).front() == vk::Format::eX8D24UnormPack32);
+    JMS_CHECK(DepthFormats(DepthEncoding::UNORM16, true) == std::vector<vk::Format>{vk::Format::eD16UnormS8Uint});
+}
+
+
+double RelativeStep(const Projection& projection, DepthEncoding encoding, float distance) {
+    return AnalyzeDepthPrecision(projection, encoding, distance).step / distance;
+}
+
+
+void TestDepthPrecision() {
+    // D32 with reversed infinite Z and epsilon 0 stores near / z; one float step is 2^-24 to 2^-23 of the distance
+    // everywhere.
+    const Projection oi = Projection::Perspective_RH_OI(FOVY, ASPECT_RATIO, NEAR, 0.0f);
+    const std::vector<float> distances{0.2f, 1.0f, 10.0f, 1e3f, 1e5f};
+    for (const DepthPrecisionSample& sample : AnalyzeDepthPrecision(oi, DepthEncoding::FLOAT32, distances)) {
+        JMS_CHECK(sample.step >= 0x1p-25 * sample.distance && sample.step <= 0x1p-22 * sample.distance);
+        JMS_CHECK(sample.error <= 1e-6 * sample.distance);
+    }
+    // Forward infinite Z loses it with distance: depth crowds under 1 where float steps are coarsest.
+    const Projection zi = Projection::Perspective_RH_ZI(FOVY, ASPECT_RATIO, NEAR);
+    JMS_CHECK(RelativeStep(zi, DepthEncoding::FLOAT32, 1e4f) > 1000.0 * RelativeStep(oi, DepthEncoding::FLOAT32, 1e4f));
+
+    // UNORM with a finite projection: a step of one in 2^24 - 1 is z^2 (far - near) / (far near (2^24 - 1)).
+    const Projection zo = Projection::Perspective_RH_ZO(FOVY, ASPECT_RATIO, NEAR, FAR);
+    for (float distance : {1.0f, 10.0f, 50.0f}) {
+        const double expected = static_cast<double>(distance) * distance * (FAR - NEAR) / (FAR * NEAR * 16777215.0);
+        const double step = AnalyzeDepthPrecision(zo, DepthEncoding::UNORM24, distance).step;
+        JMS_CHECK(std::abs(step - expected) <= 0.02 * expected);
+    }
+    // Past far depth clamps to 1 and there is no next value.
+    JMS_CHECK(std::isinf(AnalyzeDepthPrecision(zo, DepthEncoding::UNORM16, 2.0f * FAR).step));
+}
+
+
+void TestSelectDepthEncoding() {
+    // Finite near 1, far 100: at 90 a UNORM16 step is about 1.4e-3 of the distance and a UNORM24 one 5e-6.
+    const Projection zo = Projection::Perspective_RH_ZO(FOVY, ASPECT_RATIO, 1.0f, 100.0f);
+    const std::vector<float> finite{1.0f, 10.0f, 90.0f};
+    JMS_CHECK(SelectDepthEncoding(zo, finite, 2e-3) == DepthEncoding::UNORM16);
+    JMS_CHECK(SelectDepthEncoding(zo, finite, 1e-3) == DepthEncoding::UNORM24);
+    // Reversed infinite: at 1000 depth is 1e-4, where UNORM24 steps are 6e-4 of the distance and float ones 1e-7.
+    const Projection oi = Projection::Perspective_RH_OI(FOVY, ASPECT_RATIO, NEAR, 0.0f);
+    const std::vector<float> infinite{1.0f, 1e3f, 1e5f};
+    JMS_CHECK(SelectDepthEncoding(oi, infinite, 1e-5) == DepthEncoding::FLOAT32);
+    JMS_CHECK(!SelectDepthEncoding(oi, infinite, 1e-9).has_value());
+}
+
+
+}
+
+
+int main() {
+    TestMakeDepthSetup();
+    TestApplyDepthSetup();
+    TestDepthFormats();
+    TestDepthPrecision();
+    TestSelectDepthEncoding();
+    return jms::tests::Result();
+}
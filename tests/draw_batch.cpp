@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "jms/vulkan/draw_batch.hpp"
+#include "check.hpp"
+
+
+using namespace jms::vulkan;
+
+
+namespace {
+
+
+// instance_count carries the input position so stability is visible after sorting.
+std::vector<DrawItem> MakeItems(size_t size, uint64_t shader_mod, uint64_t material_mod, uint64_t mesh_mod) {
+    std::mt19937 rng{21};
+    std::vector<DrawItem> items(size);
+    for (size_t i = 0; i < size; ++i) {
+        items[i].key = MakeDrawKey(rng() % shader_mod, rng() % material_mod, rng() % mesh_mod);
+        items[i].index_count = 3;
+        items[i].instance_count = static_cast<uint32_t>(i + 1);
+    }
+    return items;
+}
+
+
+bool IsStableSorted(const std::vector<DrawItem>& sorted, std::vector<DrawItem> expected) {
+    std::ranges::stable_sort(expected, {}, &DrawItem::key);
+    return std::ranges::equal(sorted, expected, [](const DrawItem& a, const DrawItem& b) {
+        return a.key == b.key && a.instance_count == b.instance_count;
+    });
+}
+
+
+void TestSort() {
+    // Few distinct keys so there are long runs of equal keys.
+    for (size_t size : {0, 1, 2, 1000}) {
+        const std::vector<DrawItem> input = MakeItems(size, 3, 5, 7);
+        std::vector<DrawItem> items = input;
+        std::vector<DrawItem> scratch{};
+        RadixSortDrawItems(items, scratch);
+        JMS_CHECK(IsStableSorted(items, input));
+    }
+    // Every byte of the key varies.
+    std::vector<DrawItem> input = MakeItems(5000, 1u << 16, 1u << 24, 1u << 24);
+    std::vector<DrawItem> items = input;
+    std::vector<DrawItem> scratch{};
+    RadixSortDrawItems(items, scratch);
+    JMS_CHECK(IsStableSorted(items, input));
+}
+
+
+/***
+ * Each pass that runs swaps items with scratch.  With scratch preallocated the buffers never reallocate, so the
+ * parity of the passes run shows in which buffer the result ends up, and scratch keeps its sentinel only when no pass
+ * ran.  Without skipping all 8 passes would run: even parity and scratch overwritten.
+ */
+struct Passes {
+    bool is_odd{false};
+    bool is_none{false};
+};
+
+
+Passes SortPasses(std::vector<DrawItem> items) {
+    const std::vector<DrawItem> input = items;
+    std::vector<DrawItem> scratch(items.size(), DrawItem{.key=~uint64_t{0}});
+    const DrawItem* items_data = items.data();
+    RadixSortDrawItems(items, scratch);
+    JMS_CHECK(IsStableSorted(items, input));
+    return {.is_odd=(items.data() != items_data),
+            .is_none=std::ranges::all_of(scratch, [](const DrawItem& item) { return item.key == ~uint64_t{0}; })};
+}
+
+
+void TestSkippedPasses() {
+    // Constant keys: no pass.
+    std::vector<DrawItem> items = MakeItems(100, 1, 1, 1);
+    for (DrawItem& item : items) { item.key = MakeDrawKey(7, 300, 5); }
+    const Passes constant = SortPasses(items);
+    JMS_CHECK(!constant.is_odd && constant.is_none);
+    // One varying byte: one pass.
+    const Passes one = SortPasses(MakeItems(100, 1, 1, 256));
+    JMS_CHECK(one.is_odd && !one.is_none);
+    // Two varying shader bytes and one varying mesh byte around constant material bytes: three passes.
+    items = MakeItems(100, 1u << 16, 1, 256);
+    for (DrawItem& item : items) { item.key |= MakeDrawKey(0, 0x123456, 0); }
+    const Passes three = SortPasses(items);
+    JMS_CHECK(three.is_odd && !three.is_none);
+}
+
+
+DrawItem Item(uint64_t key, uint32_t first_index, uint32_t first_instance, uint32_t instance_count) {
+    return {.key=key, .index_count=36, .first_index=first_index, .vertex_offset=0, .instance_count=instance_count,
+            .first_instance=first_instance};
+}
+
+
+void TestMerge() {
+    const uint64_t a = MakeDrawKey(1, 1, 1);
+    const uint64_t b = MakeDrawKey(1, 1, 2);
+    const uint64_t c = MakeDrawKey(1, 2, 1);
+    const std::vector<DrawItem> items{
+        // Contiguous instances of one mesh: one command with 6 instances.
+        Item(a, 0, 0, 1), Item(a, 0, 1, 2), Item(a, 0, 3, 3),
+        // A gap in the instances: a new command.
+        Item(a, 0, 10, 1),
+        // Another mesh with the same material: same batch under the default mask.
+        Item(b, 36, 11, 1),
+        // Skipped.
+        Item(b, 36, 12, 0),
+        // Another material: new batch.
+        Item(c, 0, 12, 2)
+    };
+    std::vector<vk::DrawIndexedIndirectCommand> commands{};
+    const std::vector<DrawBatch> batches = MergeDrawItems(items, commands);
+    JMS_CHECK(commands.size() == 4);
+    JMS_CHECK(commands[0].instanceCount == 6 && commands[0].firstInstance == 0 && commands[0].indexCount == 36);
+    JMS_CHECK(commands[1].instanceCount == 1 && commands[1].firstInstance == 10);
+    JMS_CHECK(commands[2].firstIndex == 36 && commands[2].firstInstance == 11);
+    JMS_CHECK(commands[3].instanceCount == 2 && commands[3].firstInstance == 12);
+    JMS_CHECK(batches.size() == 2);
+    JMS_CHECK(batches[0].state_key == (a & DRAW_KEY_STATE_MASK) && batches[0].first_command == 0 &&
+              batches[0].command_count == 3);
+    JMS_CHECK(batches[1].state_key == (c & DRAW_KEY_STATE_MASK) && batches[1].first_command == 3 &&
+              batches[1].command_count == 1);
+
+    // With the mesh bits as state, the second mesh starts its own batch.
+    const std::vector<DrawBatch> mesh_batches = MergeDrawItems(items, commands, DRAW_KEY_MESH_STATE_MASK);
+    JMS_CHECK(commands.size() == 4);
+    JMS_CHECK(mesh_batches.size() == 3);
+    JMS_CHECK(mesh_batches[0].state_key == a && mesh_batches[0].command_count == 2);
+    JMS_CHECK(mesh_batches[1].state_key == b && mesh_batches[1].first_command == 2 &&
+              mesh_batches[1].command_count == 1);
+    JMS_CHECK(mesh_batches[2].state_key == c && mesh_batches[2].first_command == 3);
+}
+
+
+void TestEmpty() {
+    std::vector<DrawItem> items{};
+    std::vector<DrawItem> scratch{};
+    RadixSortDrawItems(items, scratch);
+    JMS_CHECK(items.empty());
+    // Stale commands are cleared.
+    std::vector<vk::DrawIndexedIndirectCommand> commands(3);
+    JMS_CHECK(MergeDrawItems(items, commands).empty() && commands.empty());
+    items.push_back(Item(MakeDrawKey(1, 1, 1), 0, 0, 0));
+    JMS_CHECK(MergeDrawItems(items, commands).empty() && commands.empty());
+}
+
+
+}
+
+
+int main() {
+    TestSort();
+    TestSkippedPasses();
+    TestMerge();
+    TestEmpty();
+    return jms::tests::Result();
+}
@@ -0,0 +1,429 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "jms/external/glm.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "jms/graphics/culling.hpp"
+#include "jms/graphics/projection.hpp"
+#include "jms/utils/simd.hpp"
+#include "check.hpp"
+
+
+using namespace jms;
+
+
+namespace {
+
+
+// Several full SIMD batches and a scalar tail of 3.
+constexpr size_t NUM_ITEMS = 64 * simd::WIDTH + 3;
+
+
+glm::mat4 View() {
+    glm::mat4 view = glm::translate(glm::mat4{1.0f}, glm::vec3{0.5f, -1.0f, -20.0f});
+    view = glm::rotate(view, 0.3f, glm::vec3{0.0f, 1.0f, 0.0f});
+    return glm::rotate(view, -0.2f, glm::vec3{1.0f, 0.0f, 0.0f});
+}
+
+
+constexpr float NEAR = 0.1f;
+constexpr float FAR = 100.0f;
+
+
+// The z flag set in front of near and past far differs between the forward, reversed and infinite projections.
+struct ClipCase {
+    glm::mat4 projection{1.0f};
+    uint8_t near_flag{0};
+    uint8_t far_flag{0};
+};
+
+
+std::vector<ClipCase> ClipCases() {
+    return {{Perspective_RH_ZO(1.0f, 1.5f, NEAR, FAR), CLIP_NEG_Z, CLIP_POS_Z},
+            {Perspective_RH_ZI(1.0f, 1.5f, NEAR), CLIP_NEG_Z, 0},
+            {Perspective_RH_OZ(1.0f, 1.5f, NEAR, FAR), CLIP_POS_Z, CLIP_NEG_Z},
+            {Perspective_RH_OI(1.0f, 1.5f, NEAR), CLIP_POS_Z, 0}};
+}
+
+
+// The SIMD path may use FMA and differ from glm in the last bits, so flags are only compared away from the planes.
+bool IsNearPlane(const glm::vec4& c) {
+    const float eps = 1e-4f * (1.0f + std::abs(c.w));
+    for (float d : {c.x + c.w, c.x - c.w, c.y + c.w, c.y - c.w, c.z, c.z - c.w, c.w}) {
+        if (std::abs(d) <= eps) { return true; }
+    }
+    return false;
+}
+
+
+bool IsNear(float a, float b) { return std::abs(a - b) <= 1e-4f * (1.0f + std::abs(b)); }
+
+
+// Compile time: the builders fold to constants, Tan included.
+constexpr bool IsClose(float a, float b, float tolerance) {
+    return ((a > b) ? a - b : b - a) <= tolerance * (1.0f + ((b < 0.0f) ? -b : b));
+}
+
+
+constexpr float TAN_HALF = 0.546302490f;  // tan(0.5)
+constexpr Projection ZO = Projection::Perspective_RH_ZO(1.0f, 1.5f, 0.1f, 100.0f);
+constexpr Projection OZ = Projection::Perspective_RH_OZ(1.0f, 1.5f, 0.1f, 100.0f);
+constexpr Projection ZI = Projection::Perspective_RH_ZI(1.0f, 1.5f, 0.1f);
+constexpr Projection OI = Projection::Perspective_RH_OI(1.0f, 1.5f, 0.1f);
+constexpr Projection OI_EXACT = Projection::Perspective_RH_OI(1.0f, 1.5f, 0.1f, 0.0f);
+constexpr Projection ORTHO = Projection::Orthographic_RH(-4.0f, 6.0f, -2.0f, 3.0f, 1.0f, 21.0f);
+constexpr Projection ORTHO_REVERSED = Projection::Orthographic_RH(-4.0f, 6.0f, -2.0f, 3.0f, 1.0f, 21.0f, true);
+static_assert(IsClose(ZO.y_scale, 1.0f / TAN_HALF, 1e-6f) && IsClose(ZO.x_scale, 1.0f / (1.5f * TAN_HALF), 1e-6f));
+static_assert(!ZO.is_reversed_z && !ZO.is_infinite_far && ZO.near == 0.1f && ZO.far == 100.0f);
+static_assert(IsClose(ZO.Depth(0.1f), 0.0f, 1e-6f) && IsClose(ZO.Depth(100.0f), 1.0f, 1e-6f));
+static_assert(OZ.is_reversed_z && OZ.near == 0.1f && OZ.far == 100.0f && OZ.y_scale == ZO.y_scale);
+static_assert(IsClose(OZ.Depth(0.1f), 1.0f, 1e-6f) && IsClose(OZ.Depth(100.0f), 0.0f, 1e-6f));
+static_assert(ZI.is_infinite_far && !ZI.is_reversed_z && ZI.far == std::numeric_limits<float>::infinity());
+static_assert(IsClose(ZI.Depth(0.1f), 0.0f, 1e-6f) && ZI.Depth(1e30f) < 1.0f);
+static_assert(OI.is_infinite_far && OI.is_reversed_z && IsClose(OI.Depth(0.1f), 1.0f, 1e-6f) && OI.Depth(1e30f) > 0.0f);
+// With epsilon 0 depth is exactly near / z.
+static_assert(OI_EXACT.Depth(2.0f) == 0.1f / 2.0f && OI_EXACT.LinearDepth(0.1f / 2.0f) == 2.0f);
+static_assert(!ORTHO.is_perspective && !ORTHO.is_reversed_z && ORTHO_REVERSED.is_reversed_z);
+static_assert(IsClose(ORTHO.Depth(1.0f), 0.0f, 1e-6f) && IsClose(ORTHO.Depth(21.0f), 1.0f, 1e-6f));
+static_assert(IsClose(ORTHO_REVERSED.Depth(1.0f), 1.0f, 1e-6f) && IsClose(ORTHO_REVERSED.Depth(21.0f), 0.0f, 1e-6f));
+static_assert(IsClose(ORTHO.NormalizedLinearDepth(ORTHO.Depth(11.0f)), 0.5f, 1e-6f));
+static_assert(IsClose(ORTHO_REVERSED.NormalizedLinearDepth(ORTHO_REVERSED.Depth(11.0f)), 0.5f, 1e-6f));
+
+
+void TestProjectPoints(const ClipCase& clip_case, size_t size) {
+    const glm::mat4 view = View();
+    const glm::mat4 m = clip_case.projection * view;
+    std::mt19937 rng{11};
+    std::uniform_real_distribution<float> xy(-40.0f, 40.0f);
+    // Some points are behind the eye and some past far.
+    std::uniform_real_distribution<float> z(-40.0f, 160.0f);
+    std::vector<float> x(size), y(size), pz(size);
+    for (size_t i = 0; i < size; ++i) {
+        x[i] = xy(rng);
+        y[i] = xy(rng);
+        pz[i] = z(rng);
+    }
+    std::vector<float> ndc_x(size), ndc_y(size), depth(size);
+    std::vector<uint8_t> clip(size);
+    ProjectPoints(m, {.x=x, .y=y, .z=pz}, {.x=ndc_x, .y=ndc_y, .depth=depth, .clip=clip});
+
+    size_t num_inside = 0;
+    size_t num_behind = 0;
+    size_t num_past_far = 0;
+    for (size_t i = 0; i < size; ++i) {
+        const glm::vec4 c = m * glm::vec4{x[i], y[i], pz[i], 1.0f};
+        if (!IsNearPlane(c)) { JMS_CHECK(clip[i] == ClipFlags(c)); }
+        if (c.w <= 0.0f) {
+            ++num_behind;
+            continue;
+        }
+        if (clip[i] == 0) { ++num_inside; }
+        // The z flags against the view space distance (+z is forward), not the clip space reference.
+        const float distance = (view * glm::vec4{x[i], y[i], pz[i], 1.0f}).z;
+        if (!IsNearPlane(c)) {
+            const uint8_t z_flags = clip[i] & (CLIP_NEG_Z | CLIP_POS_Z);
+            if (distance < NEAR) {
+                JMS_CHECK(z_flags == clip_case.near_flag);
+            } else if (distance > FAR) {
+                ++num_past_far;
+                JMS_CHECK(z_flags == clip_case.far_flag);
+            } else {
+                JMS_CHECK(z_flags == 0);
+            }
+        }
+        JMS_CHECK(IsNear(ndc_x[i], c.x / c.w));
+        JMS_CHECK(IsNear(ndc_y[i], c.y / c.w));
+        JMS_CHECK(IsNear(depth[i], c.z / c.w));
+    }
+    if (size >= simd::WIDTH * 4) { JMS_CHECK(num_inside > 0 && num_behind > 0 && num_past_far > 0); }
+}
+
+
+struct Boxes {
+    std::vector<float> center_x{};
+    std::vector<float> center_y{};
+    std::vector<float> center_z{};
+    std::vector<float> extent_x{};
+    std::vector<float> extent_y{};
+    std::vector<float> extent_z{};
+
+    void Add(const glm::vec3& center, const glm::vec3& extent) {
+        center_x.push_back(center.x);
+        center_y.push_back(center.y);
+        center_z.push_back(center.z);
+        extent_x.push_back(extent.x);
+        extent_y.push_back(extent.y);
+        extent_z.push_back(extent.z);
+    }
+
+    AabbSoA Aabbs() const {
+        return {.center_x=center_x, .center_y=center_y, .center_z=center_z,
+                .extent_x=extent_x, .extent_y=extent_y, .extent_z=extent_z};
+    }
+};
+
+
+struct Projected {
+    std::vector<float> min_x{};
+    std::vector<float> min_y{};
+    std::vector<float> max_x{};
+    std::vector<float> max_y{};
+    std::vector<float> min_depth{};
+    std::vector<float> max_depth{};
+    std::vector<uint8_t> clip_all{};
+    std::vector<uint8_t> clip_any{};
+
+    explicit Projected(size_t size)
+    : min_x(size), min_y(size), max_x(size), max_y(size), min_depth(size), max_depth(size), clip_all(size),
+      clip_any(size) {}
+
+    ProjectedAabbSoA Out() {
+        return {.min_x=min_x, .min_y=min_y, .max_x=max_x, .max_y=max_y, .min_depth=min_depth,
+                .max_depth=max_depth, .clip_all=clip_all, .clip_any=clip_any};
+    }
+};
+
+
+// The 8 corners of box i through glm: flags, NDC bounds and whether any corner is too close to a plane to compare.
+struct Reference {
+    uint8_t clip_all{0x7f};
+    uint8_t clip_any{0};
+    glm::vec3 min_ndc{std::numeric_limits<float>::max()};
+    glm::vec3 max_ndc{-std::numeric_limits<float>::max()};
+    bool is_near_plane{false};
+};
+
+
+Reference ProjectCorners(const glm::mat4& m, const Boxes& boxes, size_t i) {
+    const glm::vec3 center{boxes.center_x[i], boxes.center_y[i], boxes.center_z[i]};
+    const glm::vec3 extent{boxes.extent_x[i], boxes.extent_y[i], boxes.extent_z[i]};
+    Reference ref{};
+    for (float sx : {-1.0f, 1.0f}) {
+        for (float sy : {-1.0f, 1.0f}) {
+            for (float sz : {-1.0f, 1.0f}) {
+                const glm::vec4 c = m * glm::vec4{center + glm::vec3{sx, sy, sz} * extent, 1.0f};
+                ref.clip_all &= ClipFlags(c);
+                ref.clip_any |= ClipFlags(c);
+                ref.is_near_plane = ref.is_near_plane || IsNearPlane(c) || std::abs(c.w) < 1e-2f;
+                ref.min_ndc = glm::min(ref.min_ndc, glm::vec3{c} / c.w);
+                ref.max_ndc = glm::max(ref.max_ndc, glm::vec3{c} / c.w);
+            }
+        }
+    }
+    return ref;
+}
+
+
+bool IsWholeScreen(const Projected& p, size_t i) {
+    return p.min_x[i] == -1.0f && p.min_y[i] == -1.0f && p.max_x[i] == 1.0f && p.max_y[i] == 1.0f &&
+           p.min_depth[i] == 0.0f && p.max_depth[i] == 1.0f;
+}
+
+
+void TestProjectAabbs(const ClipCase& clip_case, size_t size) {
+    const glm::mat4 m = clip_case.projection * View();
+    std::mt19937 rng{13};
+    std::uniform_real_distribution<float> xy(-40.0f, 40.0f);
+    std::uniform_real_distribution<float> z(-40.0f, 160.0f);
+    std::uniform_real_distribution<float> extent(0.1f, 8.0f);
+    Boxes boxes{};
+    for (size_t i = 0; i < size; ++i) {
+        boxes.Add(glm::vec3{xy(rng), xy(rng), z(rng)}, glm::vec3{extent(rng), extent(rng), extent(rng)});
+    }
+    Projected projected{size};
+    ProjectAabbs(m, boxes.Aabbs(), projected.Out());
+
+    size_t num_compared = 0;
+    size_t num_behind = 0;
+    for (size_t i = 0; i < size; ++i) {
+        const Reference ref = ProjectCorners(m, boxes, i);
+        if (ref.is_near_plane) { continue; }
+        ++num_compared;
+        JMS_CHECK(projected.clip_all[i] == ref.clip_all);
+        JMS_CHECK(projected.clip_any[i] == ref.clip_any);
+        if (ref.clip_any & CLIP_W) {
+            ++num_behind;
+            JMS_CHECK(IsWholeScreen(projected, i));
+            continue;
+        }
+        JMS_CHECK(IsNear(projected.min_x[i], ref.min_ndc.x) && IsNear(projected.max_x[i], ref.max_ndc.x));
+        JMS_CHECK(IsNear(projected.min_y[i], ref.min_ndc.y) && IsNear(projected.max_y[i], ref.max_ndc.y));
+        JMS_CHECK(IsNear(projected.min_depth[i], ref.min_ndc.z) && IsNear(projected.max_depth[i], ref.max_ndc.z));
+    }
+    // With a finite far, clip z - w moves only near / (far - near) per unit, so boxes within ~10 of far are skipped.
+    if (size >= simd::WIDTH * 4) { JMS_CHECK(num_compared > size * 4 / 5 && num_behind > 0); }
+}
+
+
+// A box around the eye has corners on both sides of it; in the first SIMD batch and in the scalar tail.
+void TestBehindEye(const ClipCase& clip_case) {
+    const glm::mat4 m = clip_case.projection * View();
+    const size_t size = 2 * simd::WIDTH + 1;
+    // View space +z is forward.
+    const glm::mat4 inverse_view = glm::inverse(View());
+    const glm::vec3 eye{inverse_view[3]};
+    Boxes boxes{};
+    for (size_t i = 0; i < size; ++i) {
+        boxes.Add(glm::vec3{inverse_view * glm::vec4{0.0f, 0.0f, 30.0f, 1.0f}}, glm::vec3{1.0f});
+    }
+    for (size_t i : {static_cast<size_t>(0), size - 1}) {
+        boxes.center_x[i] = eye.x;
+        boxes.center_y[i] = eye.y;
+        boxes.center_z[i] = eye.z;
+    }
+    Projected projected{size};
+    ProjectAabbs(m, boxes.Aabbs(), projected.Out());
+
+    for (size_t i : {static_cast<size_t>(0), size - 1}) {
+        JMS_CHECK(projected.clip_any[i] & CLIP_W);
+        JMS_CHECK(!(projected.clip_all[i] & CLIP_W));
+        JMS_CHECK(IsWholeScreen(projected, i));
+    }
+    // The others are in front of the eye and on screen.
+    JMS_CHECK(projected.clip_any[1] == 0 && projected.clip_any[size - 2] == 0);
+    JMS_CHECK(projected.max_x[1] < 1.0f && projected.max_x[size - 2] < 1.0f);
+}
+
+
+#if defined(JMS_SIMD_AVX2_DISPATCH)
+// On a CPU with AVX2 the public functions never reach the baseline batches; run them directly against the dispatch.
+void TestBaselineBatches() {
+    const glm::mat4 m = Perspective_RH_ZO(1.0f, 1.5f, NEAR, FAR) * View();
+    std::mt19937 rng{17};
+    std::uniform_real_distribution<float> xyz(-40.0f, 160.0f);
+    std::vector<float> x(NUM_ITEMS), y(NUM_ITEMS), z(NUM_ITEMS);
+    for (size_t i = 0; i < NUM_ITEMS; ++i) {
+        x[i] = xyz(rng);
+        y[i] = xyz(rng);
+        z[i] = xyz(rng);
+    }
+    std::vector<float> ndc_x(NUM_ITEMS), ndc_y(NUM_ITEMS), depth(NUM_ITEMS);
+    std::vector<float> base_x(NUM_ITEMS), base_y(NUM_ITEMS), base_depth(NUM_ITEMS);
+    std::vector<uint8_t> clip(NUM_ITEMS), base_clip(NUM_ITEMS);
+    ProjectPoints(m, {.x=x, .y=y, .z=z}, {.x=ndc_x, .y=ndc_y, .depth=depth, .clip=clip});
+    const size_t end = detail::ProjectPointBatches<simd::Lanes>(
+        m, {.x=x, .y=y, .z=z}, {.x=base_x, .y=base_y, .depth=base_depth, .clip=base_clip});
+    JMS_CHECK(end == NUM_ITEMS - NUM_ITEMS % simd::Lanes::WIDTH);
+    for (size_t i = 0; i < end; ++i) {
+        const glm::vec4 c = m * glm::vec4{x[i], y[i], z[i], 1.0f};
+        if (!IsNearPlane(c)) { JMS_CHECK(base_clip[i] == clip[i]); }
+        if (c.w <= 0.0f) { continue; }
+        JMS_CHECK(IsNear(base_x[i], ndc_x[i]) && IsNear(base_y[i], ndc_y[i]) && IsNear(base_depth[i], depth[i]));
+    }
+}
+#endif
+
+
+void TestSizes() {
+    const glm::mat4 m = Perspective_RH_ZO(1.0f, 1.5f, NEAR, FAR) * View();
+    std::vector<float> x(4), y(4), z(4), out(3);
+    std::vector<uint8_t> clip(4);
+    bool is_thrown = false;
+    try {
+        ProjectPoints(m, {.x=x, .y=y, .z=z}, {.x=out, .y=out, .depth=out, .clip=clip});
+    } catch (const std::runtime_error&) {
+        is_thrown = true;
+    }
+    JMS_CHECK(is_thrown);
+}
+
+
+bool IsNear(const glm::mat4& a, const glm::mat4& b) {
+    for (glm::length_t c = 0; c < 4; ++c) {
+        for (glm::length_t r = 0; r < 4; ++r) {
+            if (!IsNear(a[c][r], b[c][r])) { return false; }
+        }
+    }
+    return true;
+}
+
+
+// Depth and LinearDepth round trip and agree with the matrix; NormalizedLinearDepth is 0 at near.
+void CheckDepth(const Projection& projection, const glm::mat4& matrix, float max_z) {
+    JMS_CHECK(IsNear(projection.Inverse() * projection.Matrix(), glm::mat4{1.0f}));
+    for (float t : {0.0f, 0.001f, 0.03f, 0.2f, 0.6f, 1.0f}) {
+        const float z = projection.near + t * (max_z - projection.near);
+        const float depth = projection.Depth(z);
+        const glm::vec4 clip = matrix * glm::vec4{1.0f, -2.0f, z, 1.0f};
+        JMS_CHECK(IsNear(clip.z / clip.w, depth));
+        JMS_CHECK(std::abs(projection.LinearDepth(depth) - z) <= 2e-3f * z);
+        const float normalized = projection.is_infinite_far ?
+                                 1.0f - projection.near / z :
+                                 (z - projection.near) / (projection.far - projection.near);
+        JMS_CHECK(std::abs(projection.NormalizedLinearDepth(depth) - normalized) <= 1e-3f);
+        // The inverse takes NDC back to view space.
+        const glm::vec4 view = projection.Inverse() * (clip / clip.w);
+        JMS_CHECK(std::abs(view.z / view.w - z) <= 2e-3f * z && std::abs(view.x / view.w - 1.0f) <= 2e-3f);
+    }
+    const float near_depth = projection.is_reversed_z ? 1.0f : 0.0f;
+    JMS_CHECK(std::abs(projection.Depth(projection.near) - near_depth) <= 1e-6f);
+    if (!projection.is_infinite_far) {
+        JMS_CHECK(std::abs(projection.Depth(projection.far) - (1.0f - near_depth)) <= 1e-6f);
+    }
+}
+
+
+void TestProjection() {
+    const float fovy = 1.0f;
+    const float aspect_ratio = 1.5f;
+    const float near = 0.1f;
+    const float far = 100.0f;
+    const std::vector<std::pair<Projection, glm::mat4>> perspectives{
+        {Projection::Perspective_RH_ZO(fovy, aspect_ratio, near, far),
+         Perspective_RH_ZO(fovy, aspect_ratio, near, far)},
+        {Projection::Perspective_RH_OZ(fovy, aspect_ratio, near, far),
+         Perspective_RH_OZ(fovy, aspect_ratio, near, far)},
+        {Projection::Perspective_RH_ZI(fovy, aspect_ratio, near), Perspective_RH_ZI(fovy, aspect_ratio, near)},
+        {Projection::Perspective_RH_ZI(fovy, aspect_ratio, near, 0.0f),
+         Perspective_RH_ZI(fovy, aspect_ratio, near, 0.0f)},
+        {Projection::Perspective_RH_OI(fovy, aspect_ratio, near), Perspective_RH_OI(fovy, aspect_ratio, near)},
+        {Projection::Perspective_RH_OI(fovy, aspect_ratio, near, 0.0f),
+         Perspective_RH_OI(fovy, aspect_ratio, near, 0.0f)}
+    };
+    for (const auto& [projection, matrix] : perspectives) {
+        JMS_CHECK(IsNear(projection.Matrix(), matrix));
+        CheckDepth(projection, matrix, projection.is_infinite_far ? 1000.0f : far);
+    }
+
+    // No free function; the corners of the volume map to the corners of NDC.
+    for (bool is_reversed_z : {false, true}) {
+        const Projection ortho = Projection::Orthographic_RH(-4.0f, 6.0f, -2.0f, 3.0f, 1.0f, 21.0f, is_reversed_z);
+        const glm::mat4 matrix = ortho.Matrix();
+        const glm::vec4 top_left_near = matrix * glm::vec4{-4.0f, -2.0f, 1.0f, 1.0f};
+        const glm::vec4 bottom_right_far = matrix * glm::vec4{6.0f, 3.0f, 21.0f, 1.0f};
+        const float near_depth = is_reversed_z ? 1.0f : 0.0f;
+        JMS_CHECK(IsNear(top_left_near.x, -1.0f) && IsNear(top_left_near.y, -1.0f) &&
+                  IsNear(top_left_near.z, near_depth) && top_left_near.w == 1.0f);
+        JMS_CHECK(IsNear(bottom_right_far.x, 1.0f) && IsNear(bottom_right_far.y, 1.0f) &&
+                  IsNear(bottom_right_far.z, 1.0f - near_depth) && bottom_right_far.w == 1.0f);
+        CheckDepth(ortho, matrix, 21.0f);
+    }
+}
+
+
+}
+
+
+int main() {
+    for (const ClipCase& clip_case : ClipCases()) {
+        for (size_t size : {NUM_ITEMS, simd::WIDTH - 1, static_cast<size_t>(0)}) {
+            TestProjectPoints(clip_case, size);
+            TestProjectAabbs(clip_case, size);
+        }
+        TestBehindEye(clip_case);
+    }
+#if defined(JMS_SIMD_AVX2_DISPATCH)
+    TestBaselineBatches();
+#endif
+    TestSizes();
+    TestProjection();
+    return jms::tests::Result();
+}
@@ -0,0 +1,73 @@
+#include <cstdio>
+#include <string>
+
+#include "jms/vulkan/vulkan.hpp"
+#include "jms/vulkan/queues.hpp"
+#include "jms/vulkan/state.hpp"
+#include "check.hpp"
+
+
+using namespace jms::vulkan;
+
+
+namespace {
+
+
+// ctest SKIP_RETURN_CODE; see CMakeLists.txt.
+constexpr int SKIP = 77;
+
+
+vk::raii::PhysicalDevice* FindLavapipe(State& state) {
+    for (vk::raii::PhysicalDevice& physical_device : state.physical_devices) {
+        vk::PhysicalDeviceProperties props = physical_device.getProperties();
+        std::string name{props.deviceName.data()};
+        if (props.deviceType == vk::PhysicalDeviceType::eCpu && name.find("llvmpipe") != std::string::npos) {
+            return &physical_device;
+        }
+    }
+    return nullptr;
+}
+
+
+}
+
+
+/***
+ * Lavapipe exposes a single graphics/compute/transfer family with a single queue; no role is dedicated and every
+ * role resolves to the graphics queue.
+ */
+int main() {
+    State state{};
+    state.InitInstance({.app_name="queues_lavapipe", .engine_name="jms"});
+    vk::raii::PhysicalDevice* physical_device = FindLavapipe(state);
+    if (!physical_device) {
+        std::fprintf(stderr, "lavapipe not found; set VK_DRIVER_FILES to its ICD json.\n");
+        return SKIP;
+    }
+
+    QueueFamilySelection selection = SelectQueueFamilies(*physical_device);
+    JMS_CHECK(selection.graphics == 0);
+    JMS_CHECK(!selection.compute.has_value());
+    JMS_CHECK(!selection.transfer.has_value());
+
+    state.InitDevice(*physical_device, DeviceConfig{
+        .queue_family_index=selection.graphics,
+        .compute_queue_family_index=selection.compute,
+        .transfer_queue_family_index=selection.transfer
+    });
+    JMS_CHECK(state.device_configs.at(0).queue_infos.size() == 1);
+    QueueRegistry& queues = state.queues.at(0);
+    const vk::Queue graphics = *queues.Get(QueueRole::GRAPHICS);
+    JMS_CHECK(graphics == *state.graphics_queue.at(0));
+    JMS_CHECK(*queues.Get(QueueRole::COMPUTE) == graphics);
+    JMS_CHECK(*queues.Get(QueueRole::TRANSFER) == graphics);
+    JMS_CHECK(*queues.Get(QueueRole::PRESENT) == graphics);
+    JMS_CHECK(!queues.Contains(QueueRole::COMPUTE));
+    JMS_CHECK(!queues.Contains(QueueRole::TRANSFER));
+    JMS_CHECK(queues.FamilyIndex(QueueRole::COMPUTE) == selection.graphics);
+    JMS_CHECK(queues.FamilyIndex(QueueRole::TRANSFER) == selection.graphics);
+    JMS_CHECK(!queues.IsDedicated(QueueRole::COMPUTE));
+    JMS_CHECK(!queues.IsDedicated(QueueRole::TRANSFER));
+    JMS_CHECK(!queues.IsDedicated(QueueRole::PRESENT));
+    return jms::tests::Result();
+}
@@ -0,0 +1,167 @@
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "jms/vulkan/render_graph.hpp"
+#include "check.hpp"
+
+
+using namespace jms::vulkan;
+
+
+namespace {
+
+
+const ImageInfo COLOR_INFO{
+    .format=vk::Format::eR8G8B8A8Unorm,
+    .extent{.width{64}, .height{64}, .depth{1}},
+    .usage=(vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled)
+};
+
+
+RenderGraphAccess ColorWrite(size_t resource) {
+    return {
+        .resource=resource,
+        .stage=vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+        .access=vk::AccessFlagBits2::eColorAttachmentWrite,
+        .layout=vk::ImageLayout::eColorAttachmentOptimal
+    };
+}
+
+
+RenderGraphAccess SampledRead(size_t resource) {
+    return {
+        .resource=resource,
+        .stage=vk::PipelineStageFlagBits2::eFragmentShader,
+        .access=vk::AccessFlagBits2::eShaderSampledRead,
+        .layout=vk::ImageLayout::eShaderReadOnlyOptimal
+    };
+}
+
+
+bool IsBarrier(const RenderGraphBarrier& barrier, size_t physical,
+               vk::PipelineStageFlags2 src_stage, vk::AccessFlags2 src_access,
+               vk::PipelineStageFlags2 dst_stage, vk::AccessFlags2 dst_access,
+               vk::ImageLayout old_layout, vk::ImageLayout new_layout) {
+    return barrier.physical == physical && barrier.src_stage == src_stage && barrier.src_access == src_access &&
+           barrier.dst_stage == dst_stage && barrier.dst_access == dst_access &&
+           barrier.old_layout == old_layout && barrier.new_layout == new_layout;
+}
+
+
+/***
+ * gbuffer -> lighting -> post -> composite to the swapchain, plus a debug pass whose transient output is never read.
+ * Resources: 0 gbuffer, 1 lighting, 2 debug, 3 swapchain, 4 post; all transients share COLOR_INFO.
+ */
+RenderGraph MakeGraph(bool is_debug_side_effect) {
+    RenderGraph graph{};
+    size_t gbuffer = graph.AddResource({.name="gbuffer", .transient=true, .image_info=COLOR_INFO});
+    size_t lighting = graph.AddResource({.name="lighting", .transient=true, .image_info=COLOR_INFO});
+    size_t debug = graph.AddResource({.name="debug", .transient=true, .image_info=COLOR_INFO});
+    size_t swapchain = graph.AddResource({
+        .name="swapchain",
+        .image_info=COLOR_INFO,
+        .initial_stage=vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+        .final_layout=vk::ImageLayout::ePresentSrcKHR
+    });
+    size_t post = graph.AddResource({.name="post", .transient=true, .image_info=COLOR_INFO});
+
+    graph.AddPass({.name="gbuffer", .writes={ColorWrite(gbuffer)}});
+    graph.AddPass({.name="debug", .writes={ColorWrite(debug)}, .has_side_effects=is_debug_side_effect});
+    graph.AddPass({.name="lighting", .reads={SampledRead(gbuffer)}, .writes={ColorWrite(lighting)}});
+    graph.AddPass({.name="post", .reads={SampledRead(lighting)}, .writes={ColorWrite(post)}});
+    graph.AddPass({.name="composite", .reads={SampledRead(post)}, .writes={ColorWrite(swapchain)}});
+    return graph;
+}
+
+
+void TestCullAndOrder() {
+    CompiledRenderGraph culled = MakeGraph(false).Compile();
+    JMS_CHECK(culled.order == std::vector<size_t>{0, 2, 3, 4});
+    JMS_CHECK(!culled.lifetimes[2].has_value());
+    JMS_CHECK(!culled.physical_of[2].has_value());
+
+    CompiledRenderGraph kept = MakeGraph(true).Compile();
+    JMS_CHECK(kept.order == std::vector<size_t>{0, 1, 2, 3, 4});
+    JMS_CHECK(kept.physical_of[2].has_value());
+}
+
+
+void TestAliasing() {
+    CompiledRenderGraph compiled = MakeGraph(false).Compile();
+    using Lifetime = std::optional<std::pair<size_t, size_t>>;
+    JMS_CHECK(compiled.lifetimes[0] == Lifetime{{0, 1}});
+    JMS_CHECK(compiled.lifetimes[1] == Lifetime{{1, 2}});
+    JMS_CHECK(compiled.lifetimes[4] == Lifetime{{2, 3}});
+    JMS_CHECK(compiled.lifetimes[3] == Lifetime{{3, 3}});
+
+    // Imported resources come first; post starts after gbuffer's last use so it takes over gbuffer's image while
+    // lighting, live alongside both, gets its own.
+    JMS_CHECK(compiled.physicals.size() == 3);
+    JMS_CHECK(compiled.physical_of[3] == std::optional<size_t>{0});
+    JMS_CHECK(compiled.physical_of[0] == std::optional<size_t>{1});
+    JMS_CHECK(compiled.physical_of[1] == std::optional<size_t>{2});
+    JMS_CHECK(compiled.physical_of[4] == std::optional<size_t>{1});
+    JMS_CHECK(compiled.physicals[1].lifetime == Lifetime{{0, 3}});
+    JMS_CHECK(compiled.physicals[2].lifetime == Lifetime{{1, 2}});
+    JMS_CHECK(!compiled.physicals[0].transient && compiled.physicals[1].transient);
+}
+
+
+void TestBarriers() {
+    using Stage = vk::PipelineStageFlagBits2;
+    using Access = vk::AccessFlagBits2;
+    using Layout = vk::ImageLayout;
+    CompiledRenderGraph compiled = MakeGraph(false).Compile();
+    const auto& barriers = compiled.barriers;
+    if (!JMS_CHECK(barriers.size() == 4)) { return; }
+
+    // gbuffer: first use discards.
+    JMS_CHECK(barriers[0].size() == 1);
+    JMS_CHECK(IsBarrier(barriers[0].at(0), 1, {}, {}, Stage::eColorAttachmentOutput, Access::eColorAttachmentWrite,
+                        Layout::eUndefined, Layout::eColorAttachmentOptimal));
+
+    // lighting: gbuffer write to sampled read, then lighting's first use.
+    JMS_CHECK(barriers[1].size() == 2);
+    JMS_CHECK(IsBarrier(barriers[1].at(0), 1, Stage::eColorAttachmentOutput, Access::eColorAttachmentWrite,
+                        Stage::eFragmentShader, Access::eShaderSampledRead,
+                        Layout::eColorAttachmentOptimal, Layout::eShaderReadOnlyOptimal));
+    JMS_CHECK(IsBarrier(barriers[1].at(1), 2, {}, {}, Stage::eColorAttachmentOutput, Access::eColorAttachmentWrite,
+                        Layout::eUndefined, Layout::eColorAttachmentOptimal));
+
+    // post: takes over gbuffer's image, so it waits for the reads of gbuffer (write after read, no access).
+    JMS_CHECK(barriers[2].size() == 2);
+    JMS_CHECK(IsBarrier(barriers[2].at(0), 2, Stage::eColorAttachmentOutput, Access::eColorAttachmentWrite,
+                        Stage::eFragmentShader, Access::eShaderSampledRead,
+                        Layout::eColorAttachmentOptimal, Layout::eShaderReadOnlyOptimal));
+    JMS_CHECK(IsBarrier(barriers[2].at(1), 1, Stage::eFragmentShader, {},
+                        Stage::eColorAttachmentOutput, Access::eColorAttachmentWrite,
+                        Layout::eUndefined, Layout::eColorAttachmentOptimal));
+
+    // composite: waits on the swapchain acquire stage.
+    JMS_CHECK(barriers[3].size() == 2);
+    JMS_CHECK(IsBarrier(barriers[3].at(0), 1, Stage::eColorAttachmentOutput, Access::eColorAttachmentWrite,
+                        Stage::eFragmentShader, Access::eShaderSampledRead,
+                        Layout::eColorAttachmentOptimal, Layout::eShaderReadOnlyOptimal));
+    JMS_CHECK(IsBarrier(barriers[3].at(1), 0, Stage::eColorAttachmentOutput, {},
+                        Stage::eColorAttachmentOutput, Access::eColorAttachmentWrite,
+                        Layout::eUndefined, Layout::eColorAttachmentOptimal));
+
+    JMS_CHECK(compiled.final_barriers.size() == 1);
+    JMS_CHECK(IsBarrier(compiled.final_barriers.at(0), 0, Stage::eColorAttachmentOutput,
+                        Access::eColorAttachmentWrite, Stage::eNone, Access::eNone,
+                        Layout::eColorAttachmentOptimal, Layout::ePresentSrcKHR));
+    JMS_CHECK(compiled.NumBarrierCalls() == 5);
+}
+
+
+}
+
+
+int main() {
+    TestCullAndOrder();
+    TestAliasing();
+    TestBarriers();
+    return jms::tests::Result();
+}
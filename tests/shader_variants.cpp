@@ -0,0 +1,78 @@
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "jms/utils/no_mutex.hpp"
+#include "jms/vulkan/shader_variants.hpp"
+#include "check.hpp"
+
+
+using namespace jms::vulkan;
+
+
+namespace {
+
+
+using Manager = ShaderVariantManager<jms::NoMutex>;
+
+
+ShaderVariantKey KeyInOrder() {
+    ShaderVariantKey key{};
+    key.Set(0, 7).Set(1, 5).Set(3, std::bit_cast<uint32_t>(1.0f));
+    return key;
+}
+
+
+ShaderVariantKey KeyOutOfOrder() {
+    ShaderVariantKey key{};
+    // Set twice; the last value wins.
+    key.Set(3, std::bit_cast<uint32_t>(1.0f)).Set(1, 9).Set(0, 7).Set(1, 5);
+    return key;
+}
+
+
+void TestKey() {
+    const ShaderVariantKey a = KeyInOrder().Canonical();
+    const ShaderVariantKey b = KeyOutOfOrder().Canonical();
+    JMS_CHECK(a.constants == b.constants);
+    JMS_CHECK(Manager::Key(0, a) == Manager::Key(0, b));
+    JMS_CHECK(Manager::Key(0, a) != Manager::Key(1, a));
+
+    ShaderVariantKey c = KeyInOrder();
+    c.Set(1, 6);
+    JMS_CHECK(Manager::Key(0, a) != Manager::Key(0, c.Canonical()));
+    // Swapping an id and its value, or adding a zero constant, is a different variant.
+    JMS_CHECK(Manager::Key(0, ShaderVariantKey{}.Set(1, 2)) != Manager::Key(0, ShaderVariantKey{}.Set(2, 1)));
+    JMS_CHECK(Manager::Key(0, ShaderVariantKey{}) != Manager::Key(0, ShaderVariantKey{}.Set(0, 0)));
+}
+
+
+// The map the manager deduplicates variants in.
+void TestDedup() {
+    std::unordered_map<ShaderVariantId, int, ShaderVariantIdHash> variants{};
+    auto Insert = [&variants](size_t shader_index, const ShaderVariantKey& key) {
+        return variants.try_emplace(ShaderVariantId{.shader_index=shader_index, .canonical_key=key.Canonical()},
+                                    static_cast<int>(variants.size())).second;
+    };
+    JMS_CHECK(Insert(0, KeyInOrder()));
+    JMS_CHECK(!Insert(0, KeyOutOfOrder()));
+    JMS_CHECK(Insert(1, KeyOutOfOrder()));
+    JMS_CHECK(!Insert(1, KeyInOrder()));
+    JMS_CHECK(Insert(0, ShaderVariantKey{}));
+    JMS_CHECK(variants.size() == 3);
+
+    const ShaderVariantId id{.shader_index=0, .canonical_key=KeyOutOfOrder().Canonical()};
+    JMS_CHECK(ShaderVariantIdHash{}(id) == static_cast<size_t>(Manager::Key(0, KeyInOrder().Canonical())));
+    JMS_CHECK(variants.at(id) == 0);
+}
+
+
+}
+
+
+int main() {
+    TestKey();
+    TestDedup();
+    return jms::tests::Result();
+}
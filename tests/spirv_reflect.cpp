@@ -0,0 +1,153 @@
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+#include "jms/vulkan/vulkan.hpp"
+#include "jms/vulkan/shader.hpp"
+#include "jms/vulkan/spirv_reflect.hpp"
+#include "check.hpp"
+
+
+using namespace jms::vulkan;
+
+
+namespace {
+
+
+// Sources are in the comments of tests/spirv/*.spvasm.
+std::vector<uint32_t> LoadFixture(const char* name) {
+    return Load(std::filesystem::path{JMS_TEST_SPIRV_DIR} / name);
+}
+
+
+bool IsBinding(const SpirvDescriptorBinding& b, uint32_t set, uint32_t binding, vk::DescriptorType type,
+               uint32_t count, vk::ShaderStageFlags stages) {
+    return b.set == set && b.binding == binding && b.type == type && b.count == count && b.stages == stages;
+}
+
+
+bool IsLayoutBinding(const vk::DescriptorSetLayoutBinding& b, uint32_t binding, vk::DescriptorType type,
+                     uint32_t count, vk::ShaderStageFlags stages) {
+    return b.binding == binding && b.descriptorType == type && b.descriptorCount == count && b.stageFlags == stages;
+}
+
+
+void TestVertex() {
+    using Stage = vk::ShaderStageFlagBits;
+    SpirvReflection reflection = ReflectSpirv(LoadFixture("reflect.vert.spv"));
+    JMS_CHECK(reflection.stage == Stage::eVertex);
+    JMS_CHECK(reflection.entry_point_name == "main");
+
+    if (JMS_CHECK(reflection.bindings.size() == 3)) {
+        JMS_CHECK(IsBinding(reflection.bindings[0], 0, 0, vk::DescriptorType::eUniformBuffer, 1, Stage::eVertex));
+        JMS_CHECK(IsBinding(reflection.bindings[1], 1, 0, vk::DescriptorType::eStorageBuffer, 1, Stage::eVertex));
+        JMS_CHECK(IsBinding(reflection.bindings[2], 0, 1, vk::DescriptorType::eCombinedImageSampler, 2,
+                            Stage::eVertex));
+    }
+
+    // mat4 and a uint at 64.
+    JMS_CHECK(reflection.push_constants.has_value());
+    JMS_CHECK(reflection.push_constants.value_or(SpirvPushConstantBlock{}).offset == 0);
+    JMS_CHECK(reflection.push_constants.value_or(SpirvPushConstantBlock{}).size == 68);
+
+    // Sorted by location; gl_VertexIndex is skipped.
+    if (JMS_CHECK(reflection.vertex_inputs.size() == 3)) {
+        const auto& inputs = reflection.vertex_inputs;
+        JMS_CHECK(inputs[0].location == 0 && inputs[0].format == vk::Format::eR32G32B32Sfloat && inputs[0].size == 12);
+        JMS_CHECK(inputs[1].location == 1 && inputs[1].format == vk::Format::eR32G32Sfloat && inputs[1].size == 8);
+        JMS_CHECK(inputs[2].location == 2 && inputs[2].format == vk::Format::eR32G32B32A32Uint &&
+                  inputs[2].size == 16);
+    }
+}
+
+
+void TestFragment() {
+    using Stage = vk::ShaderStageFlagBits;
+    SpirvReflection reflection = ReflectSpirv(LoadFixture("reflect.frag.spv"));
+    JMS_CHECK(reflection.stage == Stage::eFragment);
+
+    if (JMS_CHECK(reflection.bindings.size() == 4)) {
+        JMS_CHECK(IsBinding(reflection.bindings[0], 0, 0, vk::DescriptorType::eUniformBuffer, 1, Stage::eFragment));
+        JMS_CHECK(IsBinding(reflection.bindings[1], 0, 1, vk::DescriptorType::eCombinedImageSampler, 4,
+                            Stage::eFragment));
+        // Runtime array; count 0.
+        JMS_CHECK(IsBinding(reflection.bindings[2], 2, 0, vk::DescriptorType::eSampledImage, 0, Stage::eFragment));
+        JMS_CHECK(IsBinding(reflection.bindings[3], 2, 1, vk::DescriptorType::eSampler, 1, Stage::eFragment));
+    }
+
+    // vec4 at 64.
+    JMS_CHECK(reflection.push_constants.has_value());
+    JMS_CHECK(reflection.push_constants.value_or(SpirvPushConstantBlock{}).offset == 64);
+    JMS_CHECK(reflection.push_constants.value_or(SpirvPushConstantBlock{}).size == 16);
+
+    // Inputs of other stages are not vertex inputs.
+    JMS_CHECK(reflection.vertex_inputs.empty());
+}
+
+
+void TestShaderGroup() {
+    using Stage = vk::ShaderStageFlagBits;
+    const vk::ShaderStageFlags both = Stage::eVertex | Stage::eFragment;
+    ShaderGroup group{};
+    group.shader_infos.push_back({.stage=Stage::eVertex, .code=LoadFixture("reflect.vert.spv")});
+    group.shader_infos.push_back({.stage=Stage::eFragment, .code=LoadFixture("reflect.frag.spv")});
+    ReflectShaderGroup(group);
+
+    const auto& sets = group.set_layout_bindings;
+    if (JMS_CHECK(sets.size() == 3 && sets[0].size() == 2 && sets[1].size() == 1 && sets[2].size() == 2)) {
+        JMS_CHECK(IsLayoutBinding(sets[0][0], 0, vk::DescriptorType::eUniformBuffer, 1, both));
+        // Arrayed in both stages; the larger count wins.
+        JMS_CHECK(IsLayoutBinding(sets[0][1], 1, vk::DescriptorType::eCombinedImageSampler, 4, both));
+        JMS_CHECK(IsLayoutBinding(sets[1][0], 0, vk::DescriptorType::eStorageBuffer, 1, Stage::eVertex));
+        JMS_CHECK(IsLayoutBinding(sets[2][0], 0, vk::DescriptorType::eSampledImage, 0, Stage::eFragment));
+        JMS_CHECK(IsLayoutBinding(sets[2][1], 1, vk::DescriptorType::eSampler, 1, Stage::eFragment));
+    }
+
+    // [0, 68) and [64, 80) merge into one range for both stages.
+    if (JMS_CHECK(group.push_constant_ranges.size() == 1)) {
+        const vk::PushConstantRange& range = group.push_constant_ranges[0];
+        JMS_CHECK(range.stageFlags == both && range.offset == 0 && range.size == 80);
+    }
+
+    const auto& attributes = group.vertex_attribute_desc;
+    if (JMS_CHECK(attributes.size() == 3)) {
+        JMS_CHECK(attributes[0].location == 0 && attributes[0].binding == 0 && attributes[0].offset == 0);
+        JMS_CHECK(attributes[1].location == 1 && attributes[1].offset == 12);
+        JMS_CHECK(attributes[2].location == 2 && attributes[2].offset == 20);
+    }
+    if (JMS_CHECK(group.vertex_binding_desc.size() == 1)) {
+        JMS_CHECK(group.vertex_binding_desc[0].binding == 0 && group.vertex_binding_desc[0].stride == 36);
+    }
+
+    for (const auto& info : group.shader_infos) {
+        JMS_CHECK(info.set_info_indices == std::vector<size_t>{0, 1, 2});
+        JMS_CHECK(info.push_constant_ranges_indices == std::vector<size_t>{0});
+        JMS_CHECK(info.entry_point_name == "main");
+    }
+}
+
+
+void TestInvalid() {
+    std::vector<uint32_t> code = LoadFixture("reflect.vert.spv");
+    code[0] = 0;
+    bool is_thrown = false;
+    try {
+        ReflectSpirv(code);
+    } catch (const std::runtime_error&) {
+        is_thrown = true;
+    }
+    JMS_CHECK(is_thrown);
+}
+
+
+}
+
+
+int main() {
+    TestVertex();
+    TestFragment();
+    TestShaderGroup();
+    TestInvalid();
+    return jms::tests::Result();
+}
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "jms/external/glm.hpp"
+
+#include "jms/vulkan/std_layout.hpp"
+#include "check.hpp"
+
+
+using namespace jms::vulkan;
+
+
+namespace {
+
+
+constexpr BufferLayout STD140 = BufferLayout::STD140;
+constexpr BufferLayout STD430 = BufferLayout::STD430;
+
+
+// A vec3 is 16 byte aligned but 12 bytes long; a following scalar packs into its last 4 bytes.
+using Vec3Float140 = BlockLayout<STD140, glm::vec3, float>;
+using Vec3Float430 = BlockLayout<STD430, glm::vec3, float>;
+static_assert(Vec3Float140::offsets == std::array<size_t, 2>{0, 12} && Vec3Float140::stride == 16);
+static_assert(Vec3Float430::offsets == std::array<size_t, 2>{0, 12} && Vec3Float430::stride == 16);
+static_assert(BlockLayout<STD140, glm::vec3, glm::vec3>::offsets == std::array<size_t, 2>{0, 16});
+static_assert(BlockLayout<STD140, float, glm::vec3>::offsets == std::array<size_t, 2>{0, 16});
+
+// mat2 columns are rounded up to 16 bytes in std140 only; mat3 columns are vec3 so 16 bytes in both.
+static_assert(LayoutOf<STD140, glm::mat2>::stride == 16 && LayoutOf<STD140, glm::mat2>::size == 32);
+static_assert(LayoutOf<STD430, glm::mat2>::stride == 8 && LayoutOf<STD430, glm::mat2>::size == 16);
+static_assert(LayoutOf<STD140, glm::mat3>::size == 48 && LayoutOf<STD430, glm::mat3>::size == 48);
+static_assert(LayoutOf<STD140, glm::mat3>::alignment == 16 && LayoutOf<STD430, glm::mat3>::alignment == 16);
+static_assert(!LayoutOf<STD140, glm::mat2>::is_dense && LayoutOf<STD430, glm::mat2>::is_dense);
+static_assert(!LayoutOf<STD140, glm::mat3>::is_dense && !LayoutOf<STD430, glm::mat3>::is_dense);
+static_assert(BlockLayout<STD140, glm::mat2, float>::offsets == std::array<size_t, 2>{0, 32});
+static_assert(BlockLayout<STD430, glm::mat2, float>::offsets == std::array<size_t, 2>{0, 16});
+
+// float arrays are strided by 16 in std140 and tightly packed in std430.
+using Floats = std::array<float, 3>;
+static_assert(LayoutOf<STD140, Floats>::stride == 16 && LayoutOf<STD140, Floats>::size == 48);
+static_assert(LayoutOf<STD430, Floats>::stride == 4 && LayoutOf<STD430, Floats>::size == 12);
+static_assert(!LayoutOf<STD140, Floats>::is_dense && LayoutOf<STD430, Floats>::is_dense);
+static_assert(BlockLayout<STD140, float, Floats, float>::offsets == std::array<size_t, 3>{0, 16, 64});
+static_assert(BlockLayout<STD430, float, Floats, float>::offsets == std::array<size_t, 3>{0, 4, 16});
+static_assert(BlockLayout<STD140, Floats>::stride == 48 && BlockLayout<STD430, Floats>::stride == 12);
+
+
+struct Mixed {
+    float a{};
+    glm::vec3 b{};
+    float c{};
+    glm::mat3 m{};
+    std::array<float, 3> floats{};
+    glm::vec2 d{};
+    glm::mat2 n{};
+
+    bool operator==(const Mixed&) const = default;
+};
+
+
+template <BufferLayout LAYOUT>
+using MixedLayout = StructLayout<LAYOUT, &Mixed::a, &Mixed::b, &Mixed::c, &Mixed::m, &Mixed::floats, &Mixed::d,
+                                 &Mixed::n>;
+using Mixed140 = MixedLayout<STD140>;
+using Mixed430 = MixedLayout<STD430>;
+constexpr std::array<size_t, 7> MIXED_CPP_OFFSETS{offsetof(Mixed, a), offsetof(Mixed, b), offsetof(Mixed, c),
+                                                  offsetof(Mixed, m), offsetof(Mixed, floats), offsetof(Mixed, d),
+                                                  offsetof(Mixed, n)};
+static_assert(Mixed140::offsets == std::array<size_t, 7>{0, 16, 28, 32, 80, 128, 144});
+static_assert(Mixed140::size == 176 && Mixed140::stride == 176);
+static_assert(Mixed430::offsets == std::array<size_t, 7>{0, 16, 28, 32, 80, 96, 104});
+static_assert(Mixed430::size == 120 && Mixed430::stride == 128);
+static_assert(!Mixed140::IsCppLayout(MIXED_CPP_OFFSETS) && !Mixed430::IsCppLayout(MIXED_CPP_OFFSETS));
+
+
+// Already std140; Pack copies it with memcpy.
+struct Camera {
+    glm::mat4 view{};
+    glm::mat4 projection{};
+    glm::vec4 position{};
+
+    bool operator==(const Camera&) const = default;
+};
+
+
+using Camera140 = StructLayout<STD140, &Camera::view, &Camera::projection, &Camera::position>;
+static_assert(Camera140::IsCppLayout({offsetof(Camera, view), offsetof(Camera, projection),
+                                      offsetof(Camera, position)}));
+
+
+constexpr size_t STRIDE = 256;
+constexpr std::byte FILL{0xab};
+
+
+std::vector<Mixed> MakeMixed(size_t size) {
+    std::vector<Mixed> out(size);
+    float value = 1.0f;
+    for (Mixed& s : out) {
+        s.a = value++;
+        for (glm::length_t i = 0; i < 3; ++i) { s.b[i] = value++; }
+        s.c = value++;
+        for (glm::length_t i = 0; i < 3; ++i) {
+            for (glm::length_t j = 0; j < 3; ++j) { s.m[i][j] = value++; }
+        }
+        for (float& f : s.floats) { f = value++; }
+        for (glm::length_t i = 0; i < 2; ++i) { s.d[i] = value++; }
+        for (glm::length_t i = 0; i < 2; ++i) {
+            for (glm::length_t j = 0; j < 2; ++j) { s.n[i][j] = value++; }
+        }
+    }
+    return out;
+}
+
+
+float FloatAt(std::span<const std::byte> bytes, size_t offset) {
+    float out = 0.0f;
+    std::memcpy(&out, bytes.data() + offset, sizeof(out));
+    return out;
+}
+
+
+// Bytes from size to the stride of every element are left alone.
+bool IsPaddingUntouched(std::span<const std::byte> bytes, size_t size, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const size_t end = (i + 1 == count) ? bytes.size() : (i + 1) * STRIDE;
+        if (!std::all_of(bytes.begin() + i * STRIDE + size, bytes.begin() + end,
+                         [](std::byte b) { return b == FILL; })) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+template <BufferLayout LAYOUT>
+void TestMixedRoundTrip() {
+    using Layout_t = MixedLayout<LAYOUT>;
+    const std::vector<Mixed> in = MakeMixed(5);
+    std::vector<std::byte> bytes((in.size() - 1) * STRIDE + Layout_t::size, FILL);
+    Layout_t::Pack(in, bytes, STRIDE);
+    std::vector<Mixed> out(in.size());
+    Layout_t::Unpack(bytes, out, STRIDE);
+    JMS_CHECK(out == in);
+    JMS_CHECK(IsPaddingUntouched(bytes, Layout_t::size, in.size()));
+
+    // Spot checks of the last element at the layout's offsets: c, the last array float and the matrix corners.
+    const Mixed& last = in.back();
+    const size_t base = (in.size() - 1) * STRIDE;
+    const std::array<size_t, 7>& offsets = Layout_t::offsets;
+    JMS_CHECK(FloatAt(bytes, base + offsets[2]) == last.c);
+    JMS_CHECK(FloatAt(bytes, base + offsets[3] + 2 * LayoutOf<LAYOUT, glm::mat3>::stride + 8) == last.m[2][2]);
+    JMS_CHECK(FloatAt(bytes, base + offsets[4] + 2 * LayoutOf<LAYOUT, Floats>::stride) == last.floats[2]);
+    JMS_CHECK(FloatAt(bytes, base + offsets[6] + LayoutOf<LAYOUT, glm::mat2>::stride + 4) == last.n[1][1]);
+}
+
+
+void TestCameraRoundTrip() {
+    std::vector<Camera> in(3);
+    for (size_t i = 0; i < in.size(); ++i) {
+        in[i].view = glm::mat4{static_cast<float>(i + 1)};
+        in[i].projection = glm::mat4{static_cast<float>(i + 10)};
+        in[i].position = glm::vec4{static_cast<float>(i), 1.0f, 2.0f, 3.0f};
+    }
+    for (size_t stride : {Camera140::stride, STRIDE}) {
+        std::vector<std::byte> bytes((in.size() - 1) * stride + Camera140::size, FILL);
+        Camera140::Pack(in, bytes, stride);
+        std::vector<Camera> out(in.size());
+        Camera140::Unpack(bytes, out, stride);
+        JMS_CHECK(out == in);
+        JMS_CHECK(FloatAt(bytes, 2 * stride + 128) == 2.0f);
+        if (stride == STRIDE) { JMS_CHECK(IsPaddingUntouched(bytes, Camera140::size, in.size())); }
+    }
+}
+
+
+void TestRangeErrors() {
+    const std::vector<Mixed> in = MakeMixed(2);
+    std::vector<std::byte> bytes(STRIDE + Mixed140::size - 1);
+    auto Throws = [](auto&& fn) {
+        try {
+            fn();
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    JMS_CHECK(Throws([&] { Mixed140::Pack(in, bytes, STRIDE); }));
+    JMS_CHECK(Throws([&] { Mixed140::Pack(in, bytes, Mixed140::size - 1); }));
+    std::vector<Mixed> out(2);
+    JMS_CHECK(Throws([&] { Mixed140::Unpack(bytes, out, STRIDE); }));
+    bytes.push_back(FILL);
+    JMS_CHECK(!Throws([&] { Mixed140::Pack(in, bytes, STRIDE); }));
+}
+
+
+}
+
+
+int main() {
+    TestMixedRoundTrip<STD140>();
+    TestMixedRoundTrip<STD430>();
+    TestCameraRoundTrip();
+    TestRangeErrors();
+    return jms::tests::Result();
+}
@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "jms/external/glm.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "jms/graphics/transform_hierarchy.hpp"
+#include "check.hpp"
+
+
+using namespace jms;
+
+
+namespace {
+
+
+constexpr size_t NUM_NODES = 1000;
+// Not a multiple of 64 so every matrix lands at a different offset than Worlds().
+constexpr size_t STRIDE = 80;
+constexpr std::byte SENTINEL{0xcd};
+
+
+glm::vec3 RandomVec3(std::mt19937& rng, float min, float max) {
+    std::uniform_real_distribution<float> distribution(min, max);
+    return {distribution(rng), distribution(rng), distribution(rng)};
+}
+
+
+glm::quat RandomRotation(std::mt19937& rng) {
+    std::normal_distribution<float> normal{};
+    return glm::normalize(glm::quat{normal(rng), normal(rng), normal(rng), normal(rng)});
+}
+
+
+// A random forest; one node in 10 is a root and the rest take an earlier node as parent.
+TransformHierarchy MakeHierarchy(std::mt19937& rng) {
+    TransformHierarchy hierarchy{};
+    hierarchy.Reserve(NUM_NODES);
+    for (size_t i = 0; i < NUM_NODES; ++i) {
+        const uint32_t parent = (i == 0 || rng() % 10 == 0) ? TransformHierarchy::NO_PARENT :
+                                                              static_cast<uint32_t>(rng() % i);
+        hierarchy.Add(parent, RandomVec3(rng, -10.0f, 10.0f), RandomRotation(rng), RandomVec3(rng, 0.5f, 1.5f));
+    }
+    return hierarchy;
+}
+
+
+// world = parent world * translate * rotate * scale, recomputed for every node from its local transform.
+std::vector<glm::mat4> BruteForceWorlds(const TransformHierarchy& hierarchy) {
+    std::vector<glm::mat4> out(hierarchy.Size());
+    for (uint32_t i = 0; i < hierarchy.Size(); ++i) {
+        const uint32_t parent = hierarchy.Parent(i);
+        const glm::mat4 parent_world = (parent == TransformHierarchy::NO_PARENT) ? glm::mat4{1.0f} : out[parent];
+        out[i] = glm::scale(glm::translate(parent_world, hierarchy.Translation(i)) *
+                            glm::mat4_cast(hierarchy.Rotation(i)), hierarchy.Scale(i));
+    }
+    return out;
+}
+
+
+bool IsNear(const glm::mat4& a, const glm::mat4& b) {
+    for (glm::length_t c = 0; c < 4; ++c) {
+        for (glm::length_t r = 0; r < 4; ++r) {
+            if (std::abs(a[c][r] - b[c][r]) > 1e-3f * std::max(1.0f, std::abs(b[c][r]))) { return false; }
+        }
+    }
+    return true;
+}
+
+
+bool MatchesBruteForce(const TransformHierarchy& hierarchy) {
+    const std::vector<glm::mat4> expected = BruteForceWorlds(hierarchy);
+    for (uint32_t i = 0; i < hierarchy.Size(); ++i) {
+        if (!IsNear(hierarchy.World(i), expected[i])) { return false; }
+    }
+    return true;
+}
+
+
+// Nodes under (and including) any of roots, by walking parents.
+std::vector<uint32_t> Subtrees(const TransformHierarchy& hierarchy, const std::vector<uint32_t>& roots) {
+    std::vector<uint32_t> out{};
+    for (uint32_t i = 0; i < hierarchy.Size(); ++i) {
+        for (uint32_t node = i; node != TransformHierarchy::NO_PARENT; node = hierarchy.Parent(node)) {
+            if (std::ranges::find(roots, node) != roots.end()) {
+                out.push_back(i);
+                break;
+            }
+        }
+    }
+    return out;
+}
+
+
+std::vector<uint32_t> RangeNodes(std::span<const TransformRange> ranges) {
+    std::vector<uint32_t> out{};
+    for (const TransformRange& range : ranges) {
+        for (uint32_t i = range.begin; i < range.end; ++i) { out.push_back(i); }
+    }
+    return out;
+}
+
+
+// Ranges are sorted, disjoint, non-empty and not adjacent (adjacent ones are merged).
+bool AreRangesCanonical(std::span<const TransformRange> ranges) {
+    for (size_t j = 0; j < ranges.size(); ++j) {
+        if (ranges[j].begin >= ranges[j].end) { return false; }
+        if (j > 0 && ranges[j].begin <= ranges[j - 1].end) { return false; }
+    }
+    return true;
+}
+
+
+void TestRandomEdits() {
+    std::mt19937 rng{49};
+    TransformHierarchy hierarchy = MakeHierarchy(rng);
+    JMS_CHECK(hierarchy.Update() == NUM_NODES);
+    JMS_CHECK(MatchesBruteForce(hierarchy));
+    JMS_CHECK(hierarchy.DirtyRanges().size() == 1 && hierarchy.DirtyRanges()[0].begin == 0 &&
+              hierarchy.DirtyRanges()[0].end == NUM_NODES);
+
+    for (int round = 0; round < 20; ++round) {
+        std::vector<uint32_t> edited{};
+        for (int edit = 0; edit < 1 + round % 7; ++edit) {
+            const auto i = static_cast<uint32_t>(rng() % NUM_NODES);
+            edited.push_back(i);
+            switch (rng() % 3) {
+            case 0: hierarchy.SetTranslation(i, RandomVec3(rng, -10.0f, 10.0f)); break;
+            case 1: hierarchy.SetRotation(i, RandomRotation(rng)); break;
+            default: hierarchy.SetScale(i, RandomVec3(rng, 0.5f, 1.5f)); break;
+            }
+        }
+        const std::vector<uint32_t> expected = Subtrees(hierarchy, edited);
+        JMS_CHECK(hierarchy.Update() == expected.size());
+        JMS_CHECK(MatchesBruteForce(hierarchy));
+        JMS_CHECK(AreRangesCanonical(hierarchy.DirtyRanges()));
+        JMS_CHECK(RangeNodes(hierarchy.DirtyRanges()) == expected);
+    }
+}
+
+
+void TestNothingChanged() {
+    std::mt19937 rng{7};
+    TransformHierarchy hierarchy = MakeHierarchy(rng);
+    hierarchy.Update();
+    JMS_CHECK(hierarchy.Update() == 0);
+    JMS_CHECK(hierarchy.DirtyRanges().empty());
+    JMS_CHECK(TransformHierarchy{}.Update() == 0);
+
+    // Upload after an empty Update writes nothing.
+    std::vector<std::byte> bytes((NUM_NODES - 1) * STRIDE + sizeof(glm::mat4), SENTINEL);
+    hierarchy.Upload(bytes, STRIDE);
+    JMS_CHECK(std::ranges::all_of(bytes, [](std::byte b) { return b == SENTINEL; }));
+}
+
+
+// A chain root -> a -> b -> c with a leaf d beside a.  Marking a parent and its descendants dirty recomputes each once.
+void TestDirtyChildUnderDirtyParent() {
+    TransformHierarchy hierarchy{};
+    const uint32_t root = hierarchy.Add(TransformHierarchy::NO_PARENT);
+    const uint32_t a = hierarchy.Add(root, glm::vec3{1.0f, 0.0f, 0.0f});
+    const uint32_t b = hierarchy.Add(a, glm::vec3{0.0f, 2.0f, 0.0f});
+    const uint32_t c = hierarchy.Add(b, glm::vec3{0.0f, 0.0f, 3.0f});
+    const uint32_t d = hierarchy.Add(root, glm::vec3{4.0f, 0.0f, 0.0f});
+    JMS_CHECK(hierarchy.Update() == 5);
+
+    // Children marked before and after their parent.
+    hierarchy.SetTranslation(c, glm::vec3{0.0f, 0.0f, 5.0f});
+    hierarchy.SetScale(a, glm::vec3{2.0f});
+    hierarchy.SetRotation(b, glm::angleAxis(0.5f, glm::vec3{0.0f, 0.0f, 1.0f}));
+    hierarchy.SetTranslation(c, glm::vec3{0.0f, 0.0f, 6.0f});
+    JMS_CHECK(hierarchy.Update() == 3);
+    JMS_CHECK(RangeNodes(hierarchy.DirtyRanges()) == std::vector<uint32_t>{a, b, c});
+    JMS_CHECK(MatchesBruteForce(hierarchy));
+
+    // Every node dirty: each of the 5 computed once.
+    for (uint32_t i : {d, c, b, a, root}) { hierarchy.SetScale(i, glm::vec3{1.0f}); }
+    JMS_CHECK(hierarchy.Update() == 5);
+    hierarchy.MarkAllDirty();
+    JMS_CHECK(hierarchy.Update() == 5);
+    JMS_CHECK(MatchesBruteForce(hierarchy));
+}
+
+
+// Only the matrices of the dirty ranges are written, each at its node's stride offset.
+void TestUpload() {
+    std::mt19937 rng{11};
+    TransformHierarchy hierarchy = MakeHierarchy(rng);
+    hierarchy.Update();
+    std::vector<std::byte> bytes((NUM_NODES - 1) * STRIDE + sizeof(glm::mat4), SENTINEL);
+    hierarchy.Upload(bytes, STRIDE);
+
+    for (uint32_t i : {3u, 500u, 998u}) { hierarchy.SetTranslation(i, glm::vec3{1.0f, 2.0f, 3.0f}); }
+    hierarchy.Update();
+    std::ranges::fill(bytes, SENTINEL);
+    hierarchy.Upload(bytes, STRIDE);
+    const std::vector<uint32_t> written = RangeNodes(hierarchy.DirtyRanges());
+    JMS_CHECK(!written.empty() && written.size() < NUM_NODES);
+    for (uint32_t i = 0; i < NUM_NODES; ++i) {
+        const std::byte* at = bytes.data() + i * STRIDE;
+        if (std::ranges::binary_search(written, i)) {
+            JMS_CHECK(std::memcmp(at, &hierarchy.World(i), sizeof(glm::mat4)) == 0);
+        } else {
+            JMS_CHECK(std::all_of(at, at + sizeof(glm::mat4), [](std::byte b) { return b == SENTINEL; }));
+        }
+        // The padding after each matrix is never written.
+        const std::byte* end = bytes.data() + std::min((i + 1) * STRIDE, bytes.size());
+        JMS_CHECK(std::all_of(at + sizeof(glm::mat4), end, [](std::byte b) { return b == SENTINEL; }));
+    }
+
+    // Tight stride, one memcpy per range.
+    std::vector<std::byte> tight(NUM_NODES * sizeof(glm::mat4), SENTINEL);
+    hierarchy.Upload(tight);
+    for (uint32_t i = 0; i < NUM_NODES; ++i) {
+        const std::byte* at = tight.data() + i * sizeof(glm::mat4);
+        JMS_CHECK(std::ranges::binary_search(written, i) ?
+                  std::memcmp(at, &hierarchy.World(i), sizeof(glm::mat4)) == 0 :
+                  std::all_of(at, at + sizeof(glm::mat4), [](std::byte b) { return b == SENTINEL; }));
+    }
+
+    auto Throws = [](auto&& fn) {
+        try {
+            fn();
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    JMS_CHECK(Throws([&] { hierarchy.Upload(bytes, sizeof(glm::mat4) - 4); }));
+    JMS_CHECK(Throws([&] { hierarchy.Upload(std::span{bytes}.first(bytes.size() - 1), STRIDE); }));
+    JMS_CHECK(Throws([&] { hierarchy.Add(static_cast<uint32_t>(NUM_NODES)); }));
+}
+
+
+}
+
+
+int main() {
+    TestRandomEdits();
+    TestNothingChanged();
+    TestDirtyChildUnderDirtyParent();
+    TestUpload();
+    return jms::tests::Result();
+}
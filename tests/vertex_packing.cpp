@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <numbers>
+#include <random>
+#include <vector>
+
+#include "jms/external/glm.hpp"
+
+#include "jms/graphics/vertex_packing.hpp"
+#include "check.hpp"
+
+
+using namespace jms;
+
+
+namespace {
+
+
+static_assert(FloatToHalf(1.5f) == 0x3e00 && HalfToFloat(0x3e00) == 1.5f);
+static_assert(FloatToHalf(65504.0f) == 0x7bff && FloatToHalf(65520.0f) == 0x7c00);
+
+
+// The bound documented on PackedVertex.
+constexpr float MAX_ANGLE_DEGREES = 0.008f;
+
+
+bool IsNan(uint16_t half) { return (half & 0x7c00u) == 0x7c00u && (half & 0x3ffu) != 0; }
+
+
+float Degrees(const glm::vec3& a, const glm::vec3& b) {
+    return std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b)) * (180.0f / std::numbers::pi_v<float>);
+}
+
+
+// Every half round trips; the midpoint between neighbours rounds to the even one and anything past it to the nearer.
+void TestEveryHalf() {
+    for (uint32_t bits = 0; bits <= 0xffffu; ++bits) {
+        const auto half = static_cast<uint16_t>(bits);
+        const float value = HalfToFloat(half);
+        if (IsNan(half)) {
+            JMS_CHECK(std::isnan(value) && IsNan(FloatToHalf(value)));
+            continue;
+        }
+        JMS_CHECK(FloatToHalf(value) == half);
+
+        // Finite halves below the largest, per sign; the next half up in magnitude is half + 1.
+        if ((half & 0x7fffu) >= 0x7bffu) { continue; }
+        const auto next = static_cast<uint16_t>(half + 1u);
+        const float midpoint = (value + HalfToFloat(next)) * 0.5f;
+        JMS_CHECK(FloatToHalf(midpoint) == ((half & 1u) ? next : half));
+        JMS_CHECK(FloatToHalf(std::nextafter(midpoint, value)) == half);
+        JMS_CHECK(FloatToHalf(std::nextafter(midpoint, HalfToFloat(next))) == next);
+    }
+}
+
+
+void TestHalfEdges() {
+    const float inf = std::numeric_limits<float>::infinity();
+    // Overflow: 65520 is the midpoint between 65504 and the next step, which rounds to even, i.e. infinity.
+    JMS_CHECK(FloatToHalf(std::nextafter(65520.0f, 0.0f)) == 0x7bff);
+    JMS_CHECK(FloatToHalf(65520.0f) == 0x7c00 && FloatToHalf(-65520.0f) == 0xfc00);
+    JMS_CHECK(FloatToHalf(1e10f) == 0x7c00 && FloatToHalf(inf) == 0x7c00 && FloatToHalf(-inf) == 0xfc00);
+    JMS_CHECK(HalfToFloat(0x7c00) == inf && HalfToFloat(0xfc00) == -inf);
+    JMS_CHECK(IsNan(FloatToHalf(std::numeric_limits<float>::quiet_NaN())));
+    JMS_CHECK(IsNan(FloatToHalf(std::bit_cast<float>(0x7f800001u))));
+
+    // Subnormals: 2^-24 is the smallest, 2^-25 rounds to zero and anything above it to 2^-24.
+    JMS_CHECK(FloatToHalf(0x1p-24f) == 0x0001 && HalfToFloat(0x0001) == 0x1p-24f);
+    JMS_CHECK(FloatToHalf(0x1p-25f) == 0x0000 && FloatToHalf(-0x1p-25f) == 0x8000);
+    JMS_CHECK(FloatToHalf(std::nextafter(0x1p-25f, 1.0f)) == 0x0001);
+    JMS_CHECK(FloatToHalf(std::numeric_limits<float>::denorm_min()) == 0x0000);
+    JMS_CHECK(FloatToHalf(0x1p-14f) == 0x0400 && HalfToFloat(0x03ff) == 0x3ffp-24f);
+    JMS_CHECK(FloatToHalf(std::nextafter(0x1p-14f, 0.0f)) == 0x0400);
+    JMS_CHECK(FloatToHalf(-0.0f) == 0x8000 && std::signbit(HalfToFloat(0x8000)));
+}
+
+
+glm::vec3 RandomUnit(std::mt19937& rng) {
+    std::normal_distribution<float> normal{};
+    return glm::normalize(glm::vec3{normal(rng), normal(rng), normal(rng)});
+}
+
+
+std::vector<MeshVertex> MakeVertices(size_t size) {
+    std::mt19937 rng{17};
+    std::uniform_real_distribution<float> position(-50.0f, 80.0f);
+    std::uniform_real_distribution<float> uv(-1.0f, 1.0f);
+    std::vector<MeshVertex> out(size);
+    for (MeshVertex& v : out) {
+        // Different extents and offsets per axis.
+        v.position = {position(rng), position(rng) * 0.01f + 3.0f, position(rng) * 40.0f};
+        v.normal = RandomUnit(rng);
+        v.tangent = glm::vec4{glm::normalize(glm::cross(v.normal, RandomUnit(rng))), (rng() & 1u) ? 1.0f : -1.0f};
+        v.uv = {uv(rng), uv(rng)};
+    }
+    // The axes, the octahedral fold edges and the poles.
+    const glm::vec3 edges[] = {{1.0f, 0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, -1.0f, 0.0f},
+                               {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, -1.0f}, glm::normalize(glm::vec3{1.0f, 1.0f, 0.0f}),
+                               glm::normalize(glm::vec3{-1.0f, 1.0f, -1e-6f}), glm::normalize(glm::vec3{1.0f})};
+    for (size_t i = 0; i < std::size(edges); ++i) {
+        out[i].normal = edges[i];
+        out[i].tangent = glm::vec4{edges[std::size(edges) - 1 - i], 1.0f};
+    }
+    return out;
+}
+
+
+void TestRoundTrip() {
+    const std::vector<MeshVertex> vertices = MakeVertices(100'000);
+    const PackedMesh packed = PackVertices(vertices);
+    const VertexDequantization& dequantization = packed.dequantization;
+    JMS_CHECK(packed.vertices.size() == vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        const MeshVertex& in = vertices[i];
+        const MeshVertex out = UnpackVertex(packed.vertices[i], dequantization);
+        for (glm::length_t axis = 0; axis < 3; ++axis) {
+            const float extent = dequantization.position_scale[axis];
+            const float rounding = 4.0f * std::numeric_limits<float>::epsilon() *
+                                   (std::abs(dequantization.position_offset[axis]) + extent);
+            JMS_CHECK(std::abs(out.position[axis] - in.position[axis]) <= extent / 131070.0f + rounding);
+        }
+        JMS_CHECK(Degrees(out.normal, in.normal) <= MAX_ANGLE_DEGREES);
+        JMS_CHECK(Degrees(glm::vec3{out.tangent}, glm::vec3{in.tangent}) <= MAX_ANGLE_DEGREES);
+        JMS_CHECK(out.tangent.w == in.tangent.w);
+        JMS_CHECK(out.uv.x == HalfToFloat(FloatToHalf(in.uv.x)) && out.uv.y == HalfToFloat(FloatToHalf(in.uv.y)));
+        JMS_CHECK(std::abs(out.uv.x - in.uv.x) <= std::max(std::abs(in.uv.x) * 0x1p-11f, 0x1p-25f));
+    }
+}
+
+
+// A flat axis gets a zero scale and every vertex comes back on it exactly.
+void TestFlatAxis() {
+    std::vector<MeshVertex> vertices = MakeVertices(100);
+    for (MeshVertex& v : vertices) { v.position.y = 2.5f; }
+    const PackedMesh packed = PackVertices(vertices);
+    JMS_CHECK(packed.dequantization.position_scale.y == 0.0f);
+    for (const PackedVertex& v : packed.vertices) {
+        JMS_CHECK(UnpackVertex(v, packed.dequantization).position.y == 2.5f);
+    }
+    JMS_CHECK(PackVertices({}).vertices.empty());
+}
+
+
+}
+
+
+int main() {
+    TestEveryHalf();
+    TestHalfEdges();
+    TestRoundTrip();
+    TestFlatAxis();
+    return jms::tests::Result();
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <execution>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace jms {
+
+
+/***
+ * Fixed size pool of worker threads taking tasks from a single FIFO queue.  Meant for coarse tasks (shader creation,
+ * culling chunks, ...) where one lock per task is noise.  Destruction runs every queued task before joining.
+ */
+class ThreadPool {
+    std::vector<std::jthread> workers{};
+    std::deque<std::move_only_function<void()>> tasks{};
+    std::mutex mutex{};
+    std::condition_variable cv{};
+    bool is_stopping{false};
+
+public:
+    explicit ThreadPool(size_t num_threads = std::max(std::thread::hardware_concurrency(), 1u)) {
+        workers.reserve(std::max(num_threads, static_cast<size_t>(1)));
+        for (size_t i = 0; i < std::max(num_threads, static_cast<size_t>(1)); ++i) {
+            workers.emplace_back([this]() { Run(); });
+        }
+    }
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ~ThreadPool() noexcept {
+        {
+            std::scoped_lock lock{mutex};
+            is_stopping = true;
+        }
+        cv.notify_all();
+        workers.clear();
+    }
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    // Exceptions thrown by fn are rethrown from the future's get.
+    template <typename F>
+    std::future<std::invoke_result_t<std::decay_t<F>>> Submit(F&& fn) {
+        std::packaged_task<std::invoke_result_t<std::decay_t<F>>()> task{std::forward<F>(fn)};
+        auto future = task.get_future();
+        {
+            std::scoped_lock lock{mutex};
+            tasks.emplace_back(std::move(task));
+        }
+        cv.notify_one();
+        return future;
+    }
+
+    size_t NumThreads() const noexcept { return workers.size(); }
+
+private:
+    void Run() {
+        while (true) {
+            std::move_only_function<void()> task{};
+            {
+                std::unique_lock lock{mutex};
+                cv.wait(lock, [this]() { return is_stopping || !tasks.empty(); });
+                if (tasks.empty()) { return; }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+
+/***
+ * Runs fn(i) for i in [0, n) and blocks until every call returned; the first exception is rethrown after that.
+ * Don't call from inside a task of the same pool, it waits on tasks that may be queued behind the caller.
+ */
+template <typename F>
+void ParallelFor(ThreadPool& pool, size_t n, F&& fn) {
+    std::vector<std::future<void>> futures{};
+    futures.reserve(n);
+    for (size_t i = 0; i < n; ++i) { futures.push_back(pool.Submit([&fn, i]() { fn(i); })); }
+    std::exception_ptr error{};
+    for (auto& future : futures) {
+        try {
+            future.get();
+        } catch (...) {
+            if (!error) { error = std::current_exception(); }
+        }
+    }
+    if (error) { std::rethrow_exception(error); }
+}
+
+
+// Same over a standard execution policy; e.g. std::execution::par or std::execution::seq.
+template <typename ExecutionPolicy_t, typename F>
+requires std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy_t>>
+void ParallelFor(ExecutionPolicy_t&& policy, size_t n, F&& fn) {
+    std::vector<size_t> indices(n);
+    for (size_t i = 0; i < n; ++i) { indices[i] = i; }
+    std::for_each(std::forward<ExecutionPolicy_t>(policy), indices.begin(), indices.end(), [&fn](size_t i) { fn(i); });
+}
+
+
+} // namespace jms
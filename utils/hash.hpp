@@ -0,0 +1,53 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+
+namespace jms {
+
+
+/***
+ * FNV-1a 64 bit; fast and good enough for cache keys built from a handful of fields.  Not for untrusted input.
+ * Add only trivially copyable values without padding; e.g. hash the fields of a struct rather than the struct.
+ */
+class Fnv1a64 {
+    static constexpr uint64_t OFFSET_BASIS = 0xcbf29ce484222325ull;
+    static constexpr uint64_t PRIME = 0x100000001b3ull;
+
+    uint64_t value{OFFSET_BASIS};
+
+public:
+    constexpr Fnv1a64& AddBytes(std::span<const std::byte> bytes) noexcept {
+        for (std::byte b : bytes) {
+            value ^= static_cast<uint64_t>(b);
+            value *= PRIME;
+        }
+        return *this;
+    }
+
+    template <typename T>
+    requires (std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>)
+    Fnv1a64& Add(const T& v) noexcept { return AddBytes(std::as_bytes(std::span<const T, 1>{std::addressof(v), 1})); }
+
+    // Length is added so consecutive ranges can't collide by moving elements between them.
+    template <std::ranges::contiguous_range R>
+    requires std::is_trivially_copyable_v<std::ranges::range_value_t<R>>
+    Fnv1a64& AddRange(const R& r) noexcept {
+        Add(static_cast<uint64_t>(std::ranges::size(r)));
+        return AddBytes(std::as_bytes(std::span{std::ranges::data(r), std::ranges::size(r)}));
+    }
+
+    Fnv1a64& Add(std::string_view s) noexcept { return AddRange(s); }
+
+    constexpr uint64_t Value() const noexcept { return value; }
+};
+
+
+} // namespace jms
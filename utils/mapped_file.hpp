@@ -0,0 +1,131 @@
+#pragma once
+
+
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace jms {
+
+
+/***
+ * Read only memory mapping of a whole file.  The file is opened, sized and mapped once; pages are faulted in on first
+ * touch so only the parts read are ever loaded.  Spans from Bytes are valid until the mapping is destroyed or moved
+ * from.  An empty file maps to an empty span.
+ */
+class MappedFile {
+    const std::byte* data{nullptr};
+    size_t size{0};
+#if defined(_WIN32)
+    HANDLE file{INVALID_HANDLE_VALUE};
+    HANDLE mapping{nullptr};
+#endif
+
+public:
+    MappedFile() noexcept = default;
+    explicit MappedFile(const std::filesystem::path& path) {
+#if defined(_WIN32)
+        file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error{std::format("MappedFile: failed to open {}; {}\n", path.string(), GetLastError())};
+        }
+        LARGE_INTEGER file_size{};
+        if (!GetFileSizeEx(file, &file_size)) {
+            auto error = GetLastError();
+            Close();
+            throw std::runtime_error{std::format("MappedFile: failed to size {}; {}\n", path.string(), error)};
+        }
+        size = static_cast<size_t>(file_size.QuadPart);
+        if (size == 0) { return; }
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) { data = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)); }
+        if (!data) {
+            auto error = GetLastError();
+            Close();
+            throw std::runtime_error{std::format("MappedFile: failed to map {}; {}\n", path.string(), error)};
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) { throw std::runtime_error{std::format("MappedFile: failed to open {}\n", path.string())}; }
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error{std::format("MappedFile: failed to size {}\n", path.string())};
+        }
+        size = static_cast<size_t>(st.st_size);
+        if (size > 0) {
+            void* ptr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (ptr == MAP_FAILED) {
+                ::close(fd);
+                size = 0;
+                throw std::runtime_error{std::format("MappedFile: failed to map {}\n", path.string())};
+            }
+            data = static_cast<const std::byte*>(ptr);
+        }
+        // The mapping keeps its own reference to the file.
+        ::close(fd);
+#endif
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept { Swap(other); }
+    ~MappedFile() noexcept { Close(); }
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != std::addressof(other)) {
+            Close();
+            Swap(other);
+        }
+        return *this;
+    }
+
+    std::span<const std::byte> Bytes() const noexcept { return {data, size}; }
+    size_t Size() const noexcept { return size; }
+
+    void Close() noexcept {
+#if defined(_WIN32)
+        if (data) { UnmapViewOfFile(data); }
+        if (mapping) { CloseHandle(mapping); }
+        if (file != INVALID_HANDLE_VALUE) { CloseHandle(file); }
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (data) { ::munmap(const_cast<std::byte*>(data), size); }
+#endif
+        data = nullptr;
+        size = 0;
+    }
+
+private:
+    void Swap(MappedFile& other) noexcept {
+        std::swap(data, other.data);
+        std::swap(size, other.size);
+#if defined(_WIN32)
+        std::swap(file, other.file);
+        std::swap(mapping, other.mapping);
+#endif
+    }
+};
+
+
+} // namespace jms
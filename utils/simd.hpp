@@ -0,0 +1,372 @@
+#pragma once
+
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#endif
+
+// GCC and Clang compile functions with a target attribute whatever the flags, so x86 builds without AVX can still
+// carry an AVX2 path and pick it at run time; see avx2::Lanes.
+#if !defined(__AVX__) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define JMS_SIMD_AVX2_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+// For the functions of kernels templated on Lanes that take or return Float or Mask.  An avx2::Lanes instantiation has
+// to be inlined into its JMS_SIMD_AVX2_TARGET caller; an out of line copy, e.g. at -O0, would pass __m256 without AVX.
+#if defined(JMS_SIMD_AVX2_DISPATCH)
+#define JMS_SIMD_INLINE [[gnu::always_inline]] inline
+#else
+#define JMS_SIMD_INLINE inline
+#endif
+
+
+namespace jms {
+namespace simd {
+
+
+/***
+ * Minimal portable float vector for batch kernels over SoA arrays.  The width is fixed at compile time by the target
+ * flags: 8 lanes with AVX (-mavx2 / /arch:AVX2), 4 lanes with SSE2 or NEON, else 4 lanes of scalar code the compiler
+ * may still vectorize.  Kernels are written once against Float/Mask and loop in steps of WIDTH with a scalar tail.
+ *
+ * Loads and stores are unaligned.  Mask lanes are all ones or all zeros; MaskBits packs lane i into bit i.
+ */
+#if defined(__AVX__)
+
+struct Float { __m256 v; };
+struct Mask { __m256 v; };
+inline constexpr size_t WIDTH = 8;
+
+inline Float Load(const float* p) noexcept { return {_mm256_loadu_ps(p)}; }
+inline void Store(float* p, Float a) noexcept { _mm256_storeu_ps(p, a.v); }
+inline Float Broadcast(float a) noexcept { return {_mm256_set1_ps(a)}; }
+inline Float operator+(Float a, Float b) noexcept { return {_mm256_add_ps(a.v, b.v)}; }
+inline Float operator-(Float a, Float b) noexcept { return {_mm256_sub_ps(a.v, b.v)}; }
+inline Float operator*(Float a, Float b) noexcept { return {_mm256_mul_ps(a.v, b.v)}; }
+inline Float operator/(Float a, Float b) noexcept { return {_mm256_div_ps(a.v, b.v)}; }
+inline Float Min(Float a, Float b) noexcept { return {_mm256_min_ps(a.v, b.v)}; }
+inline Float Max(Float a, Float b) noexcept { return {_mm256_max_ps(a.v, b.v)}; }
+inline Float Abs(Float a) noexcept { return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)}; }
+// a * b + c
+inline Float MulAdd(Float a, Float b, Float c) noexcept {
+#if defined(__FMA__)
+    return {_mm256_fmadd_ps(a.v, b.v, c.v)};
+#else
+    return {_mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v)};
+#endif
+}
+inline Mask operator<(Float a, Float b) noexcept { return {_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)}; }
+inline Mask operator<=(Float a, Float b) noexcept { return {_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)}; }
+inline Mask operator>(Float a, Float b) noexcept { return {_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)}; }
+inline Mask operator>=(Float a, Float b) noexcept { return {_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)}; }
+inline Mask operator&(Mask a, Mask b) noexcept { return {_mm256_and_ps(a.v, b.v)}; }
+inline Mask operator|(Mask a, Mask b) noexcept { return {_mm256_or_ps(a.v, b.v)}; }
+inline Float Select(Mask m, Float a, Float b) noexcept { return {_mm256_blendv_ps(b.v, a.v, m.v)}; }
+inline uint32_t MaskBits(Mask m) noexcept { return static_cast<uint32_t>(_mm256_movemask_ps(m.v)); }
+
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+struct Float { __m128 v; };
+struct Mask { __m128 v; };
+inline constexpr size_t WIDTH = 4;
+
+inline Float Load(const float* p) noexcept { return {_mm_loadu_ps(p)}; }
+inline void Store(float* p, Float a) noexcept { _mm_storeu_ps(p, a.v); }
+inline Float Broadcast(float a) noexcept { return {_mm_set1_ps(a)}; }
+inline Float operator+(Float a, Float b) noexcept { return {_mm_add_ps(a.v, b.v)}; }
+inline Float operator-(Float a, Float b) noexcept { return {_mm_sub_ps(a.v, b.v)}; }
+inline Float operator*(Float a, Float b) noexcept { return {_mm_mul_ps(a.v, b.v)}; }
+inline Float operator/(Float a, Float b) noexcept { return {_mm_div_ps(a.v, b.v)}; }
+inline Float Min(Float a, Float b) noexcept { return {_mm_min_ps(a.v, b.v)}; }
+inline Float Max(Float a, Float b) noexcept { return {_mm_max_ps(a.v, b.v)}; }
+inline Float Abs(Float a) noexcept { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+inline Float MulAdd(Float a, Float b, Float c) noexcept { return {_mm_add_ps(_mm_mul_ps(a.v, b.v), c.v)}; }
+inline Mask operator<(Float a, Float b) noexcept { return {_mm_cmplt_ps(a.v, b.v)}; }
+inline Mask operator<=(Float a, Float b) noexcept { return {_mm_cmple_ps(a.v, b.v)}; }
+inline Mask operator>(Float a, Float b) noexcept { return {_mm_cmpgt_ps(a.v, b.v)}; }
+inline Mask operator>=(Float a, Float b) noexcept { return {_mm_cmpge_ps(a.v, b.v)}; }
+inline Mask operator&(Mask a, Mask b) noexcept { return {_mm_and_ps(a.v, b.v)}; }
+inline Mask operator|(Mask a, Mask b) noexcept { return {_mm_or_ps(a.v, b.v)}; }
+inline Float Select(Mask m, Float a, Float b) noexcept {
+    return {_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v))};
+}
+inline uint32_t MaskBits(Mask m) noexcept { return static_cast<uint32_t>(_mm_movemask_ps(m.v)); }
+
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+
+struct Float { float32x4_t v; };
+struct Mask { uint32x4_t v; };
+inline constexpr size_t WIDTH = 4;
+
+inline Float Load(const float* p) noexcept { return {vld1q_f32(p)}; }
+inline void Store(float* p, Float a) noexcept { vst1q_f32(p, a.v); }
+inline Float Broadcast(float a) noexcept { return {vdupq_n_f32(a)}; }
+inline Float operator+(Float a, Float b) noexcept { return {vaddq_f32(a.v, b.v)}; }
+inline Float operator-(Float a, Float b) noexcept { return {vsubq_f32(a.v, b.v)}; }
+inline Float operator*(Float a, Float b) noexcept { return {vmulq_f32(a.v, b.v)}; }
+inline Float operator/(Float a, Float b) noexcept { return {vdivq_f32(a.v, b.v)}; }
+inline Float Min(Float a, Float b) noexcept { return {vminq_f32(a.v, b.v)}; }
+inline Float Max(Float a, Float b) noexcept { return {vmaxq_f32(a.v, b.v)}; }
+inline Float Abs(Float a) noexcept { return {vabsq_f32(a.v)}; }
+inline Float MulAdd(Float a, Float b, Float c) noexcept { return {vfmaq_f32(c.v, a.v, b.v)}; }
+inline Mask operator<(Float a, Float b) noexcept { return {vcltq_f32(a.v, b.v)}; }
+inline Mask operator<=(Float a, Float b) noexcept { return {vcleq_f32(a.v, b.v)}; }
+inline Mask operator>(Float a, Float b) noexcept { return {vcgtq_f32(a.v, b.v)}; }
+inline Mask operator>=(Float a, Float b) noexcept { return {vcgeq_f32(a.v, b.v)}; }
+inline Mask operator&(Mask a, Mask b) noexcept { return {vandq_u32(a.v, b.v)}; }
+inline Mask operator|(Mask a, Mask b) noexcept { return {vorrq_u32(a.v, b.v)}; }
+inline Float Select(Mask m, Float a, Float b) noexcept { return {vbslq_f32(m.v, a.v, b.v)}; }
+inline uint32_t MaskBits(Mask m) noexcept {
+    static constexpr uint32_t bits[4] = {1, 2, 4, 8};
+    return vaddvq_u32(vandq_u32(m.v, vld1q_u32(bits)));
+}
+
+#else
+
+struct Float { float v[4]; };
+struct Mask { uint32_t v[4]; };
+inline constexpr size_t WIDTH = 4;
+
+namespace detail {
+template <typename Out_t, typename A_t, typename B_t, typename F>
+inline Out_t Lanes(const A_t& a, const B_t& b, F&& f) noexcept {
+    Out_t out{};
+    for (size_t i = 0; i < 4; ++i) { out.v[i] = f(a.v[i], b.v[i]); }
+    return out;
+}
+inline uint32_t ToMask(bool a) noexcept { return a ? ~0u : 0u; }
+} // namespace detail
+
+inline Float Load(const float* p) noexcept { return {{p[0], p[1], p[2], p[3]}}; }
+inline void Store(float* p, Float a) noexcept { for (size_t i = 0; i < 4; ++i) { p[i] = a.v[i]; } }
+inline Float Broadcast(float a) noexcept { return {{a, a, a, a}}; }
+inline Float operator+(Float a, Float b) noexcept {
+    return detail::Lanes<Float>(a, b, [](float x, float y) { return x + y; });
+}
+inline Float operator-(Float a, Float b) noexcept {
+    return detail::Lanes<Float>(a, b, [](float x, float y) { return x - y; });
+}
+inline Float operator*(Float a, Float b) noexcept {
+    return detail::Lanes<Float>(a, b, [](float x, float y) { return x * y; });
+}
+inline Float operator/(Float a, Float b) noexcept {
+    return detail::Lanes<Float>(a, b, [](float x, float y) { return x / y; });
+}
+inline Float Min(Float a, Float b) noexcept {
+    return detail::Lanes<Float>(a, b, [](float x, float y) { return x < y ? x : y; });
+}
+inline Float Max(Float a, Float b) noexcept {
+    return detail::Lanes<Float>(a, b, [](float x, float y) { return x > y ? x : y; });
+}
+inline Float Abs(Float a) noexcept { return detail::Lanes<Float>(a, a, [](float x, float) { return std::fabs(x); }); }
+inline Float MulAdd(Float a, Float b, Float c) noexcept { return a * b + c; }
+inline Mask operator<(Float a, Float b) noexcept {
+    return detail::Lanes<Mask>(a, b, [](float x, float y) { return detail::ToMask(x < y); });
+}
+inline Mask operator<=(Float a, Float b) noexcept {
+    return detail::Lanes<Mask>(a, b, [](float x, float y) { return detail::ToMask(x <= y); });
+}
+inline Mask operator>(Float a, Float b) noexcept {
+    return detail::Lanes<Mask>(a, b, [](float x, float y) { return detail::ToMask(x > y); });
+}
+inline Mask operator>=(Float a, Float b) noexcept {
+    return detail::Lanes<Mask>(a, b, [](float x, float y) { return detail::ToMask(x >= y); });
+}
+inline Mask operator&(Mask a, Mask b) noexcept {
+    return detail::Lanes<Mask>(a, b, [](uint32_t x, uint32_t y) { return x & y; });
+}
+inline Mask operator|(Mask a, Mask b) noexcept {
+    return detail::Lanes<Mask>(a, b, [](uint32_t x, uint32_t y) { return x | y; });
+}
+inline Float Select(Mask m, Float a, Float b) noexcept {
+    Float out{};
+    for (size_t i = 0; i < 4; ++i) { out.v[i] = m.v[i] ? a.v[i] : b.v[i]; }
+    return out;
+}
+inline uint32_t MaskBits(Mask m) noexcept {
+    uint32_t bits = 0;
+    for (size_t i = 0; i < 4; ++i) { bits |= (m.v[i] & 1u) << i; }
+    return bits;
+}
+
+#endif
+
+
+inline constexpr uint32_t ALL_LANES = (1u << WIDTH) - 1u;
+
+
+/***
+ * Appends base + i for each set bit i of bits to out; returns the new count.  With AVX2 it is branch free through a
+ * lane table and always writes WIDTH slots starting at out[count]; out must have room for count + WIDTH indices.
+ * That holds when out is as long as the input and count never runs ahead of the batch being compacted.
+ */
+#if defined(__AVX2__)
+namespace detail {
+// Lane indices of the set bits of every 8 bit mask, packed one per byte.
+inline constexpr auto COMPACT_LANES = []() {
+    std::array<uint64_t, 256> table{};
+    for (uint32_t bits = 0; bits < 256; ++bits) {
+        uint32_t n = 0;
+        for (uint32_t lane = 0; lane < 8; ++lane) {
+            if (bits & (1u << lane)) { table[bits] |= static_cast<uint64_t>(lane) << (8 * n++); }
+        }
+    }
+    return table;
+}();
+} // namespace detail
+
+inline size_t CompactIndices(uint32_t bits, uint32_t base, uint32_t* out, size_t count) noexcept {
+    const __m256i lanes = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(static_cast<int64_t>(detail::COMPACT_LANES[bits])));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + count),
+                        _mm256_add_epi32(lanes, _mm256_set1_epi32(static_cast<int>(base))));
+    return count + static_cast<size_t>(std::popcount(bits));
+}
+#else
+inline size_t CompactIndices(uint32_t bits, uint32_t base, uint32_t* out, size_t count) noexcept {
+    while (bits) {
+        out[count++] = base + static_cast<uint32_t>(std::countr_zero(bits));
+        bits &= bits - 1u;
+    }
+    return count;
+}
+#endif
+
+
+/***
+ * out = a * b for column major 4x4 matrices, e.g. &m[0][0] of a glm::mat4; out may alias a or b.  Column j of out is
+ * the columns of a weighted by the elements of column j of b, so it runs on 4 lanes whatever WIDTH is.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+inline void MultiplyMat4(const float* a, const float* b, float* out) noexcept {
+    const __m128 a0 = _mm_loadu_ps(a);
+    const __m128 a1 = _mm_loadu_ps(a + 4);
+    const __m128 a2 = _mm_loadu_ps(a + 8);
+    const __m128 a3 = _mm_loadu_ps(a + 12);
+    __m128 columns[4];
+    for (size_t j = 0; j < 4; ++j) {
+        const float* bj = b + 4 * j;
+        columns[j] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(bj[0])), _mm_mul_ps(a1, _mm_set1_ps(bj[1]))),
+                                _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(bj[2])), _mm_mul_ps(a3, _mm_set1_ps(bj[3]))));
+    }
+    for (size_t j = 0; j < 4; ++j) { _mm_storeu_ps(out + 4 * j, columns[j]); }
+}
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+inline void MultiplyMat4(const float* a, const float* b, float* out) noexcept {
+    const float32x4_t a0 = vld1q_f32(a);
+    const float32x4_t a1 = vld1q_f32(a + 4);
+    const float32x4_t a2 = vld1q_f32(a + 8);
+    const float32x4_t a3 = vld1q_f32(a + 12);
+    float32x4_t columns[4];
+    for (size_t j = 0; j < 4; ++j) {
+        const float* bj = b + 4 * j;
+        columns[j] = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(a0, bj[0]), a1, bj[1]), a2, bj[2]), a3, bj[3]);
+    }
+    for (size_t j = 0; j < 4; ++j) { vst1q_f32(out + 4 * j, columns[j]); }
+}
+#else
+inline void MultiplyMat4(const float* a, const float* b, float* out) noexcept {
+    float columns[16];
+    for (size_t j = 0; j < 4; ++j) {
+        for (size_t i = 0; i < 4; ++i) {
+            columns[4 * j + i] = a[i] * b[4 * j] + a[4 + i] * b[4 * j + 1] + a[8 + i] * b[4 * j + 2] +
+                                 a[12 + i] * b[4 * j + 3];
+        }
+    }
+    for (size_t i = 0; i < 16; ++i) { out[i] = columns[i]; }
+}
+#endif
+
+
+/***
+ * The operations above as static members, for kernels templated on the lane type so they can also be instantiated
+ * with avx2::Lanes.  Float and Mask operators are found by argument dependent lookup.
+ */
+struct Lanes {
+    using Float = simd::Float;
+    using Mask = simd::Mask;
+    static constexpr size_t WIDTH = simd::WIDTH;
+
+    static Float Load(const float* p) noexcept { return simd::Load(p); }
+    static void Store(float* p, Float a) noexcept { simd::Store(p, a); }
+    static Float Broadcast(float a) noexcept { return simd::Broadcast(a); }
+    static Float Min(Float a, Float b) noexcept { return simd::Min(a, b); }
+    static Float Max(Float a, Float b) noexcept { return simd::Max(a, b); }
+    static Float MulAdd(Float a, Float b, Float c) noexcept { return simd::MulAdd(a, b, c); }
+    static Float Select(Mask m, Float a, Float b) noexcept { return simd::Select(m, a, b); }
+};
+
+
+#if defined(JMS_SIMD_AVX2_DISPATCH)
+
+/***
+ * 8 lanes of AVX2 and FMA in a build that doesn't enable them.  Only call into these after HasAvx2() from a function
+ * with JMS_SIMD_AVX2_TARGET; flatten there inlines a kernel templated on Lanes together with these operations, so the
+ * whole loop is compiled for AVX2 while the rest of the program stays on the baseline.
+ */
+#define JMS_SIMD_AVX2_TARGET gnu::target("avx2,fma")
+namespace avx2 {
+
+struct Float { __m256 v; };
+struct Mask { __m256 v; };
+
+[[JMS_SIMD_AVX2_TARGET]] inline Float operator+(Float a, Float b) noexcept { return {_mm256_add_ps(a.v, b.v)}; }
+[[JMS_SIMD_AVX2_TARGET]] inline Float operator-(Float a, Float b) noexcept { return {_mm256_sub_ps(a.v, b.v)}; }
+[[JMS_SIMD_AVX2_TARGET]] inline Float operator*(Float a, Float b) noexcept { return {_mm256_mul_ps(a.v, b.v)}; }
+[[JMS_SIMD_AVX2_TARGET]] inline Float operator/(Float a, Float b) noexcept { return {_mm256_div_ps(a.v, b.v)}; }
+[[JMS_SIMD_AVX2_TARGET]] inline Mask operator<(Float a, Float b) noexcept {
+    return {_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)};
+}
+[[JMS_SIMD_AVX2_TARGET]] inline Mask operator<=(Float a, Float b) noexcept {
+    return {_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)};
+}
+[[JMS_SIMD_AVX2_TARGET]] inline Mask operator>(Float a, Float b) noexcept {
+    return {_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)};
+}
+[[JMS_SIMD_AVX2_TARGET]] inline Mask operator>=(Float a, Float b) noexcept {
+    return {_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)};
+}
+[[JMS_SIMD_AVX2_TARGET]] inline Mask operator&(Mask a, Mask b) noexcept { return {_mm256_and_ps(a.v, b.v)}; }
+[[JMS_SIMD_AVX2_TARGET]] inline Mask operator|(Mask a, Mask b) noexcept { return {_mm256_or_ps(a.v, b.v)}; }
+
+struct Lanes {
+    using Float = avx2::Float;
+    using Mask = avx2::Mask;
+    static constexpr size_t WIDTH = 8;
+
+    [[JMS_SIMD_AVX2_TARGET]] static Float Load(const float* p) noexcept { return {_mm256_loadu_ps(p)}; }
+    [[JMS_SIMD_AVX2_TARGET]] static void Store(float* p, Float a) noexcept { _mm256_storeu_ps(p, a.v); }
+    [[JMS_SIMD_AVX2_TARGET]] static Float Broadcast(float a) noexcept { return {_mm256_set1_ps(a)}; }
+    [[JMS_SIMD_AVX2_TARGET]] static Float Min(Float a, Float b) noexcept { return {_mm256_min_ps(a.v, b.v)}; }
+    [[JMS_SIMD_AVX2_TARGET]] static Float Max(Float a, Float b) noexcept { return {_mm256_max_ps(a.v, b.v)}; }
+    [[JMS_SIMD_AVX2_TARGET]] static Float MulAdd(Float a, Float b, Float c) noexcept {
+        return {_mm256_fmadd_ps(a.v, b.v, c.v)};
+    }
+    [[JMS_SIMD_AVX2_TARGET]] static Float Select(Mask m, Float a, Float b) noexcept {
+        return {_mm256_blendv_ps(b.v, a.v, m.v)};
+    }
+};
+
+// Checked once.
+inline bool HasAvx2() noexcept {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return has_avx2;
+}
+
+} // namespace avx2
+
+#endif
+
+
+} // namespace simd
+} // namespace jms
@@ -0,0 +1,255 @@
+#pragma once
+
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <format>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "jms/vulkan/vulkan.hpp"
+#include "jms/vulkan/shader.hpp"
+#include "jms/vulkan/utils.hpp"
+
+
+namespace jms {
+namespace vulkan {
+
+
+/***
+ * Free list of descriptor array slots.  Released slots are not reused until the GPU is known to be finished with
+ * them; i.e. Release records the frame (or timeline) value that last used the slot and Collect returns slots to the
+ * free list once the fence/semaphore for that value has been observed as complete.
+ */
+class BindlessSlotAllocator {
+    uint32_t capacity{0};
+    uint32_t next_unused{0};
+    std::vector<uint32_t> free_slots{};
+    std::deque<std::tuple<uint64_t, uint32_t>> pending{};
+
+public:
+    BindlessSlotAllocator() noexcept = default;
+    BindlessSlotAllocator(uint32_t capacity) noexcept : capacity{capacity} {}
+    BindlessSlotAllocator(const BindlessSlotAllocator&) = default;
+    BindlessSlotAllocator(BindlessSlotAllocator&&) noexcept = default;
+    ~BindlessSlotAllocator() noexcept = default;
+    BindlessSlotAllocator& operator=(const BindlessSlotAllocator&) = default;
+    BindlessSlotAllocator& operator=(BindlessSlotAllocator&&) noexcept = default;
+
+    uint32_t Allocate() {
+        if (!free_slots.empty()) {
+            uint32_t slot = free_slots.back();
+            free_slots.pop_back();
+            return slot;
+        }
+        if (next_unused < capacity) { return next_unused++; }
+        throw std::runtime_error{std::format("BindlessSlotAllocator: all {} slots are in use.\n", capacity)};
+    }
+
+    // retire_value must be monotonically non-decreasing across calls.
+    void Release(uint32_t slot, uint64_t retire_value) {
+        if (slot >= next_unused) { throw std::runtime_error{"BindlessSlotAllocator: releasing unallocated slot."}; }
+        pending.emplace_back(retire_value, slot);
+    }
+
+    void Collect(uint64_t completed_value) {
+        while (!pending.empty() && std::get<0>(pending.front()) <= completed_value) {
+            free_slots.push_back(std::get<1>(pending.front()));
+            pending.pop_front();
+        }
+    }
+
+    uint32_t Capacity() const noexcept { return capacity; }
+    size_t NumPending() const noexcept { return pending.size(); }
+    size_t NumAvailable() const noexcept { return free_slots.size() + (capacity - next_unused); }
+};
+
+
+struct BindlessResourceKind {
+    vk::DescriptorType descriptor_type{vk::DescriptorType::eSampledImage};
+    uint32_t capacity{0};
+    vk::ShaderStageFlags stage_flags{vk::ShaderStageFlagBits::eAll};
+};
+
+
+/***
+ * One large update after bind, partially bound descriptor set per resource kind; each set has a single binding (0)
+ * that is an array of capacity descriptors.  Shaders index the array with the integer handle returned by Allocate.
+ *
+ * Use AddToShaderGroup before constructing a GraphicsPass so the pass layouts are identical to (compatible with)
+ * the table layouts.  The sets are bound once with Bind and left bound across material changes.
+ *
+ * Requires descriptorIndexing features: descriptorBindingPartiallyBound, runtimeDescriptorArray and the relevant
+ * descriptorBinding*UpdateAfterBind feature for each kind.
+ */
+class BindlessTable {
+    struct Kind {
+        BindlessResourceKind info;
+        vk::raii::DescriptorSetLayout layout;
+        vk::DescriptorSet set;
+        BindlessSlotAllocator slots;
+    };
+
+    static constexpr vk::DescriptorBindingFlags BINDING_FLAGS = vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+                                                                vk::DescriptorBindingFlagBits::ePartiallyBound |
+                                                                vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+    static constexpr vk::DescriptorSetLayoutCreateFlags LAYOUT_FLAGS =
+        vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool;
+
+    vk::raii::Device* device{nullptr};
+    vk::raii::DescriptorPool pool{nullptr};
+    std::vector<Kind> kinds{};
+
+public:
+    BindlessTable(vk::raii::Device& device,
+                  const std::vector<BindlessResourceKind>& resource_kinds,
+                  std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt)
+    : device{std::addressof(device)}
+    {
+        if (resource_kinds.empty()) { throw std::runtime_error{"BindlessTable requires at least one resource kind."}; }
+
+        std::vector<vk::DescriptorPoolSize> pool_sizes{};
+        pool_sizes.reserve(resource_kinds.size());
+        std::ranges::transform(resource_kinds, std::back_inserter(pool_sizes), [](const auto& kind) {
+            return vk::DescriptorPoolSize{.type=kind.descriptor_type, .descriptorCount=kind.capacity};
+        });
+        pool = device.createDescriptorPool({
+            .flags=vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
+            .maxSets=static_cast<uint32_t>(resource_kinds.size()),
+            .poolSizeCount=static_cast<uint32_t>(pool_sizes.size()),
+            .pPoolSizes=VectorAsPtr(pool_sizes)
+        }, vk_allocation_callbacks.value_or(nullptr));
+
+        kinds.reserve(resource_kinds.size());
+        for (const auto& kind : resource_kinds) {
+            if (kind.capacity < 1) { throw std::runtime_error{"BindlessTable resource kind requires a capacity."}; }
+            vk::DescriptorSetLayoutBinding binding = Binding(kind);
+            vk::DescriptorBindingFlags binding_flags = BINDING_FLAGS;
+            vk::DescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info{
+                .bindingCount=1,
+                .pBindingFlags=std::addressof(binding_flags)
+            };
+            vk::raii::DescriptorSetLayout layout = device.createDescriptorSetLayout({
+                .pNext=std::addressof(binding_flags_info),
+                .flags=LAYOUT_FLAGS,
+                .bindingCount=1,
+                .pBindings=std::addressof(binding)
+            }, vk_allocation_callbacks.value_or(nullptr));
+            // Sets are freed with the pool; see GraphicsPass::CreateDescriptorSets
+            auto raii_sets = device.allocateDescriptorSets({
+                .descriptorPool=*pool,
+                .descriptorSetCount=1,
+                .pSetLayouts=std::addressof(*layout)
+            });
+            vk::DescriptorSet set = raii_sets.at(0).release();
+            kinds.push_back({
+                .info=kind,
+                .layout=std::move(layout),
+                .set=set,
+                .slots=BindlessSlotAllocator{kind.capacity}
+            });
+        }
+    }
+    BindlessTable(const BindlessTable&) = delete;
+    BindlessTable(BindlessTable&&) noexcept = default;
+    ~BindlessTable() noexcept = default;
+    BindlessTable& operator=(const BindlessTable&) = delete;
+    BindlessTable& operator=(BindlessTable&&) noexcept = default;
+
+    // Appends one set per kind to the group and returns the set index of the first.  Shader layouts are indexed by
+    // set number so every shader in the group is given the full list of sets.
+    size_t AddToShaderGroup(ShaderGroup& shader_group) const {
+        size_t first_set = shader_group.set_layout_bindings.size();
+        shader_group.set_layout_flags.resize(first_set);
+        shader_group.set_layout_binding_flags.resize(first_set);
+        for (const auto& kind : kinds) {
+            shader_group.set_layout_bindings.push_back({Binding(kind.info)});
+            shader_group.set_layout_flags.push_back(LAYOUT_FLAGS);
+            shader_group.set_layout_binding_flags.push_back({BINDING_FLAGS});
+        }
+        for (auto& info : shader_group.shader_infos) {
+            info.set_info_indices.clear();
+            std::ranges::copy(std::views::iota(static_cast<size_t>(0), first_set + kinds.size()),
+                              std::back_inserter(info.set_info_indices));
+        }
+        return first_set;
+    }
+
+    uint32_t Allocate(size_t kind_index) { return kinds.at(kind_index).slots.Allocate(); }
+
+    // retire_value is the frame/timeline value of the last submission that may reference the slot.
+    void Release(size_t kind_index, uint32_t slot, uint64_t retire_value) {
+        kinds.at(kind_index).slots.Release(slot, retire_value);
+    }
+
+    // Call once the fence/semaphore for completed_value is signaled.
+    void Collect(uint64_t completed_value) {
+        for (auto& kind : kinds) { kind.slots.Collect(completed_value); }
+    }
+
+    void WriteBuffer(size_t kind_index, uint32_t slot, const vk::DescriptorBufferInfo& info) {
+        auto write = WriteInfo(kind_index, slot);
+        write.pBufferInfo = std::addressof(info);
+        device->updateDescriptorSets({write}, {});
+    }
+
+    void WriteImage(size_t kind_index, uint32_t slot, const vk::DescriptorImageInfo& info) {
+        auto write = WriteInfo(kind_index, slot);
+        write.pImageInfo = std::addressof(info);
+        device->updateDescriptorSets({write}, {});
+    }
+
+    void WriteTexel(size_t kind_index, uint32_t slot, const vk::BufferView& view) {
+        auto write = WriteInfo(kind_index, slot);
+        write.pTexelBufferView = std::addressof(view);
+        device->updateDescriptorSets({write}, {});
+    }
+
+    void Bind(vk::raii::CommandBuffer& command_buffer,
+              const vk::raii::PipelineLayout& pipeline_layout,
+              size_t first_set,
+              vk::PipelineBindPoint bind_point = vk::PipelineBindPoint::eGraphics) const {
+        std::vector<vk::DescriptorSet> sets{};
+        sets.reserve(kinds.size());
+        std::ranges::transform(kinds, std::back_inserter(sets), &Kind::set);
+        command_buffer.bindDescriptorSets(bind_point, *pipeline_layout, static_cast<uint32_t>(first_set), sets, {});
+    }
+
+    size_t NumKinds() const noexcept { return kinds.size(); }
+
+private:
+    static vk::DescriptorSetLayoutBinding Binding(const BindlessResourceKind& kind) noexcept {
+        return {
+            .binding=0,
+            .descriptorType=kind.descriptor_type,
+            .descriptorCount=kind.capacity,
+            .stageFlags=kind.stage_flags,
+            .pImmutableSamplers=nullptr
+        };
+    }
+
+    vk::WriteDescriptorSet WriteInfo(size_t kind_index, uint32_t slot) const {
+        const Kind& kind = kinds.at(kind_index);
+        if (slot >= kind.info.capacity) {
+            throw std::runtime_error{std::format("BindlessTable: slot {} out of range {}\n", slot, kind.info.capacity)};
+        }
+        return vk::WriteDescriptorSet{
+            .dstSet=kind.set,
+            .dstBinding=0,
+            .dstArrayElement=slot,
+            .descriptorCount=1,
+            .descriptorType=kind.info.descriptor_type,
+            .pImageInfo=nullptr,
+            .pBufferInfo=nullptr,
+            .pTexelBufferView=nullptr
+        };
+    }
+};
+
+
+}
+}
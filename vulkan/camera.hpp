@@ -5,6 +5,7 @@
 
 #include "jms/external/glm.hpp"
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #include "jms/vulkan/vulkan.hpp"
 
@@ -18,8 +19,7 @@ namespace vulkan {
 
 /***
 
-TODO: Projection data structure that not only defines the explicit parameters but other bits (or derive them) to
-denote things like [-1..1] vs [0..1], reversed z-order, and infinite z.
+Projection data: see jms::Projection in graphics/projection.hpp for depth range, reversed-Z and infinite far.
 
 Camera should simply be a normal object, perhaps include a "lens" or projection attachment.
 
@@ -29,16 +29,30 @@ separate and in addition to being set with the camera.
 */
 
 
-struct Camera {
+/***
+ * Orientation is a quaternion; rotation angles are (pitch, roll, yaw) about the (x, y, z) axes applied in the order
+ * yaw, pitch, roll as before.  The view and view projection matrices are cached and only rebuilt after a change; the
+ * view is built analytically (transposed rotation, negated rotated translation) since the camera has no scale.
+ */
+class Camera {
     // state
     glm::mat4 projection{1.0f};
     glm::vec3 position{0.0f};
-    glm::vec3 rotation_angles{0.0f};
-
+    glm::quat orientation{1.0f, 0.0f, 0.0f, 0.0f};
+    // cache
+    mutable glm::mat4 view{1.0f};
+    mutable glm::mat4 view_projection{1.0f};
+    mutable bool is_view_dirty{true};
+    mutable bool is_view_projection_dirty{true};
+
+public:
     Camera() noexcept = default;
     Camera(const glm::mat4& a) noexcept : projection{a} {}
     Camera(const glm::mat4& a, const glm::vec3& p, const glm::vec3& r) noexcept
-    : projection{a}, position{p}, rotation_angles{r}
+    : projection{a}, position{p}, orientation{OrientationFromAngles(r)}
+    {}
+    Camera(const glm::mat4& a, const glm::vec3& p, const glm::quat& q) noexcept
+    : projection{a}, position{p}, orientation{glm::normalize(q)}
     {}
     Camera(const Camera&) = default;
     Camera(Camera&&) noexcept = default;
@@ -46,31 +60,68 @@ struct Camera {
     Camera& operator=(const Camera&) = default;
     Camera& operator=(Camera&&) noexcept = default;
 
-    void SetPosition(const glm::vec3& a) { position = a; }
-    void SetRotation(const glm::vec3& a) { rotation_angles = a; }
+    static glm::quat OrientationFromAngles(const glm::vec3& angles) noexcept {
+        return glm::angleAxis(angles.z, glm::vec3(0.0f, 0.0f, 1.0f)) * // yaw
+               glm::angleAxis(angles.x, glm::vec3(1.0f, 0.0f, 0.0f)) * // pitch
+               glm::angleAxis(angles.y, glm::vec3(0.0f, 1.0f, 0.0f));  // roll
+    }
 
-    void Update(const glm::vec3& delta_translation, const glm::vec3& delta_angles) {
+    const glm::mat4& Projection() const noexcept { return projection; }
+    const glm::vec3& Position() const noexcept { return position; }
+    const glm::quat& Orientation() const noexcept { return orientation; }
+
+    void SetProjection(const glm::mat4& a) noexcept {
+        projection = a;
+        is_view_projection_dirty = true;
+    }
+    void SetPosition(const glm::vec3& a) noexcept {
+        position = a;
+        MarkDirty();
+    }
+    void SetRotation(const glm::vec3& a) noexcept { SetOrientation(OrientationFromAngles(a)); }
+    void SetOrientation(const glm::quat& a) noexcept {
+        orientation = glm::normalize(a);
+        MarkDirty();
+    }
+
+    /***
+     * Translation is in the camera's frame.  Yaw turns about the world z axis while pitch and roll turn about the
+     * camera's own axes, so repeated pitch and yaw deltas don't accumulate roll.
+     */
+    void Update(const glm::vec3& delta_translation, const glm::vec3& delta_angles) noexcept {
         // Reference: https://thinkinginsideadifferentbox.wordpress.com/2020/09/22/rotation-matrices-and-looking-at-a-thing-the-easy-way/
-        glm::mat4 rot{1.0f};
-        rot = glm::rotate(rot, rotation_angles.z, glm::vec3(0.0f, 0.0f, 1.0f)); // yaw
-        rot = glm::rotate(rot, rotation_angles.x, glm::vec3(1.0f, 0.0f, 0.0f)); // pitch
-        rot = glm::rotate(rot, rotation_angles.y, glm::vec3(0.0f, 1.0f, 0.0f)); // roll
-        position += glm::vec3(delta_translation.x * rot[0]) +
-                    glm::vec3(delta_translation.y * rot[1]) +
-                    glm::vec3(delta_translation.z * rot[2]);
-        rotation_angles = glm::mod(rotation_angles + delta_angles,
-                                   {glm::two_pi<float>(), glm::two_pi<float>(), glm::two_pi<float>()});
+        position += orientation * delta_translation;
+        orientation = glm::normalize(glm::angleAxis(delta_angles.z, glm::vec3(0.0f, 0.0f, 1.0f)) *
+                                     orientation *
+                                     glm::angleAxis(delta_angles.x, glm::vec3(1.0f, 0.0f, 0.0f)) *
+                                     glm::angleAxis(delta_angles.y, glm::vec3(0.0f, 1.0f, 0.0f)));
+        MarkDirty();
+    }
+
+    // World to camera; the inverse of translate(position) * rotate(orientation).
+    const glm::mat4& View() const noexcept {
+        if (is_view_dirty) {
+            const glm::mat3 inverse_rotation = glm::transpose(glm::mat3_cast(orientation));
+            view = glm::mat4{inverse_rotation};
+            view[3] = glm::vec4{-(inverse_rotation * position), 1.0f};
+            is_view_dirty = false;
+        }
+        return view;
+    }
+
+    // Projection * View
+    const glm::mat4& ViewProjection() const noexcept {
+        if (is_view_projection_dirty) {
+            view_projection = projection * View();
+            is_view_projection_dirty = false;
+        }
+        return view_projection;
     }
 
-    glm::mat4 View() const {
-        glm::mat4 tra = glm::translate(glm::mat4{1.0f}, position);
-        glm::mat4 rot{1.0f};
-        rot = glm::rotate(rot, rotation_angles.z, glm::vec3(0.0f, 0.0f, 1.0f)); // yaw
-        rot = glm::rotate(rot, rotation_angles.x, glm::vec3(1.0f, 0.0f, 0.0f)); // pitch
-        rot = glm::rotate(rot, rotation_angles.y, glm::vec3(0.0f, 1.0f, 0.0f)); // roll
-        glm::mat4 rot_origin = rot * tra;
-        glm::mat4 rot_self = tra * rot;
-        return projection * glm::inverse(rot_self);
+private:
+    void MarkDirty() noexcept {
+        is_view_dirty = true;
+        is_view_projection_dirty = true;
     }
 };
 
@@ -0,0 +1,237 @@
+#pragma once
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "jms/external/glm.hpp"
+#include <glm/gtc/quaternion.hpp>
+
+#include "jms/graphics/projection.hpp"
+#include "jms/utils/simd.hpp"
+#include "jms/vulkan/std_layout.hpp"
+
+
+namespace jms {
+namespace vulkan {
+
+
+/***
+ * Per camera block as written by CameraSet::Update.  Only mat4 and vec4 members so the std140 and std430 layouts are
+ * both the C++ layout; 208 bytes, a multiple of 16 as std140 requires of array strides.
+ *
+ * GLSL: struct Camera { mat4 view; mat4 projection; mat4 view_projection; vec4 position; };
+ */
+struct CameraGpuData {
+    glm::mat4 view{1.0f};
+    glm::mat4 projection{1.0f};
+    glm::mat4 view_projection{1.0f};
+    glm::vec4 position{0.0f, 0.0f, 0.0f, 1.0f};
+};
+using CameraGpuLayout = StructLayout<BufferLayout::STD140, &CameraGpuData::view, &CameraGpuData::projection,
+                                     &CameraGpuData::view_projection, &CameraGpuData::position>;
+static_assert(CameraGpuLayout::IsCppLayout({offsetof(CameraGpuData, view), offsetof(CameraGpuData, projection),
+                                            offsetof(CameraGpuData, view_projection),
+                                            offsetof(CameraGpuData, position)}));
+
+
+/***
+ * Many views (shadow cascades, probe faces, split screen) in structure of arrays form.  Update computes every view
+ * and view projection matrix WIDTH cameras at a time and writes them straight to mapped memory in one linear pass.
+ *
+ * The view is the inverse of translate(position) * rotate(orientation) as with Camera.  Projections are kept as their
+ * Projection terms; P * V is then a few multiplies per row rather than a 4x4 matrix product.
+ */
+class CameraSet {
+    size_t size{0};
+    // SoA, padded to a multiple of simd::WIDTH so batches never read past the end.
+    std::vector<float> position_x{};
+    std::vector<float> position_y{};
+    std::vector<float> position_z{};
+    std::vector<float> orientation_x{};
+    std::vector<float> orientation_y{};
+    std::vector<float> orientation_z{};
+    std::vector<float> orientation_w{};
+    std::vector<float> x_scale{};
+    std::vector<float> y_scale{};
+    std::vector<float> z_scale{};
+    std::vector<float> z_offset{};
+    std::vector<float> x_offset{};
+    std::vector<float> y_offset{};
+    // 1 for perspective (w_c = z), 0 for orthographic (w_c = 1)
+    std::vector<float> perspective{};
+
+public:
+    CameraSet() noexcept = default;
+    CameraSet(const CameraSet&) = default;
+    CameraSet(CameraSet&&) noexcept = default;
+    ~CameraSet() noexcept = default;
+    CameraSet& operator=(const CameraSet&) = default;
+    CameraSet& operator=(CameraSet&&) noexcept = default;
+
+    size_t Add(const Projection& projection, const glm::vec3& position, const glm::quat& orientation) {
+        const size_t index = size++;
+        const size_t padded = ((size + simd::WIDTH - 1) / simd::WIDTH) * simd::WIDTH;
+        for (auto* v : {&position_x, &position_y, &position_z, &orientation_x, &orientation_y, &orientation_z,
+                        &x_scale, &y_scale, &z_scale, &z_offset, &x_offset, &y_offset, &perspective}) {
+            v->resize(padded, 0.0f);
+        }
+        orientation_w.resize(padded, 1.0f);
+        SetProjection(index, projection);
+        SetPosition(index, position);
+        SetOrientation(index, orientation);
+        return index;
+    }
+
+    void Clear() noexcept {
+        size = 0;
+        for (auto* v : {&position_x, &position_y, &position_z, &orientation_x, &orientation_y, &orientation_z,
+                        &orientation_w, &x_scale, &y_scale, &z_scale, &z_offset, &x_offset, &y_offset, &perspective}) {
+            v->clear();
+        }
+    }
+
+    size_t Size() const noexcept { return size; }
+
+    void SetProjection(size_t index, const Projection& projection) {
+        CheckIndex(index);
+        x_scale[index] = projection.x_scale;
+        y_scale[index] = projection.y_scale;
+        z_scale[index] = projection.z_scale;
+        z_offset[index] = projection.z_offset;
+        x_offset[index] = projection.is_perspective ? 0.0f : projection.x_offset;
+        y_offset[index] = projection.is_perspective ? 0.0f : projection.y_offset;
+        perspective[index] = projection.is_perspective ? 1.0f : 0.0f;
+    }
+
+    void SetPosition(size_t index, const glm::vec3& position) {
+        CheckIndex(index);
+        position_x[index] = position.x;
+        position_y[index] = position.y;
+        position_z[index] = position.z;
+    }
+
+    void SetOrientation(size_t index, const glm::quat& orientation) {
+        CheckIndex(index);
+        const glm::quat q = glm::normalize(orientation);
+        orientation_x[index] = q.x;
+        orientation_y[index] = q.y;
+        orientation_z[index] = q.z;
+        orientation_w[index] = q.w;
+    }
+
+    glm::vec3 Position(size_t index) const {
+        CheckIndex(index);
+        return {position_x[index], position_y[index], position_z[index]};
+    }
+
+    glm::quat Orientation(size_t index) const {
+        CheckIndex(index);
+        return {orientation_w[index], orientation_x[index], orientation_y[index], orientation_z[index]};
+    }
+
+    /***
+     * Writes one CameraGpuData per camera at out[i * stride]; e.g. a mapped uniform or storage buffer, with stride
+     * rounded up to minUniformBufferOffsetAlignment when cameras are selected by dynamic offset.
+     */
+    void Update(std::span<std::byte> out, size_t stride = sizeof(CameraGpuData)) const {
+        if (stride < sizeof(CameraGpuData)) {
+            throw std::runtime_error{std::format("CameraSet::Update: stride {} is less than {}.\n",
+                                                 stride, sizeof(CameraGpuData))};
+        }
+        if (size && out.size() < (size - 1) * stride + sizeof(CameraGpuData)) {
+            throw std::runtime_error{std::format("CameraSet::Update: {} bytes can't hold {} cameras.\n",
+                                                 out.size(), size)};
+        }
+
+        const simd::Float zero = simd::Broadcast(0.0f);
+        const simd::Float one = simd::Broadcast(1.0f);
+        const simd::Float two = simd::Broadcast(2.0f);
+        for (size_t base = 0; base < size; base += simd::WIDTH) {
+            const simd::Float qx = simd::Load(orientation_x.data() + base);
+            const simd::Float qy = simd::Load(orientation_y.data() + base);
+            const simd::Float qz = simd::Load(orientation_z.data() + base);
+            const simd::Float qw = simd::Load(orientation_w.data() + base);
+            const simd::Float px = simd::Load(position_x.data() + base);
+            const simd::Float py = simd::Load(position_y.data() + base);
+            const simd::Float pz = simd::Load(position_z.data() + base);
+
+            // Rows of the view rotation are the columns of the orientation's rotation matrix.
+            const simd::Float xx = qx * qx, yy = qy * qy, zz = qz * qz;
+            const simd::Float xy = qx * qy, xz = qx * qz, yz = qy * qz;
+            const simd::Float wx = qw * qx, wy = qw * qy, wz = qw * qz;
+            simd::Float view[3][4] = {
+                {one - two * (yy + zz), two * (xy + wz), two * (xz - wy), zero},
+                {two * (xy - wz), one - two * (xx + zz), two * (yz + wx), zero},
+                {two * (xz + wy), two * (yz - wx), one - two * (xx + yy), zero}
+            };
+            for (auto& row : view) { row[3] = zero - simd::MulAdd(row[0], px, simd::MulAdd(row[1], py, row[2] * pz)); }
+
+            const simd::Float sx = simd::Load(x_scale.data() + base);
+            const simd::Float sy = simd::Load(y_scale.data() + base);
+            const simd::Float zs = simd::Load(z_scale.data() + base);
+            const simd::Float zo = simd::Load(z_offset.data() + base);
+            const simd::Float ox = simd::Load(x_offset.data() + base);
+            const simd::Float oy = simd::Load(y_offset.data() + base);
+            const simd::Float p = simd::Load(perspective.data() + base);
+            const simd::Float not_p = one - p;
+
+            // Rows of P are (sx, 0, 0, ox), (0, sy, 0, oy), (0, 0, zs, zo), (0, 0, p, 1 - p) and V's last row is
+            // (0, 0, 0, 1), so each row of P * V is a scaled row of V plus a constant in w.
+            const simd::Float view_projection[4][4] = {
+                {sx * view[0][0], sx * view[0][1], sx * view[0][2], simd::MulAdd(sx, view[0][3], ox)},
+                {sy * view[1][0], sy * view[1][1], sy * view[1][2], simd::MulAdd(sy, view[1][3], oy)},
+                {zs * view[2][0], zs * view[2][1], zs * view[2][2], simd::MulAdd(zs, view[2][3], zo)},
+                {p * view[2][0], p * view[2][1], p * view[2][2], simd::MulAdd(p, view[2][3], not_p)}
+            };
+
+            // Transpose WIDTH cameras out of the registers; [row][column][lane]
+            float view_lanes[3][4][simd::WIDTH];
+            float view_projection_lanes[4][4][simd::WIDTH];
+            for (size_t r = 0; r < 4; ++r) {
+                for (size_t c = 0; c < 4; ++c) {
+                    if (r < 3) { simd::Store(view_lanes[r][c], view[r][c]); }
+                    simd::Store(view_projection_lanes[r][c], view_projection[r][c]);
+                }
+            }
+
+            const size_t num_lanes = std::min(simd::WIDTH, size - base);
+            for (size_t lane = 0; lane < num_lanes; ++lane) {
+                const size_t i = base + lane;
+                CameraGpuData data{};
+                for (glm::length_t r = 0; r < 4; ++r) {
+                    for (glm::length_t c = 0; c < 4; ++c) {
+                        if (r < 3) { data.view[c][r] = view_lanes[r][c][lane]; }
+                        data.view_projection[c][r] = view_projection_lanes[r][c][lane];
+                    }
+                }
+                data.projection = glm::mat4{0.0f};
+                data.projection[0][0] = x_scale[i];
+                data.projection[1][1] = y_scale[i];
+                data.projection[2][2] = z_scale[i];
+                data.projection[3][2] = z_offset[i];
+                data.projection[3][0] = x_offset[i];
+                data.projection[3][1] = y_offset[i];
+                data.projection[2][3] = perspective[i];
+                data.projection[3][3] = 1.0f - perspective[i];
+                data.position = {position_x[i], position_y[i], position_z[i], 1.0f};
+                std::memcpy(out.data() + i * stride, std::addressof(data), sizeof(CameraGpuData));
+            }
+        }
+    }
+
+private:
+    void CheckIndex(size_t index) const {
+        if (index >= size) { throw std::runtime_error{std::format("CameraSet: index {} >= size {}.\n", index, size)}; }
+    }
+};
+
+
+}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+
+#include <algorithm>
+#include <format>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include "jms/graphics/depth_precision.hpp"
+#include "jms/graphics/projection.hpp"
+#include "jms/vulkan/vulkan.hpp"
+#include "jms/vulkan/graphics_rendering_state.hpp"
+
+
+namespace jms {
+namespace vulkan {
+
+
+struct DepthSetup {
+    vk::Format format{vk::Format::eD32Sfloat};
+    vk::CompareOp compare_op{vk::CompareOp::eLess};
+    float clear_depth{1.0f};
+};
+
+
+// Depth formats with the encoding; stencil formats only when needs_stencil.
+std::vector<vk::Format> DepthFormats(DepthEncoding encoding, bool needs_stencil);
+// First supported format starting with preferred and then falling back from the most precise encoding.
+vk::Format SelectDepthFormat(const vk::raii::PhysicalDevice& physical_device,
+                             DepthEncoding preferred = DepthEncoding::FLOAT32,
+                             bool needs_stencil = false);
+// Compare op and clear value follow the projection: reversed-Z clears to 0 and keeps greater depth.
+DepthSetup MakeDepthSetup(const Projection& projection, vk::Format format = vk::Format::eD32Sfloat);
+/***
+ * Enables depth test and write with the setup's compare op and clears the depth attachment to its clear value.  A
+ * missing depth attachment is added as clear on load and don't care on store; set storeOp when later passes read it.
+ * The format is for creating the depth image; rendering with dynamic state doesn't take it.
+ */
+void ApplyDepthSetup(GraphicsRenderingState& state, const DepthSetup& setup);
+
+
+std::vector<vk::Format> DepthFormats(DepthEncoding encoding, bool needs_stencil) {
+    switch (encoding) {
+        case DepthEncoding::UNORM16:
+            if (needs_stencil) { return {vk::Format::eD16UnormS8Uint}; }
+            return {vk::Format::eD16Unorm};
+        case DepthEncoding::UNORM24:
+            if (needs_stencil) { return {vk::Format::eD24UnormS8Uint}; }
+            return {vk::Format::eX8D24UnormPack32, vk::Format::eD24UnormS8Uint};
+        case DepthEncoding::FLOAT32:
+            if (needs_stencil) { return {vk::Format::eD32SfloatS8Uint}; }
+            return {vk::Format::eD32Sfloat};
+    }
+    return {};
+}
+
+
+vk::Format SelectDepthFormat(const vk::raii::PhysicalDevice& physical_device,
+                             DepthEncoding preferred,
+                             bool needs_stencil) {
+    std::vector<vk::Format> candidates = DepthFormats(preferred, needs_stencil);
+    for (DepthEncoding encoding : {DepthEncoding::FLOAT32, DepthEncoding::UNORM24, DepthEncoding::UNORM16}) {
+        if (encoding == preferred) { continue; }
+        std::ranges::copy(DepthFormats(encoding, needs_stencil), std::back_inserter(candidates));
+    }
+    for (vk::Format format : candidates) {
+        vk::FormatProperties properties = physical_device.getFormatProperties(format);
+        if (properties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eDepthStencilAttachment) { return format; }
+    }
+    throw std::runtime_error{std::format("SelectDepthFormat: no supported depth{} format.\n",
+                                         (needs_stencil ? " stencil" : ""))};
+}
+
+
+DepthSetup MakeDepthSetup(const Projection& projection, vk::Format format) {
+    return {
+        .format=format,
+        .compare_op=(projection.is_reversed_z ? vk::CompareOp::eGreater : vk::CompareOp::eLess),
+        .clear_depth=(projection.is_reversed_z ? 0.0f : 1.0f)
+    };
+}
+
+
+void ApplyDepthSetup(GraphicsRenderingState& state, const DepthSetup& setup) {
+    if (!state.depth_attachment.has_value()) {
+        state.depth_attachment = vk::RenderingAttachmentInfo{
+            .imageLayout=vk::ImageLayout::eDepthAttachmentOptimal,
+            .loadOp=vk::AttachmentLoadOp::eClear,
+            .storeOp=vk::AttachmentStoreOp::eDontCare
+        };
+    }
+    state.depth_attachment->clearValue = vk::ClearValue{.depthStencil={.depth=setup.clear_depth, .stencil=0}};
+    state.depth_test_enabled = true;
+    state.depth_write_enabled = true;
+    state.depth_compare_op = setup.compare_op;
+}
+
+
+}
+}
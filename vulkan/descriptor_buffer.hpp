@@ -0,0 +1,266 @@
+#pragma once
+
+
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <ranges>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "jms/vulkan/vulkan.hpp"
+#include "jms/vulkan/info.hpp"
+#include "jms/vulkan/layout_cache.hpp"
+#include "jms/vulkan/memory_resource.hpp"
+#include "jms/vulkan/state.hpp"
+#include "jms/vulkan/utils.hpp"
+
+
+namespace jms {
+namespace vulkan {
+
+
+/***
+ * SETS   - descriptor pools/sets updated with vkUpdateDescriptorSets and bound with vkCmdBindDescriptorSets.
+ * BUFFER - VK_EXT_descriptor_buffer; descriptors are written directly into host visible buffer memory and bound
+ *          by buffer address plus offsets.  No pools, sets, or vkUpdateDescriptorSets.
+ */
+enum class DescriptorModel {
+    SETS,
+    BUFFER
+};
+
+
+// Create flags every set layout of the model needs on top of its own.
+vk::DescriptorSetLayoutCreateFlags DescriptorModelLayoutFlags(DescriptorModel descriptor_model) noexcept {
+    if (descriptor_model == DescriptorModel::SETS) { return {}; }
+    return vk::DescriptorSetLayoutCreateFlagBits::eDescriptorBufferEXT;
+}
+
+
+// Data required to bind a descriptor buffer; see DescriptorBuffer::Binding and GraphicsPass::ToCommands
+struct DescriptorBufferBinding {
+    std::vector<vk::DescriptorBufferBindingInfoEXT> buffers{};
+    std::vector<uint32_t> buffer_indices{};
+    std::vector<vk::DeviceSize> offsets{};
+};
+
+
+bool IsDescriptorBufferSupported(const vk::raii::PhysicalDevice& physical_device) {
+    auto extensions = physical_device.enumerateDeviceExtensionProperties();
+    bool has_extension = std::ranges::any_of(extensions, [](const auto& ext) {
+        return std::string_view{ext.extensionName} == std::string_view{VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME};
+    });
+    if (!has_extension) { return false; }
+    auto features = physical_device.getFeatures2<vk::PhysicalDeviceFeatures2,
+                                                 vk::PhysicalDeviceBufferDeviceAddressFeatures,
+                                                 vk::PhysicalDeviceDescriptorBufferFeaturesEXT>();
+    return features.get<vk::PhysicalDeviceBufferDeviceAddressFeatures>().bufferDeviceAddress &&
+           features.get<vk::PhysicalDeviceDescriptorBufferFeaturesEXT>().descriptorBuffer;
+}
+
+
+// Choose BUFFER only when the physical device supports it and the device was created with it enabled; otherwise
+// fallback to SETS.
+DescriptorModel SelectDescriptorModel(const vk::raii::PhysicalDevice& physical_device,
+                                      const DeviceConfig& device_config) {
+    if (!IsDescriptorBufferSupported(physical_device)) { return DescriptorModel::SETS; }
+    bool has_extension = std::ranges::any_of(device_config.extension_names, [](const auto& name) {
+        return name == std::string_view{VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME};
+    });
+    bool has_feature = std::ranges::any_of(device_config.pnext_features, [](const auto& pnext) {
+        const auto* features = std::get_if<vk::PhysicalDeviceDescriptorBufferFeaturesEXT>(std::addressof(pnext));
+        return features && features->descriptorBuffer;
+    });
+    return (has_extension && has_feature) ? DescriptorModel::BUFFER : DescriptorModel::SETS;
+}
+
+
+/***
+ * Host visible buffer holding the descriptors of every set for a group of layouts; i.e. GraphicsPass::layouts.
+ * The layouts must have been created with vk::DescriptorSetLayoutCreateFlagBits::eDescriptorBufferEXT.
+ *
+ * num_copies allows N independent copies of all sets (e.g. per frame in flight) to live in the same buffer; each
+ * copy is bound by changing the offsets only.
+ *
+ * The allocator must allocate from host visible|coherent memory created with
+ * vk::MemoryAllocateFlagBits::eDeviceAddress and its memory resource must give whole DeviceMemory allocations; see
+ * ResourceAllocator::Map.
+ */
+template <template <typename> typename Container_t, typename Mutex_t/*=jms::NoMutex*/>
+class DescriptorBuffer {
+public:
+    using Allocator_t = BufferResourceAllocator<Container_t, Mutex_t>;
+    using Buffer_t = Buffer<Container_t, Mutex_t>;
+
+private:
+    vk::raii::Device* device{nullptr};
+    vk::PhysicalDeviceDescriptorBufferPropertiesEXT properties{};
+    std::vector<std::vector<vk::DescriptorSetLayoutBinding>> set_layout_bindings{};
+    std::vector<std::vector<vk::DeviceSize>> binding_offsets{};
+    std::vector<vk::DeviceSize> set_offsets{};
+    vk::DeviceSize copy_size{0};
+    size_t num_copies{0};
+    vk::BufferUsageFlags usage{};
+    Buffer_t buffer{};
+    std::byte* mapped{nullptr};
+    vk::DeviceAddress address{0};
+
+public:
+    DescriptorBuffer(const vk::raii::PhysicalDevice& physical_device,
+                     Allocator_t& allocator,
+                     const std::vector<SharedDescriptorSetLayout>& layouts,
+                     const std::vector<std::vector<vk::DescriptorSetLayoutBinding>>& set_layout_bindings_in,
+                     size_t num_copies = 1)
+    : device{std::addressof(allocator.GetDevice())},
+      set_layout_bindings{set_layout_bindings_in},
+      num_copies{num_copies}
+    {
+        if (layouts.size() != set_layout_bindings.size()) {
+            throw std::runtime_error{"DescriptorBuffer: layouts and set layout bindings size mismatch."};
+        }
+        if (num_copies < 1) { throw std::runtime_error{"DescriptorBuffer requires at least one copy."}; }
+
+        auto props = physical_device.getProperties2<vk::PhysicalDeviceProperties2,
+                                                    vk::PhysicalDeviceDescriptorBufferPropertiesEXT>();
+        properties = props.get<vk::PhysicalDeviceDescriptorBufferPropertiesEXT>();
+        const vk::DeviceSize alignment = properties.descriptorBufferOffsetAlignment;
+        auto AlignUp = [alignment](vk::DeviceSize v) { return ((v + alignment - 1) / alignment) * alignment; };
+
+        set_offsets.reserve(layouts.size());
+        binding_offsets.reserve(layouts.size());
+        for (auto [layout, bindings] : std::views::zip(layouts, set_layout_bindings)) {
+            set_offsets.push_back(copy_size);
+            copy_size = AlignUp(copy_size + layout->getSizeEXT());
+            std::vector<vk::DeviceSize> offsets{};
+            offsets.reserve(bindings.size());
+            std::ranges::transform(bindings, std::back_inserter(offsets),
+                                   [&layout](const auto& lb) { return layout->getBindingOffsetEXT(lb.binding); });
+            binding_offsets.push_back(std::move(offsets));
+            for (const auto& lb : bindings) {
+                if (IsSamplerType(lb.descriptorType)) { usage |= vk::BufferUsageFlagBits::eSamplerDescriptorBufferEXT; }
+                else { usage |= vk::BufferUsageFlagBits::eResourceDescriptorBufferEXT; }
+            }
+        }
+        if (!usage) { usage = vk::BufferUsageFlagBits::eResourceDescriptorBufferEXT; }
+        if (!copy_size) { copy_size = alignment; }
+
+        buffer = Buffer_t{allocator, BufferInfo{
+            .size=copy_size * static_cast<vk::DeviceSize>(num_copies),
+            .usage=(usage | vk::BufferUsageFlagBits::eShaderDeviceAddress)
+        }};
+        mapped = static_cast<std::byte*>(buffer.Map());
+        address = buffer.GetDeviceAddress();
+    }
+    DescriptorBuffer(const DescriptorBuffer&) = delete;
+    DescriptorBuffer(DescriptorBuffer&&) noexcept = default;
+    ~DescriptorBuffer() noexcept = default; // memory is unmapped when freed
+    DescriptorBuffer& operator=(const DescriptorBuffer&) = delete;
+    DescriptorBuffer& operator=(DescriptorBuffer&&) noexcept = default;
+
+    DescriptorBufferBinding Binding(size_t copy_index) const {
+        if (copy_index >= num_copies) {
+            throw std::runtime_error{std::format("DescriptorBuffer: invalid copy index {} / {}\n",
+                                                 copy_index, num_copies)};
+        }
+        DescriptorBufferBinding binding{
+            .buffers={{.address=address, .usage=usage}},
+            .buffer_indices=std::vector<uint32_t>(set_offsets.size(), 0)
+        };
+        binding.offsets.reserve(set_offsets.size());
+        std::ranges::transform(set_offsets, std::back_inserter(binding.offsets),
+                               [base=copy_size * copy_index](auto offset) { return base + offset; });
+        return binding;
+    }
+
+    size_t DescriptorSize(vk::DescriptorType descriptor_type) const {
+        switch (descriptor_type) {
+            case vk::DescriptorType::eSampler: return properties.samplerDescriptorSize;
+            case vk::DescriptorType::eCombinedImageSampler: return properties.combinedImageSamplerDescriptorSize;
+            case vk::DescriptorType::eSampledImage: return properties.sampledImageDescriptorSize;
+            case vk::DescriptorType::eStorageImage: return properties.storageImageDescriptorSize;
+            case vk::DescriptorType::eUniformTexelBuffer: return properties.uniformTexelBufferDescriptorSize;
+            case vk::DescriptorType::eStorageTexelBuffer: return properties.storageTexelBufferDescriptorSize;
+            case vk::DescriptorType::eUniformBuffer: return properties.uniformBufferDescriptorSize;
+            case vk::DescriptorType::eStorageBuffer: return properties.storageBufferDescriptorSize;
+            case vk::DescriptorType::eInputAttachment: return properties.inputAttachmentDescriptorSize;
+            case vk::DescriptorType::eAccelerationStructureKHR: return properties.accelerationStructureDescriptorSize;
+            default: break;
+        }
+        throw std::runtime_error{std::format("DescriptorBuffer: unsupported descriptor type {}\n",
+                                             vk::to_string(descriptor_type))};
+    }
+
+    // Writes straight into mapped memory; it is up to the caller to not overwrite a copy that is in use by the GPU.
+    void Write(size_t copy_index,
+               size_t set_index,
+               size_t layout_index,
+               uint32_t array_element,
+               const vk::DescriptorDataEXT& data) {
+        const auto& layout = set_layout_bindings.at(set_index).at(layout_index);
+        if (copy_index >= num_copies || array_element >= layout.descriptorCount) {
+            throw std::runtime_error{"DescriptorBuffer: descriptor write out of bounds."};
+        }
+        size_t size = DescriptorSize(layout.descriptorType);
+        std::byte* dst = mapped +
+                         (copy_size * copy_index) +
+                         set_offsets.at(set_index) +
+                         binding_offsets.at(set_index).at(layout_index) +
+                         (size * array_element);
+        device->getDescriptorEXT({.type=layout.descriptorType, .data=data}, size, dst);
+    }
+
+    // Mirrors GraphicsPass::UpdateDescriptorSets; tuple is (set_layout_bindings index, info)
+    void UpdateDescriptors(size_t copy_index,
+                           size_t set_index,
+                           const std::vector<std::tuple<size_t, vk::DescriptorAddressInfoEXT>>& buffer_data,
+                           const std::vector<std::tuple<size_t, vk::DescriptorImageInfo>>& image_data) {
+        const auto& bindings = set_layout_bindings.at(set_index);
+        for (const auto& [layout_index, info] : buffer_data) {
+            switch (bindings.at(layout_index).descriptorType) {
+                case vk::DescriptorType::eUniformBuffer:
+                    Write(copy_index, set_index, layout_index, 0, {.pUniformBuffer=std::addressof(info)}); break;
+                case vk::DescriptorType::eStorageBuffer:
+                    Write(copy_index, set_index, layout_index, 0, {.pStorageBuffer=std::addressof(info)}); break;
+                case vk::DescriptorType::eUniformTexelBuffer:
+                    Write(copy_index, set_index, layout_index, 0, {.pUniformTexelBuffer=std::addressof(info)}); break;
+                case vk::DescriptorType::eStorageTexelBuffer:
+                    Write(copy_index, set_index, layout_index, 0, {.pStorageTexelBuffer=std::addressof(info)}); break;
+                default:
+                    throw std::runtime_error{"DescriptorBuffer: buffer data provided for non buffer descriptor."};
+            }
+        }
+        for (const auto& [layout_index, info] : image_data) {
+            switch (bindings.at(layout_index).descriptorType) {
+                case vk::DescriptorType::eSampler:
+                    Write(copy_index, set_index, layout_index, 0, {.pSampler=std::addressof(info.sampler)}); break;
+                case vk::DescriptorType::eCombinedImageSampler:
+                    Write(copy_index, set_index, layout_index, 0, {.pCombinedImageSampler=std::addressof(info)});
+                    break;
+                case vk::DescriptorType::eSampledImage:
+                    Write(copy_index, set_index, layout_index, 0, {.pSampledImage=std::addressof(info)}); break;
+                case vk::DescriptorType::eStorageImage:
+                    Write(copy_index, set_index, layout_index, 0, {.pStorageImage=std::addressof(info)}); break;
+                case vk::DescriptorType::eInputAttachment:
+                    Write(copy_index, set_index, layout_index, 0, {.pInputAttachmentImage=std::addressof(info)});
+                    break;
+                default:
+                    throw std::runtime_error{"DescriptorBuffer: image data provided for non image descriptor."};
+            }
+        }
+    }
+
+    size_t NumCopies() const noexcept { return num_copies; }
+
+private:
+    static constexpr bool IsSamplerType(vk::DescriptorType descriptor_type) noexcept {
+        return descriptor_type == vk::DescriptorType::eSampler ||
+               descriptor_type == vk::DescriptorType::eCombinedImageSampler;
+    }
+};
+
+
+}
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "jms/vulkan/vulkan.hpp"
+#include "jms/vulkan/info.hpp"
+#include "jms/vulkan/memory_resource.hpp"
+
+
+namespace jms {
+namespace vulkan {
+
+
+/***
+ * 64 bit draw sort key; most significant bits change least often.
+ *
+ *   [63..48] shader (pass shader binding)
+ *   [47..24] material (descriptors, push constants)
+ *   [23..0]  mesh (sort order only; see below)
+ *
+ * Items with the same shader and material bits share a batch and are drawn with one vkCmdDrawIndexedIndirectCount,
+ * so with DRAW_KEY_STATE_MASK every mesh must live in one global vertex and index buffer bound once for the pass;
+ * meshes differ only by firstIndex and vertexOffset.  Meshes in their own buffers need the mesh bits as state too:
+ * pass DRAW_KEY_MESH_STATE_MASK to MergeDrawItems and bind the mesh's buffers in BindStateF.
+ */
+constexpr uint64_t DRAW_KEY_MESH_BITS = 24;
+constexpr uint64_t DRAW_KEY_MATERIAL_BITS = 24;
+constexpr uint64_t DRAW_KEY_SHADER_BITS = 16;
+constexpr uint64_t DRAW_KEY_STATE_MASK = ~((uint64_t{1} << DRAW_KEY_MESH_BITS) - 1);
+constexpr uint64_t DRAW_KEY_MESH_STATE_MASK = ~uint64_t{0};
+
+
+constexpr uint64_t MakeDrawKey(uint64_t shader, uint64_t material, uint64_t mesh) noexcept {
+    return ((shader & ((uint64_t{1} << DRAW_KEY_SHADER_BITS) - 1)) << (DRAW_KEY_MATERIAL_BITS + DRAW_KEY_MESH_BITS)) |
+           ((material & ((uint64_t{1} << DRAW_KEY_MATERIAL_BITS) - 1)) << DRAW_KEY_MESH_BITS) |
+           (mesh & ((uint64_t{1} << DRAW_KEY_MESH_BITS) - 1));
+}
+
+
+struct DrawItem {
+    uint64_t key{0};
+    uint32_t index_count{0};
+    uint32_t first_index{0};
+    int32_t vertex_offset{0};
+    uint32_t instance_count{1};
+    uint32_t first_instance{0};
+};
+
+
+// A run of commands sharing the state bits of the key; one indirect count draw from the buffers bound for it.
+struct DrawBatch {
+    uint64_t state_key{0};
+    uint32_t first_command{0};
+    uint32_t command_count{0};
+};
+
+
+/***
+ * Stable LSD radix sort on DrawItem::key; 8 passes of 8 bits.  Passes where every item has the same digit are
+ * skipped so keys only using a few bits cost a few passes.  scratch is resized as needed and can be reused across
+ * frames to avoid allocation.
+ */
+void RadixSortDrawItems(std::vector<DrawItem>& items, std::vector<DrawItem>& scratch) {
+    constexpr size_t RADIX_BITS = 8;
+    constexpr size_t NUM_BUCKETS = size_t{1} << RADIX_BITS;
+    constexpr size_t NUM_PASSES = 64 / RADIX_BITS;
+
+    std::array<std::array<size_t, NUM_BUCKETS>, NUM_PASSES> histograms{};
+    for (const DrawItem& item : items) {
+        for (size_t pass = 0; pass < NUM_PASSES; ++pass) {
+            histograms[pass][(item.key >> (pass * RADIX_BITS)) & (NUM_BUCKETS - 1)]++;
+        }
+    }
+
+    scratch.resize(items.size());
+    for (size_t pass = 0; pass < NUM_PASSES; ++pass) {
+        auto& histogram = histograms[pass];
+        if (std::ranges::any_of(histogram, [n=items.size()](size_t count) { return count == n; })) { continue; }
+        size_t sum = 0;
+        for (size_t& count : histogram) { sum += std::exchange(count, sum); }
+        for (const DrawItem& item : items) {
+            scratch[histogram[(item.key >> (pass * RADIX_BITS)) & (NUM_BUCKETS - 1)]++] = item;
+        }
+        items.swap(scratch);
+    }
+}
+
+
+/***
+ * Converts sorted items to indirect commands and batches.  Consecutive items with the same key and mesh range whose
+ * instances are contiguous are merged into one command; consecutive commands with the same state bits form a batch.
+ * The default state_mask assumes shared vertex and index buffers; see DRAW_KEY_STATE_MASK.  commands is cleared
+ * before writing.
+ */
+std::vector<DrawBatch> MergeDrawItems(const std::vector<DrawItem>& sorted_items,
+                                      std::vector<vk::DrawIndexedIndirectCommand>& commands,
+                                      uint64_t state_mask = DRAW_KEY_STATE_MASK) {
+    std::vector<DrawBatch> batches{};
+    commands.clear();
+    commands.reserve(sorted_items.size());
+    const DrawItem* prev = nullptr;
+    for (const DrawItem& item : sorted_items) {
+        if (item.instance_count < 1 || item.index_count < 1) { continue; }
+        if (prev && prev->key == item.key &&
+            prev->index_count == item.index_count &&
+            prev->first_index == item.first_index &&
+            prev->vertex_offset == item.vertex_offset &&
+            commands.back().firstInstance + commands.back().instanceCount == item.first_instance) {
+            commands.back().instanceCount += item.instance_count;
+            prev = std::addressof(item);
+            continue;
+        }
+        if (batches.empty() || batches.back().state_key != (item.key & state_mask)) {
+            batches.push_back({
+                .state_key=(item.key & state_mask),
+                .first_command=static_cast<uint32_t>(commands.size()),
+                .command_count=0
+            });
+        }
+        commands.push_back({
+            .indexCount=item.index_count,
+            .instanceCount=item.instance_count,
+            .firstIndex=item.first_index,
+            .vertexOffset=item.vertex_offset,
+            .firstInstance=item.first_instance
+        });
+        batches.back().command_count++;
+        prev = std::addressof(item);
+    }
+    return batches;
+}
+
+
+/***
+ * Host visible indirect buffer holding a count per batch followed by the indirect commands.  Counts are written from
+ * the CPU batches but live on the GPU so a later culling pass may lower them without changing the recorded commands.
+ *
+ * Requires the drawIndirectCount (1.2) and multiDrawIndirect features.
+ *
+ * The allocator must allocate from host visible|coherent memory and its memory resource must give whole DeviceMemory
+ * allocations; see ResourceAllocator::Map.  One buffer per frame in flight.
+ */
+template <template <typename> typename Container_t, typename Mutex_t/*=jms::NoMutex*/>
+class IndirectDrawBuffer {
+public:
+    using Allocator_t = BufferResourceAllocator<Container_t, Mutex_t>;
+    using Buffer_t = Buffer<Container_t, Mutex_t>;
+
+private:
+    static constexpr vk::DeviceSize COMMAND_STRIDE = sizeof(vk::DrawIndexedIndirectCommand);
+
+    size_t max_batches{0};
+    size_t max_commands{0};
+    vk::DeviceSize commands_offset{0};
+    Buffer_t buffer{};
+    std::byte* mapped{nullptr};
+    std::vector<DrawBatch> batches{};
+
+public:
+    IndirectDrawBuffer(Allocator_t& allocator, size_t max_batches, size_t max_commands)
+    : max_batches{max_batches},
+      max_commands{max_commands},
+      commands_offset{((max_batches * sizeof(uint32_t) + COMMAND_STRIDE - 1) / COMMAND_STRIDE) * COMMAND_STRIDE}
+    {
+        if (max_batches < 1 || max_commands < 1) {
+            throw std::runtime_error{"IndirectDrawBuffer requires at least one batch and command."};
+        }
+        buffer = Buffer_t{allocator, BufferInfo{
+            .size=(commands_offset + max_commands * COMMAND_STRIDE),
+            .usage=vk::BufferUsageFlagBits::eIndirectBuffer
+        }};
+        mapped = static_cast<std::byte*>(buffer.Map());
+    }
+    IndirectDrawBuffer(const IndirectDrawBuffer&) = delete;
+    IndirectDrawBuffer(IndirectDrawBuffer&&) noexcept = default;
+    ~IndirectDrawBuffer() noexcept = default;
+    IndirectDrawBuffer& operator=(const IndirectDrawBuffer&) = delete;
+    IndirectDrawBuffer& operator=(IndirectDrawBuffer&&) noexcept = default;
+
+    // Only write once the previous use of this buffer has completed on the GPU.
+    void Write(const std::vector<vk::DrawIndexedIndirectCommand>& commands,
+               const std::vector<DrawBatch>& batches_in) {
+        if (batches_in.size() > max_batches || commands.size() > max_commands) {
+            throw std::runtime_error{std::format("IndirectDrawBuffer: {} batches / {} commands exceeds {} / {}\n",
+                                                 batches_in.size(), commands.size(), max_batches, max_commands)};
+        }
+        for (size_t i = 0; i < batches_in.size(); ++i) {
+            std::memcpy(mapped + i * sizeof(uint32_t), std::addressof(batches_in[i].command_count), sizeof(uint32_t));
+        }
+        if (!commands.empty()) {
+            std::memcpy(mapped + commands_offset, commands.data(), commands.size() * COMMAND_STRIDE);
+        }
+        batches = batches_in;
+    }
+
+    // BindStateF(command_buffer, state_key) binds whatever the state bits of the key represent before each batch;
+    // vertex and index buffers too when the batches were merged with DRAW_KEY_MESH_STATE_MASK.
+    void Draw(vk::raii::CommandBuffer& command_buffer, auto&& BindStateF) const {
+        vk::Buffer vk_buffer = buffer.AsVkBuffer();
+        for (size_t i = 0; i < batches.size(); ++i) {
+            const DrawBatch& batch = batches[i];
+            BindStateF(command_buffer, batch.state_key);
+            command_buffer.drawIndexedIndirectCount(vk_buffer, commands_offset + batch.first_command * COMMAND_STRIDE,
+                                                    vk_buffer, i * sizeof(uint32_t),
+                                                    batch.command_count, static_cast<uint32_t>(COMMAND_STRIDE));
+        }
+    }
+
+    const std::vector<DrawBatch>& Batches() const noexcept { return batches; }
+};
+
+
+}
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "jms/vulkan/vulkan.hpp"
+
+
+namespace jms {
+namespace vulkan {
+
+
+constexpr size_t MIN_FRAMES_IN_FLIGHT = 2;
+constexpr size_t MAX_FRAMES_IN_FLIGHT = 4;
+
+
+struct FrameContext {
+    vk::raii::CommandPool command_pool{nullptr};
+    vk::raii::CommandBuffer command_buffer{nullptr};
+    vk::raii::Semaphore image_available{nullptr};
+    vk::raii::Fence in_flight{nullptr};
+    uint64_t frame_number{0};
+};
+
+
+struct AcquiredFrame {
+    FrameContext* frame{nullptr};
+    uint32_t image_index{0};
+};
+
+
+/***
+ * Ring of N frames in flight.  BeginFrame only waits on the fence of the frame that last used the same slot so the
+ * CPU records frame N+1 while the GPU executes frame N.  Each frame owns its command pool (reset as a whole rather
+ * than per command buffer) and acquire semaphore.
+ *
+ * Render finished semaphores are per swapchain image rather than per frame; a present may still be waiting on the
+ * semaphore of an image when the frame slot comes around again.
+ *
+ * BeginFrame returns nullopt and EndFrame returns false when the swapchain must be recreated; call WaitIdle, then
+ * State::RecreateSwapchain (which also waits for pending presents) followed by OnSwapchainRecreated.
+ */
+class FrameRing {
+    vk::raii::Device* device{nullptr};
+    std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks{std::nullopt};
+    std::vector<FrameContext> frames{};
+    std::vector<vk::raii::Semaphore> render_finished{};
+    size_t current{0};
+    uint64_t frame_number{0};
+
+public:
+    FrameRing(vk::raii::Device& device,
+              uint32_t queue_family_index,
+              size_t num_frames,
+              size_t num_swapchain_images,
+              std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt)
+    : device{std::addressof(device)}, vk_allocation_callbacks{vk_allocation_callbacks}
+    {
+        if (num_frames < MIN_FRAMES_IN_FLIGHT || num_frames > MAX_FRAMES_IN_FLIGHT) {
+            throw std::runtime_error{std::format("FrameRing: {} frames in flight is outside [{}, {}]\n",
+                                                 num_frames, MIN_FRAMES_IN_FLIGHT, MAX_FRAMES_IN_FLIGHT)};
+        }
+        frames.reserve(num_frames);
+        for (size_t i = 0; i < num_frames; ++i) {
+            FrameContext frame{};
+            frame.command_pool = device.createCommandPool({
+                .flags=vk::CommandPoolCreateFlagBits::eTransient,
+                .queueFamilyIndex=queue_family_index
+            }, vk_allocation_callbacks.value_or(nullptr));
+            auto command_buffers = device.allocateCommandBuffers({
+                .commandPool=*frame.command_pool,
+                .level=vk::CommandBufferLevel::ePrimary,
+                .commandBufferCount=1
+            });
+            frame.command_buffer = std::move(command_buffers.at(0));
+            // Signaled so the first wait on each slot returns immediately.
+            frame.in_flight = device.createFence({.flags=vk::FenceCreateFlagBits::eSignaled},
+                                                 vk_allocation_callbacks.value_or(nullptr));
+            frames.push_back(std::move(frame));
+        }
+        // Creates the semaphores.
+        OnSwapchainRecreated(num_swapchain_images);
+    }
+    FrameRing(const FrameRing&) = delete;
+    FrameRing(FrameRing&&) noexcept = default;
+    ~FrameRing() noexcept = default;
+    FrameRing& operator=(const FrameRing&) = delete;
+    FrameRing& operator=(FrameRing&&) noexcept = default;
+
+    // Waits for the slot, acquires the next image and begins the slot's command buffer.
+    std::optional<AcquiredFrame> BeginFrame(vk::raii::SwapchainKHR& swapchain,
+                                            uint64_t timeout = std::numeric_limits<uint64_t>::max()) {
+        FrameContext& frame = frames[current];
+        if (device->waitForFences({*frame.in_flight}, VK_TRUE, timeout) != vk::Result::eSuccess) {
+            throw std::runtime_error{"FrameRing: timeout waiting for frame fence."};
+        }
+
+        uint32_t image_index = 0;
+        try {
+            vk::Result result{};
+            std::tie(result, image_index) = swapchain.acquireNextImage(timeout, *frame.image_available);
+            if (result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR) {
+                throw std::runtime_error{std::format("FrameRing: acquire failed; {}\n", vk::to_string(result))};
+            }
+        } catch (const vk::OutOfDateKHRError&) {
+            return std::nullopt;
+        }
+        if (image_index >= render_finished.size()) {
+            throw std::runtime_error{"FrameRing: swapchain image count changed without OnSwapchainRecreated."};
+        }
+
+        // Only reset once work will be submitted for this slot; otherwise the next wait would never return.
+        device->resetFences({*frame.in_flight});
+        frame.command_pool.reset();
+        frame.command_buffer.begin({.flags=vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+        frame.frame_number = frame_number;
+        return AcquiredFrame{.frame=std::addressof(frame), .image_index=image_index};
+    }
+
+    // Ends, submits and presents the acquired frame then advances the ring.  Returns false when the swapchain is out
+    // of date or suboptimal.
+    bool EndFrame(const AcquiredFrame& acquired,
+                  vk::raii::Queue& graphics_queue,
+                  vk::raii::Queue& present_queue,
+                  vk::raii::SwapchainKHR& swapchain,
+                  vk::PipelineStageFlags wait_stage = vk::PipelineStageFlagBits::eColorAttachmentOutput) {
+        FrameContext& frame = *acquired.frame;
+        const vk::Semaphore& signal = *render_finished.at(acquired.image_index);
+        frame.command_buffer.end();
+        graphics_queue.submit({vk::SubmitInfo{
+            .waitSemaphoreCount=1,
+            .pWaitSemaphores=std::addressof(*frame.image_available),
+            .pWaitDstStageMask=std::addressof(wait_stage),
+            .commandBufferCount=1,
+            .pCommandBuffers=std::addressof(*frame.command_buffer),
+            .signalSemaphoreCount=1,
+            .pSignalSemaphores=std::addressof(signal)
+        }}, *frame.in_flight);
+
+        current = (current + 1) % frames.size();
+        ++frame_number;
+
+        vk::SwapchainKHR vk_swapchain = *swapchain;
+        try {
+            vk::Result result = present_queue.presentKHR({
+                .waitSemaphoreCount=1,
+                .pWaitSemaphores=std::addressof(signal),
+                .swapchainCount=1,
+                .pSwapchains=std::addressof(vk_swapchain),
+                .pImageIndices=std::addressof(acquired.image_index)
+            });
+            return result == vk::Result::eSuccess;
+        } catch (const vk::OutOfDateKHRError&) {
+            return false;
+        }
+    }
+
+    // Waits for every frame in flight; required before destroying anything the frames reference.
+    void WaitIdle(uint64_t timeout = std::numeric_limits<uint64_t>::max()) {
+        std::vector<vk::Fence> fences{};
+        fences.reserve(frames.size());
+        for (auto& frame : frames) { fences.push_back(*frame.in_flight); }
+        if (device->waitForFences(fences, VK_TRUE, timeout) != vk::Result::eSuccess) {
+            throw std::runtime_error{"FrameRing: timeout waiting for frames in flight."};
+        }
+    }
+
+    // Call after WaitIdle and swapchain recreation.  The acquire semaphore of an out of date acquire may still be
+    // pending so all per frame semaphores are recreated as well.
+    void OnSwapchainRecreated(size_t num_swapchain_images) {
+        render_finished.clear();
+        render_finished.reserve(num_swapchain_images);
+        for (size_t i = 0; i < num_swapchain_images; ++i) {
+            render_finished.push_back(device->createSemaphore({}, vk_allocation_callbacks.value_or(nullptr)));
+        }
+        for (auto& frame : frames) {
+            frame.image_available = device->createSemaphore({}, vk_allocation_callbacks.value_or(nullptr));
+        }
+    }
+
+    size_t NumFrames() const noexcept { return frames.size(); }
+    size_t CurrentIndex() const noexcept { return current; }
+    uint64_t FrameNumber() const noexcept { return frame_number; }
+};
+
+
+}
+}
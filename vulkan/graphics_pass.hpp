@@ -6,10 +6,13 @@
 #include <map>
 #include <memory>
 #include <tuple>
+#include <type_traits>
 #include <vector>
 
 #include "jms/vulkan/vulkan.hpp"
+#include "jms/vulkan/descriptor_buffer.hpp"
 #include "jms/vulkan/graphics_rendering_state.hpp"
+#include "jms/vulkan/layout_cache.hpp"
 #include "jms/vulkan/shader.hpp"
 #include "jms/vulkan/utils.hpp"
 
@@ -21,21 +24,47 @@ namespace vulkan {
 struct GraphicsPass {
     GraphicsRenderingState rendering_state{};
     ShaderGroup shader_group{};
+    DescriptorModel descriptor_model{DescriptorModel::SETS};
+    size_t num_owned_sets{0};
     std::vector<vk::DescriptorPoolSize> set_pool_sizes{};
-    std::vector<vk::raii::DescriptorSetLayout> layouts{};
-    vk::raii::PipelineLayout pipeline_layout{nullptr};
+    // Shared with other passes when created through a LayoutCache.
+    std::vector<SharedDescriptorSetLayout> layouts{};
+    std::vector<vk::DescriptorSetLayout> vk_layouts{};
+    SharedPipelineLayout pipeline_layout{};
     std::vector<vk::raii::ShaderEXT> shaders{};
 
     GraphicsPass(vk::raii::Device& device,
                  const GraphicsRenderingState& graphics_rendering_state,
                  const ShaderGroup& shader_group_in,
+                 DescriptorModel descriptor_model_in = DescriptorModel::SETS,
+                 LayoutCache* layout_cache = nullptr,
                  std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt)
-    : rendering_state{graphics_rendering_state}, shader_group{shader_group_in} {
+    : rendering_state{graphics_rendering_state}, shader_group{shader_group_in}, descriptor_model{descriptor_model_in}
+    {
         shader_group.Validate(shader_group.shader_infos);
 
+        // Sets created from an update after bind pool (e.g. BindlessTable) are allocated and owned externally; they
+        // must come after the sets owned by the pass.
+        num_owned_sets = shader_group.set_layout_bindings.size();
+        for (size_t set_index : std::views::iota(static_cast<size_t>(0), shader_group.set_layout_bindings.size())) {
+            if (shader_group.IsExternalSet(set_index)) {
+                if (descriptor_model == DescriptorModel::BUFFER) {
+                    throw std::runtime_error{
+                        "GraphicsPass: update after bind sets are not allowed with descriptor buffers."};
+                }
+                num_owned_sets = std::min(num_owned_sets, set_index);
+            } else if (set_index > num_owned_sets) {
+                throw std::runtime_error{"GraphicsPass: externally owned descriptor sets must be the last sets."};
+            }
+        }
+
+        // Arrayed bindings need descriptorCount descriptors each, not one.
         std::map<vk::DescriptorType, size_t> counts{};
-        std::ranges::for_each(shader_group.set_layout_bindings, [&counts](const auto& layout_bindings) {
-            for (const auto& lb : layout_bindings) { counts[lb.descriptorType]++; }
+        std::ranges::for_each(shader_group.set_layout_bindings | std::views::take(num_owned_sets),
+                              [&counts](const auto& layout_bindings) {
+            for (const auto& lb : layout_bindings) {
+                if (lb.descriptorCount > 0) { counts[lb.descriptorType] += lb.descriptorCount; }
+            }
         });
 
         set_pool_sizes.reserve(counts.size());
@@ -45,26 +74,28 @@ struct GraphicsPass {
         });
 
 
+        const vk::DescriptorSetLayoutCreateFlags model_flags = DescriptorModelLayoutFlags(descriptor_model);
+        std::optional<LayoutCache> owned_cache{};
+        if (!layout_cache) { layout_cache = std::addressof(owned_cache.emplace(device, vk_allocation_callbacks)); }
         layouts.reserve(shader_group.set_layout_bindings.size());
-        std::ranges::transform(shader_group.set_layout_bindings, std::back_inserter(layouts),
-            [&device, &vk_allocation_callbacks](const auto& layout_bindings) -> vk::raii::DescriptorSetLayout{
-                return device.createDescriptorSetLayout({
-                    .bindingCount=static_cast<uint32_t>(layout_bindings.size()),
-                    .pBindings=VectorAsPtr(layout_bindings)
-                }, vk_allocation_callbacks.value_or(nullptr));
-            });
-
-        std::vector<vk::DescriptorSetLayout> vk_layouts{};
+        for (size_t set_index : std::views::iota(static_cast<size_t>(0), shader_group.set_layout_bindings.size())) {
+            const auto& layout_bindings = shader_group.set_layout_bindings.at(set_index);
+            const auto& binding_flags = shader_group.SetLayoutBindingFlags(set_index);
+            if (!binding_flags.empty() && binding_flags.size() != layout_bindings.size()) {
+                throw std::runtime_error{"GraphicsPass: set layout binding flags must match the number of bindings."};
+            }
+            layouts.push_back(layout_cache->GetSetLayout({
+                .flags=(shader_group.SetLayoutFlags(set_index) | model_flags),
+                .bindings=layout_bindings,
+                .binding_flags=binding_flags
+            }));
+        }
+
         vk_layouts.reserve(layouts.size());
-        std::ranges::transform(layouts, std::back_inserter(vk_layouts), [](auto& layout) { return *layout; });
-        pipeline_layout = device.createPipelineLayout({
-            .setLayoutCount=static_cast<uint32_t>(vk_layouts.size()),
-            .pSetLayouts=VectorAsPtr(vk_layouts),
-            .pushConstantRangeCount=static_cast<uint32_t>(shader_group.push_constant_ranges.size()),
-            .pPushConstantRanges=VectorAsPtr(shader_group.push_constant_ranges)
-        }, vk_allocation_callbacks.value_or(nullptr));
+        std::ranges::transform(layouts, std::back_inserter(vk_layouts), [](auto& layout) { return **layout; });
+        pipeline_layout = layout_cache->GetPipelineLayout(layouts, shader_group.push_constant_ranges);
 
-        shaders = shader_group.CreateShaders(device, layouts, vk_allocation_callbacks);
+        shaders = shader_group.CreateShaders(device, vk_layouts, vk_allocation_callbacks);
     }
     GraphicsPass(const GraphicsPass&) = delete;
     // default ok; only vk::raii, data only structs, std::vector and defaulted destructor
@@ -89,8 +120,9 @@ struct GraphicsPass {
         vk::raii::Device& device,
         std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt)
     {
+        RequireDescriptorModel(DescriptorModel::SETS, "CreateDescriptorPool");
         vk::raii::DescriptorPool pool = device.createDescriptorPool({
-            .maxSets=static_cast<uint32_t>(layouts.size()),
+            .maxSets=static_cast<uint32_t>(num_owned_sets),
             .poolSizeCount=static_cast<uint32_t>(set_pool_sizes.size()),
             .pPoolSizes=VectorAsPtr(set_pool_sizes)
         }, vk_allocation_callbacks.value_or(nullptr));
@@ -99,14 +131,13 @@ struct GraphicsPass {
 
     // Vulkan does not like DescriptorSets to be cleaned up without a special flag.  Going to return the wrapper
     // reference rather than raii variant instead.
+    // Only the sets owned by the pass are created; externally owned sets are bound by their owner.
     std::vector<vk::DescriptorSet> CreateDescriptorSets(vk::raii::Device& device,
                                                         vk::raii::DescriptorPool& pool) {
-        std::vector<vk::DescriptorSetLayout> vk_layouts{};
-        vk_layouts.reserve(layouts.size());
-        std::ranges::transform(layouts, std::back_inserter(vk_layouts), [](auto& layout) { return *layout; });
+        RequireDescriptorModel(DescriptorModel::SETS, "CreateDescriptorSets");
         auto raii_sets = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo{
             .descriptorPool=*pool,
-            .descriptorSetCount=static_cast<uint32_t>(vk_layouts.size()),
+            .descriptorSetCount=static_cast<uint32_t>(num_owned_sets),
             .pSetLayouts=VectorAsPtr(vk_layouts)
         });
         std::vector<vk::DescriptorSet> vk_descriptor_sets{};
@@ -122,6 +153,115 @@ struct GraphicsPass {
                     const std::vector<vk::DescriptorSet>& vk_descriptor_sets,
                     const std::vector<uint32_t>& descriptor_set_dynamic_offsets,
                     auto&&... DrawCommands) {
+        RequireDescriptorModel(DescriptorModel::SETS, "ToCommands");
+        BeginRenderingCommands(command_buffer, color_attachment_targets, color_attachment_resolve_targets,
+                               depth_image_view);
+
+        //std::vector<vk::DescriptorSet> vk_descriptor_sets{};
+        //vk_descriptor_sets.reserve(descriptor_sets.size());
+        //std::range::transform(descriptor_sets, std::back_inserter(vk_descriptor_sets), [](auto& i) { return *i; });
+
+        command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, **pipeline_layout, 0,
+                                          vk_descriptor_sets, descriptor_set_dynamic_offsets);
+
+        (DrawCommands(command_buffer), ...);
+
+        command_buffer.endRendering();
+    }
+
+    // Descriptor buffer variant; no descriptor sets are bound only buffer addresses and offsets.
+    void ToCommands(vk::raii::CommandBuffer& command_buffer,
+                    const std::vector<vk::ImageView>& color_attachment_targets,
+                    const std::vector<vk::ImageView>& color_attachment_resolve_targets,
+                    const vk::ImageView& depth_image_view,
+                    const DescriptorBufferBinding& descriptor_buffer_binding,
+                    auto&&... DrawCommands) {
+        RequireDescriptorModel(DescriptorModel::BUFFER, "ToCommands");
+        BeginRenderingCommands(command_buffer, color_attachment_targets, color_attachment_resolve_targets,
+                               depth_image_view);
+
+        if (!descriptor_buffer_binding.offsets.empty()) {
+            command_buffer.bindDescriptorBuffersEXT(descriptor_buffer_binding.buffers);
+            command_buffer.setDescriptorBufferOffsetsEXT(vk::PipelineBindPoint::eGraphics, **pipeline_layout, 0,
+                                                         descriptor_buffer_binding.buffer_indices,
+                                                         descriptor_buffer_binding.offsets);
+        }
+
+        (DrawCommands(command_buffer), ...);
+
+        command_buffer.endRendering();
+    }
+
+    bool FitsPushConstants(size_t range_index, size_t size_in_bytes) const {
+        return size_in_bytes <= shader_group.push_constant_ranges.at(range_index).size;
+    }
+
+    // Small per draw data; no allocation or descriptor write, the data is recorded directly in the command buffer.
+    template <typename T>
+    void PushConstants(vk::raii::CommandBuffer& command_buffer, size_t range_index, const T& data) const {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const vk::PushConstantRange& range = shader_group.push_constant_ranges.at(range_index);
+        if (sizeof(T) > range.size) {
+            throw std::runtime_error{
+                std::format("GraphicsPass::PushConstants: {} bytes exceeds range {} of {} bytes.\n",
+                            sizeof(T), range_index, range.size)};
+        }
+        command_buffer.pushConstants<T>(**pipeline_layout, range.stageFlags, range.offset, data);
+    }
+
+    // Need to add support for inline descriptors
+    void UpdateDescriptorSets(vk::raii::Device& device,
+                              std::vector<vk::DescriptorSet>& descriptor_sets,
+                              size_t set_index,
+                              const std::vector<std::tuple<size_t, vk::DescriptorBufferInfo>>& buffer_data,
+                              const std::vector<std::tuple<size_t, vk::DescriptorImageInfo>>& image_data,
+                              const std::vector<std::tuple<size_t, vk::BufferView>>& texel_data) {
+        RequireDescriptorModel(DescriptorModel::SETS, "UpdateDescriptorSets");
+        std::vector<vk::WriteDescriptorSet> write_data{};
+        write_data.reserve(buffer_data.size() + image_data.size() + texel_data.size());
+
+        auto SetBufferF = [](vk::WriteDescriptorSet& data, const vk::DescriptorBufferInfo& value) {
+            data.pBufferInfo = std::addressof(value);
+        };
+        auto SetImageF = [](vk::WriteDescriptorSet& data, const vk::DescriptorImageInfo& value) {
+            data.pImageInfo = std::addressof(value);
+        };
+        auto SetTexelF = [](vk::WriteDescriptorSet& data, const vk::BufferView& value) {
+            data.pTexelBufferView = std::addressof(value);
+        };
+        auto& descriptor_set = descriptor_sets.at(set_index);
+        auto CreateF = [&descriptor_set, &set_index, &set_layout_bindings=shader_group.set_layout_bindings](size_t i) {
+                auto& layout = set_layout_bindings.at(set_index).at(i);
+                return vk::WriteDescriptorSet{
+                    .dstSet=descriptor_set,
+                    .dstBinding=layout.binding,
+                    .dstArrayElement=0,
+                    .descriptorCount=1,
+                    .descriptorType=layout.descriptorType,
+                    .pImageInfo=nullptr,
+                    .pBufferInfo=nullptr,
+                    .pTexelBufferView=nullptr
+                };
+            };
+        auto F = [](auto&& CreateF, auto&& SetF) { return [&CreateF, &SetF](auto& data) {
+            const auto& [layout_index, info] = data;
+            vk::WriteDescriptorSet out = CreateF(layout_index);
+            SetF(out, info);
+            return out;
+        }; };
+
+        std::ranges::transform(buffer_data, std::back_inserter(write_data), F(CreateF, SetBufferF));
+        std::ranges::transform(image_data, std::back_inserter(write_data), F(CreateF, SetImageF));
+        std::ranges::transform(texel_data, std::back_inserter(write_data), F(CreateF, SetTexelF));
+
+        device.updateDescriptorSets(write_data, {});
+    }
+
+private:
+    void BeginRenderingCommands(vk::raii::CommandBuffer& command_buffer,
+                                const std::vector<vk::ImageView>& color_attachment_targets,
+                                const std::vector<vk::ImageView>& color_attachment_resolve_targets,
+                                const vk::ImageView& depth_image_view) {
         if (color_attachment_targets.size() != rendering_state.color_attachments.size()) {
             throw std::runtime_error{
                 std::format("WriteRenderingCommands: Incorrect number of color attachment targets: {} / {}\n",
@@ -220,65 +360,14 @@ struct GraphicsPass {
         });
         */
 
-        //std::vector<vk::DescriptorSet> vk_descriptor_sets{};
-        //vk_descriptor_sets.reserve(descriptor_sets.size());
-        //std::range::transform(descriptor_sets, std::back_inserter(vk_descriptor_sets), [](auto& i) { return *i; });
-
-        std::vector<std::tuple<vk::DescriptorSet, int>> descriptor_sets{};
         command_buffer.setVertexInputEXT(shader_group.vertex_binding_desc, shader_group.vertex_attribute_desc);
-        command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline_layout, 0, 
-                                          vk_descriptor_sets, descriptor_set_dynamic_offsets);
-
-        (DrawCommands(command_buffer), ...);
-
-        command_buffer.endRendering();
     }
 
-    // Need to add support for inline descriptors
-    void UpdateDescriptorSets(vk::raii::Device& device,
-                              std::vector<vk::DescriptorSet>& descriptor_sets,
-                              size_t set_index,
-                              const std::vector<std::tuple<size_t, vk::DescriptorBufferInfo>>& buffer_data,
-                              const std::vector<std::tuple<size_t, vk::DescriptorImageInfo>>& image_data,
-                              const std::vector<std::tuple<size_t, vk::BufferView>>& texel_data) {
-        std::vector<vk::WriteDescriptorSet> write_data{};
-        write_data.reserve(buffer_data.size() + image_data.size() + texel_data.size());
-
-        auto SetBufferF = [](vk::WriteDescriptorSet& data, const vk::DescriptorBufferInfo& value) {
-            data.pBufferInfo = std::addressof(value);
-        };
-        auto SetImageF = [](vk::WriteDescriptorSet& data, const vk::DescriptorImageInfo& value) {
-            data.pImageInfo = std::addressof(value);
-        };
-        auto SetTexelF = [](vk::WriteDescriptorSet& data, const vk::BufferView& value) {
-            data.pTexelBufferView = std::addressof(value);
-        };
-        auto& descriptor_set = descriptor_sets.at(set_index);
-        auto CreateF = [&descriptor_set, &set_index, &set_layout_bindings=shader_group.set_layout_bindings](size_t i) {
-                auto& layout = set_layout_bindings.at(set_index).at(i);
-                return vk::WriteDescriptorSet{
-                    .dstSet=descriptor_set,
-                    .dstBinding=layout.binding,
-                    .dstArrayElement=0,
-                    .descriptorCount=1,
-                    .descriptorType=layout.descriptorType,
-                    .pImageInfo=nullptr,
-                    .pBufferInfo=nullptr,
-                    .pTexelBufferView=nullptr
-                };
-            };
-        auto F = [](auto&& CreateF, auto&& SetF) { return [&CreateF, &SetF](auto& data) {
-            const auto& [layout_index, info] = data;
-            vk::WriteDescriptorSet out = CreateF(layout_index);
-            SetF(out, info);
-            return out;
-        }; };
-
-        std::ranges::transform(buffer_data, std::back_inserter(write_data), F(CreateF, SetBufferF));
-        std::ranges::transform(image_data, std::back_inserter(write_data), F(CreateF, SetImageF));
-        std::ranges::transform(texel_data, std::back_inserter(write_data), F(CreateF, SetTexelF));
-
-        device.updateDescriptorSets(write_data, {});
+    void RequireDescriptorModel(DescriptorModel required, const char* fn_name) const {
+        if (descriptor_model != required) {
+            throw std::runtime_error{std::format("GraphicsPass::{}: not available for the pass descriptor model.\n",
+                                                 fn_name)};
+        }
     }
 };
 
@@ -0,0 +1,191 @@
+#pragma once
+
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "jms/utils/hash.hpp"
+#include "jms/vulkan/vulkan.hpp"
+#include "jms/vulkan/utils.hpp"
+
+
+namespace jms {
+namespace vulkan {
+
+
+using SharedDescriptorSetLayout = std::shared_ptr<const vk::raii::DescriptorSetLayout>;
+using SharedPipelineLayout = std::shared_ptr<const vk::raii::PipelineLayout>;
+
+
+struct DescriptorSetLayoutDesc {
+    vk::DescriptorSetLayoutCreateFlags flags{};
+    std::vector<vk::DescriptorSetLayoutBinding> bindings{};
+    // Empty or one per binding.
+    std::vector<vk::DescriptorBindingFlags> binding_flags{};
+
+    // Bindings sorted by binding number (flags follow their binding); all empty binding flags are dropped.
+    DescriptorSetLayoutDesc Canonical() const {
+        if (!binding_flags.empty() && binding_flags.size() != bindings.size()) {
+            throw std::runtime_error{"DescriptorSetLayoutDesc: binding flags must match the number of bindings."};
+        }
+        std::vector<size_t> order(bindings.size());
+        std::iota(order.begin(), order.end(), static_cast<size_t>(0));
+        std::ranges::sort(order, {}, [this](size_t i) { return bindings[i].binding; });
+        DescriptorSetLayoutDesc out{.flags=flags};
+        out.bindings.reserve(bindings.size());
+        for (size_t i : order) { out.bindings.push_back(bindings[i]); }
+        bool has_binding_flags = std::ranges::any_of(binding_flags, [](auto f) { return static_cast<bool>(f); });
+        if (has_binding_flags) {
+            out.binding_flags.reserve(bindings.size());
+            for (size_t i : order) { out.binding_flags.push_back(binding_flags[i]); }
+        }
+        return out;
+    }
+
+    uint64_t Hash() const {
+        jms::Fnv1a64 hash{};
+        hash.Add(static_cast<uint32_t>(flags)).Add(static_cast<uint64_t>(bindings.size()));
+        for (const auto& b : bindings) {
+            hash.Add(b.binding).Add(b.descriptorType).Add(b.descriptorCount).Add(static_cast<uint32_t>(b.stageFlags));
+            hash.Add(reinterpret_cast<uintptr_t>(b.pImmutableSamplers));
+        }
+        for (auto f : binding_flags) { hash.Add(static_cast<uint32_t>(f)); }
+        return hash.Value();
+    }
+
+    bool operator==(const DescriptorSetLayoutDesc&) const = default;
+};
+
+
+/***
+ * Device level cache of descriptor set and pipeline layouts.  Identical (canonicalized) descriptions return the same
+ * object, so passes with the same bindings share layouts and descriptor sets bound for one pass stay compatible with
+ * the next; e.g. a per frame set at index 0 is bound once for every pass using it.
+ *
+ * The cache keeps a reference to everything it created; Trim releases layouts no pass uses anymore.  A pipeline
+ * layout keeps its set layouts alive.  Thread safe; passes may be created from several threads.
+ */
+class LayoutCache {
+    struct PipelineLayoutEntry {
+        std::vector<SharedDescriptorSetLayout> set_layouts{};
+        std::vector<vk::PushConstantRange> push_constant_ranges{};
+        SharedPipelineLayout layout{};
+    };
+
+    vk::raii::Device* device{nullptr};
+    std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks{std::nullopt};
+    std::unordered_map<uint64_t, std::vector<std::pair<DescriptorSetLayoutDesc, SharedDescriptorSetLayout>>>
+        set_layouts{};
+    std::unordered_map<uint64_t, std::vector<PipelineLayoutEntry>> pipeline_layouts{};
+    std::mutex mutex{};
+
+public:
+    LayoutCache(vk::raii::Device& device,
+                std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt)
+    : device{std::addressof(device)}, vk_allocation_callbacks{vk_allocation_callbacks}
+    {}
+    LayoutCache(const LayoutCache&) = delete;
+    LayoutCache(LayoutCache&&) = delete;
+    ~LayoutCache() noexcept = default;
+    LayoutCache& operator=(const LayoutCache&) = delete;
+    LayoutCache& operator=(LayoutCache&&) = delete;
+
+    SharedDescriptorSetLayout GetSetLayout(const DescriptorSetLayoutDesc& desc) {
+        DescriptorSetLayoutDesc canonical = desc.Canonical();
+        uint64_t hash = canonical.Hash();
+        std::scoped_lock lock{mutex};
+        auto& bucket = set_layouts[hash];
+        auto it = std::ranges::find_if(bucket, [&canonical](const auto& entry) { return entry.first == canonical; });
+        if (it != bucket.end()) { return it->second; }
+
+        vk::DescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info{
+            .bindingCount=static_cast<uint32_t>(canonical.binding_flags.size()),
+            .pBindingFlags=VectorAsPtr(canonical.binding_flags)
+        };
+        auto layout = std::make_shared<const vk::raii::DescriptorSetLayout>(device->createDescriptorSetLayout({
+            .pNext=(canonical.binding_flags.empty() ? nullptr : std::addressof(binding_flags_info)),
+            .flags=canonical.flags,
+            .bindingCount=static_cast<uint32_t>(canonical.bindings.size()),
+            .pBindings=VectorAsPtr(canonical.bindings)
+        }, vk_allocation_callbacks.value_or(nullptr)));
+        bucket.emplace_back(std::move(canonical), layout);
+        return layout;
+    }
+
+    // Push constant ranges are compared in order of (offset, size, stages).
+    SharedPipelineLayout GetPipelineLayout(const std::vector<SharedDescriptorSetLayout>& layouts,
+                                           const std::vector<vk::PushConstantRange>& push_constant_ranges) {
+        std::vector<vk::PushConstantRange> ranges{push_constant_ranges};
+        std::ranges::sort(ranges, {}, [](const auto& r) {
+            return std::tuple{r.offset, r.size, static_cast<uint32_t>(r.stageFlags)};
+        });
+        std::vector<vk::DescriptorSetLayout> vk_layouts{};
+        vk_layouts.reserve(layouts.size());
+        jms::Fnv1a64 hash{};
+        hash.Add(static_cast<uint64_t>(layouts.size()));
+        for (const auto& layout : layouts) {
+            vk_layouts.push_back(**layout);
+            hash.Add(std::bit_cast<uint64_t>(static_cast<VkDescriptorSetLayout>(vk_layouts.back())));
+        }
+        for (const auto& r : ranges) { hash.Add(static_cast<uint32_t>(r.stageFlags)).Add(r.offset).Add(r.size); }
+
+        std::scoped_lock lock{mutex};
+        auto& bucket = pipeline_layouts[hash.Value()];
+        auto it = std::ranges::find_if(bucket, [&layouts, &ranges](const PipelineLayoutEntry& entry) {
+            return entry.set_layouts == layouts && entry.push_constant_ranges == ranges;
+        });
+        if (it != bucket.end()) { return it->layout; }
+
+        auto layout = std::make_shared<const vk::raii::PipelineLayout>(device->createPipelineLayout({
+            .setLayoutCount=static_cast<uint32_t>(vk_layouts.size()),
+            .pSetLayouts=VectorAsPtr(vk_layouts),
+            .pushConstantRangeCount=static_cast<uint32_t>(ranges.size()),
+            .pPushConstantRanges=VectorAsPtr(ranges)
+        }, vk_allocation_callbacks.value_or(nullptr)));
+        bucket.push_back({.set_layouts=layouts, .push_constant_ranges=std::move(ranges), .layout=layout});
+        return layout;
+    }
+
+    // Releases layouts only referenced by the cache; pipeline layouts first since they hold set layouts.
+    size_t Trim() {
+        std::scoped_lock lock{mutex};
+        size_t count = 0;
+        for (auto& [hash, bucket] : pipeline_layouts) {
+            count += std::erase_if(bucket, [](const auto& entry) { return entry.layout.use_count() == 1; });
+        }
+        std::erase_if(pipeline_layouts, [](const auto& p) { return p.second.empty(); });
+        for (auto& [hash, bucket] : set_layouts) {
+            count += std::erase_if(bucket, [](const auto& entry) { return entry.second.use_count() == 1; });
+        }
+        std::erase_if(set_layouts, [](const auto& p) { return p.second.empty(); });
+        return count;
+    }
+
+    size_t NumSetLayouts() {
+        std::scoped_lock lock{mutex};
+        size_t count = 0;
+        for (const auto& [hash, bucket] : set_layouts) { count += bucket.size(); }
+        return count;
+    }
+
+    size_t NumPipelineLayouts() {
+        std::scoped_lock lock{mutex};
+        size_t count = 0;
+        for (const auto& [hash, bucket] : pipeline_layouts) { count += bucket.size(); }
+        return count;
+    }
+};
+
+
+}
+}
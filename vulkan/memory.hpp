@@ -79,10 +79,11 @@ public:
         return memory_resources_data.at(memory_resource_id).dmr;
     }
 
-    DeviceMemoryResource CreateDirectMemoryResource(uint32_t memory_type_index) {
+    DeviceMemoryResource CreateDirectMemoryResource(uint32_t memory_type_index,
+                                                    vk::MemoryAllocateFlags memory_allocate_flags = {}) {
         // validate requested index ...
         //     { throw std::runtime_error{"CreateDirectMemoryResource requires valid memory_type_index."}; }
-        return {*device, memory_type_index, vk_allocation_callbacks};
+        return {*device, memory_type_index, vk_allocation_callbacks, memory_allocate_flags};
     }
 
     auto CreateDeviceMemoryResourceMapped(size_t memory_resource_id) {
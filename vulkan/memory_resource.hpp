@@ -40,14 +40,18 @@ class DeviceMemoryResource : public jms::memory::Resource<DeviceMemoryAllocation
     vk::raii::Device* device{nullptr};
     vk::AllocationCallbacks* vk_allocation_callbacks{nullptr};
     uint32_t memory_type_index{0};
+    vk::MemoryAllocateFlags memory_allocate_flags{};
 
 public:
+    // memory_allocate_flags; e.g. eDeviceAddress is required for buffers using vk::BufferUsageFlagBits::eShaderDeviceAddress
     DeviceMemoryResource(vk::raii::Device& device,
                          uint32_t memory_type_index,
-                         std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt) noexcept
+                         std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt,
+                         vk::MemoryAllocateFlags memory_allocate_flags = {}) noexcept
     : device{std::addressof(device)},
       vk_allocation_callbacks{vk_allocation_callbacks.value_or(nullptr)},
-      memory_type_index{memory_type_index}
+      memory_type_index{memory_type_index},
+      memory_allocate_flags{memory_allocate_flags}
     {}
     DeviceMemoryResource(const DeviceMemoryResource&) = default;
     DeviceMemoryResource(DeviceMemoryResource&&) noexcept = default;
@@ -59,7 +63,9 @@ public:
                                                   [[maybe_unused]] size_type data_alignment,
                                                   [[maybe_unused]] size_type pointer_alignment) override {
         if (size < 1) { throw std::bad_alloc{}; }
+        vk::MemoryAllocateFlagsInfo flags_info{.flags=memory_allocate_flags};
         vk::raii::DeviceMemory dev_mem = device->allocateMemory({
+            .pNext=(memory_allocate_flags ? std::addressof(flags_info) : nullptr),
             .allocationSize=size,
             .memoryTypeIndex=memory_type_index
         }, vk_allocation_callbacks);
@@ -76,12 +82,14 @@ public:
         const DeviceMemoryResource* omr = dynamic_cast<const DeviceMemoryResource*>(std::addressof(other));
         return this->device                  == omr->device &&
                this->vk_allocation_callbacks == omr->vk_allocation_callbacks &&
-               this->memory_type_index       == omr->memory_type_index;
+               this->memory_type_index       == omr->memory_type_index &&
+               this->memory_allocate_flags   == omr->memory_allocate_flags;
     }
 
     vk::raii::Device& GetDevice() const noexcept { return *device; }
     vk::AllocationCallbacks* GetAllocationCallbacks() const noexcept { return vk_allocation_callbacks; }
     uint32_t GetMemoryTypeIndex() const noexcept { return memory_type_index; }
+    vk::MemoryAllocateFlags GetMemoryAllocateFlags() const noexcept { return memory_allocate_flags; }
 };
 
 
@@ -292,6 +300,28 @@ public:
 
     bool IsEqual(const ResourceAllocator& other) const noexcept { return this == std::addressof(other); }
 
+    // Vulkan only allows one mapping per DeviceMemory at a time so the memory resource must hand out whole
+    // DeviceMemory allocations (e.g. DeviceMemoryResource) from a host visible memory type for this to work.
+    void* Map(ResourceAllocation_t allocation) {
+        std::lock_guard<Mutex_t> lock{mutex};
+        auto it = std::ranges::find_if(units, [rhs=allocation.ptr](auto lhs) { return lhs == rhs; },
+                                       &Unit::res_ptr);
+        if (it == units.end()) { throw std::runtime_error{"Unable to find allocated resource to map."}; }
+        void* ptr = nullptr;
+        if (vkMapMemory(**device, it->mem.ptr, it->mem.offset, it->mem.size, {}, &ptr) != VK_SUCCESS) {
+            throw std::runtime_error{"Failed to map device memory of allocated resource."};
+        }
+        return ptr;
+    }
+
+    void Unmap(ResourceAllocation_t allocation) {
+        std::lock_guard<Mutex_t> lock{mutex};
+        auto it = std::ranges::find_if(units, [rhs=allocation.ptr](auto lhs) { return lhs == rhs; },
+                                       &Unit::res_ptr);
+        if (it == units.end()) { throw std::runtime_error{"Unable to find allocated resource to unmap."}; }
+        vkUnmapMemory(**device, it->mem.ptr);
+    }
+
 private:
     void DestroyUnit(Unit& unit) {
         RAII_t resource{*device, unit.res_ptr, vk_allocation_callbacks};
@@ -333,7 +363,7 @@ public:
         size = allocation.size;
     }
     Buffer(const Buffer&) = delete;
-    Buffer(Buffer&& other) noexcept { *this = other; }
+    Buffer(Buffer&& other) noexcept { *this = std::move(other); }
     ~Buffer() noexcept { if (ptr) { allocator->Deallocate({.ptr=ptr, .size=size}); } }
     Buffer& operator=(const Buffer&) = delete;
     Buffer& operator=(Buffer&& other) noexcept {
@@ -344,6 +374,17 @@ public:
     }
 
     vk::DescriptorBufferInfo AsDescriptorInfo() const noexcept { return {.buffer=ptr, .offset=0, .range=size}; }
+
+    vk::Buffer AsVkBuffer() const noexcept { return vk::Buffer{ptr}; }
+
+    vk::DeviceSize GetSize() const noexcept { return size; }
+
+    // Requires buffer usage eShaderDeviceAddress and memory allocated with vk::MemoryAllocateFlagBits::eDeviceAddress
+    vk::DeviceAddress GetDeviceAddress() const { return allocator->GetDevice().getBufferAddress({.buffer=ptr}); }
+
+    void* Map() { return allocator->Map({.ptr=ptr, .size=size}); }
+
+    void Unmap() { allocator->Unmap({.ptr=ptr, .size=size}); }
 };
 
 
@@ -0,0 +1,64 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "jms/graphics/vertex_packing.hpp"
+#include "jms/vulkan/vulkan.hpp"
+
+
+namespace jms {
+namespace vulkan {
+
+
+/***
+ * Vertex input for jms::PackedVertex; satisfies Vertex2EXT_c for VertexDescription2EXT::Create and fills
+ * ShaderGroup's vertex binding and attribute descriptions.  Locations from first_location: position, normal, tangent,
+ * uv.  Positions need the mesh's VertexDequantization, e.g. in a push constant or folded into the model matrix.
+ */
+struct PackedVertexInput {
+    static std::vector<vk::VertexInputBindingDescription2EXT> GetBindingDesc(uint32_t binding) {
+        return {vk::VertexInputBindingDescription2EXT{
+            .binding=binding,
+            .stride=sizeof(PackedVertex),
+            .inputRate=vk::VertexInputRate::eVertex,
+            .divisor=1
+        }};
+    }
+
+    static std::vector<vk::VertexInputAttributeDescription2EXT> GetAttributeDesc(uint32_t binding,
+                                                                                 uint32_t first_location = 0) {
+        return {
+            vk::VertexInputAttributeDescription2EXT{
+                .location=first_location,
+                .binding=binding,
+                .format=vk::Format::eR16G16B16A16Unorm,
+                .offset=offsetof(PackedVertex, position)
+            },
+            vk::VertexInputAttributeDescription2EXT{
+                .location=first_location + 1,
+                .binding=binding,
+                .format=vk::Format::eR16G16Snorm,
+                .offset=offsetof(PackedVertex, normal)
+            },
+            vk::VertexInputAttributeDescription2EXT{
+                .location=first_location + 2,
+                .binding=binding,
+                .format=vk::Format::eR16G16Snorm,
+                .offset=offsetof(PackedVertex, tangent)
+            },
+            vk::VertexInputAttributeDescription2EXT{
+                .location=first_location + 3,
+                .binding=binding,
+                .format=vk::Format::eR16G16Sfloat,
+                .offset=offsetof(PackedVertex, uv)
+            }
+        };
+    }
+};
+
+
+}
+}
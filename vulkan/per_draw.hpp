@@ -0,0 +1,218 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "jms/vulkan/vulkan.hpp"
+#include "jms/vulkan/graphics_pass.hpp"
+#include "jms/vulkan/info.hpp"
+#include "jms/vulkan/memory_resource.hpp"
+
+
+namespace jms {
+namespace vulkan {
+
+
+// Result of a per draw allocation; data is host visible and bound by set + dynamic_offset.
+struct DrawDataAllocation {
+    std::byte* data{nullptr};
+    vk::DescriptorSet set{};
+    uint32_t dynamic_offset{0};
+};
+
+
+/***
+ * Per frame linear uniform buffer for per draw data that does not fit in push constants.
+ *
+ * The arena is a list of host visible blocks, each with its own descriptor set whose single binding is a
+ * eUniformBufferDynamic of size range.  The set is written once when the block is created so an allocation is only a
+ * pointer bump aligned to minUniformBufferOffsetAlignment.  Blocks are kept across Reset and reused the next frame.
+ *
+ * One arena per frame in flight; call Reset once the frame's fence has been signaled.
+ *
+ * The allocator must allocate from host visible|coherent memory and its memory resource must give whole DeviceMemory
+ * allocations; see ResourceAllocator::Map.
+ */
+template <template <typename> typename Container_t, typename Mutex_t/*=jms::NoMutex*/>
+class FrameUniformArena {
+public:
+    using Allocator_t = BufferResourceAllocator<Container_t, Mutex_t>;
+    using Buffer_t = Buffer<Container_t, Mutex_t>;
+
+private:
+    struct Block {
+        Buffer_t buffer;
+        std::byte* mapped;
+        vk::DescriptorSet set;
+    };
+
+    Allocator_t* allocator{nullptr};
+    vk::DescriptorSetLayout layout{};
+    uint32_t binding{0};
+    vk::DeviceSize range{0};
+    vk::DeviceSize block_size{0};
+    vk::DeviceSize alignment{1};
+    size_t max_blocks{0};
+    vk::raii::DescriptorPool pool{nullptr};
+    std::vector<Block> blocks{};
+    size_t current_block{0};
+    vk::DeviceSize head{0};
+
+public:
+    // layout must contain binding as a eUniformBufferDynamic with descriptorCount 1; e.g. GraphicsPass::vk_layouts[i]
+    // range is the size of the largest per draw struct and the size the shader sees.
+    FrameUniformArena(const vk::raii::PhysicalDevice& physical_device,
+                      Allocator_t& allocator,
+                      vk::DescriptorSetLayout layout,
+                      uint32_t binding,
+                      vk::DeviceSize range,
+                      vk::DeviceSize block_size,
+                      size_t max_blocks = 8,
+                      std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt)
+    : allocator{std::addressof(allocator)},
+      layout{layout},
+      binding{binding},
+      range{range},
+      block_size{block_size},
+      max_blocks{max_blocks}
+    {
+        alignment = physical_device.getProperties().limits.minUniformBufferOffsetAlignment;
+        if (range < 1 || range > block_size) {
+            throw std::runtime_error{std::format("FrameUniformArena: invalid range {} for block size {}\n",
+                                                 range, block_size)};
+        }
+        if (max_blocks < 1) { throw std::runtime_error{"FrameUniformArena requires at least one block."}; }
+        vk::DescriptorPoolSize pool_size{
+            .type=vk::DescriptorType::eUniformBufferDynamic,
+            .descriptorCount=static_cast<uint32_t>(max_blocks)
+        };
+        pool = allocator.GetDevice().createDescriptorPool({
+            .maxSets=static_cast<uint32_t>(max_blocks),
+            .poolSizeCount=1,
+            .pPoolSizes=std::addressof(pool_size)
+        }, vk_allocation_callbacks.value_or(nullptr));
+        blocks.reserve(max_blocks);
+        CreateBlock();
+    }
+    FrameUniformArena(const FrameUniformArena&) = delete;
+    FrameUniformArena(FrameUniformArena&&) noexcept = default;
+    ~FrameUniformArena() noexcept = default;
+    FrameUniformArena& operator=(const FrameUniformArena&) = delete;
+    FrameUniformArena& operator=(FrameUniformArena&&) noexcept = default;
+
+    DrawDataAllocation Allocate(vk::DeviceSize size) {
+        if (size > range) {
+            throw std::runtime_error{std::format("FrameUniformArena: {} bytes exceeds range {}\n", size, range)};
+        }
+        vk::DeviceSize offset = ((head + alignment - 1) / alignment) * alignment;
+        // The dynamic offset plus the descriptor range must stay within the buffer.
+        if (offset + range > block_size) {
+            if (++current_block == blocks.size()) { CreateBlock(); }
+            offset = 0;
+        }
+        head = offset + size;
+        Block& block = blocks[current_block];
+        return {.data=block.mapped + offset, .set=block.set, .dynamic_offset=static_cast<uint32_t>(offset)};
+    }
+
+    template <typename T>
+    DrawDataAllocation Push(const T& data) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        DrawDataAllocation allocation = Allocate(sizeof(T));
+        std::memcpy(allocation.data, std::addressof(data), sizeof(T));
+        return allocation;
+    }
+
+    void Reset() noexcept {
+        current_block = 0;
+        head = 0;
+    }
+
+    size_t NumBlocks() const noexcept { return blocks.size(); }
+
+private:
+    void CreateBlock() {
+        if (blocks.size() >= max_blocks) {
+            throw std::runtime_error{std::format("FrameUniformArena: exceeded {} blocks of {} bytes\n",
+                                                 max_blocks, block_size)};
+        }
+        vk::raii::Device& device = allocator->GetDevice();
+        Buffer_t buffer{*allocator, BufferInfo{.size=block_size, .usage=vk::BufferUsageFlagBits::eUniformBuffer}};
+        std::byte* mapped = static_cast<std::byte*>(buffer.Map());
+        // Sets are freed with the pool; see GraphicsPass::CreateDescriptorSets
+        auto raii_sets = device.allocateDescriptorSets({
+            .descriptorPool=*pool,
+            .descriptorSetCount=1,
+            .pSetLayouts=std::addressof(layout)
+        });
+        vk::DescriptorSet set = raii_sets.at(0).release();
+        vk::DescriptorBufferInfo buffer_info{.buffer=buffer.AsVkBuffer(), .offset=0, .range=range};
+        device.updateDescriptorSets({vk::WriteDescriptorSet{
+            .dstSet=set,
+            .dstBinding=binding,
+            .dstArrayElement=0,
+            .descriptorCount=1,
+            .descriptorType=vk::DescriptorType::eUniformBufferDynamic,
+            .pImageInfo=nullptr,
+            .pBufferInfo=std::addressof(buffer_info),
+            .pTexelBufferView=nullptr
+        }}, {});
+        blocks.push_back({.buffer=std::move(buffer), .mapped=mapped, .set=set});
+    }
+};
+
+
+/***
+ * Per draw data writer for a single command buffer and pass.  Data that fits the push constant range is pushed;
+ * anything larger goes to the arena and the set is bound with its dynamic offset.
+ *
+ * Vulkan requires a bind call to change a dynamic offset, but the set handle only changes when the arena moves to a
+ * new block, so no descriptor writes or allocations happen per draw.  The draw data set should be the last set of
+ * the pass and is not required in the sets given to GraphicsPass::ToCommands.
+ */
+template <template <typename> typename Container_t, typename Mutex_t/*=jms::NoMutex*/>
+class DrawDataWriter {
+    GraphicsPass* pass{nullptr};
+    FrameUniformArena<Container_t, Mutex_t>* arena{nullptr};
+    std::optional<size_t> push_constant_range_index{};
+    uint32_t set_index{0};
+
+public:
+    DrawDataWriter(GraphicsPass& pass,
+                   FrameUniformArena<Container_t, Mutex_t>& arena,
+                   std::optional<size_t> push_constant_range_index,
+                   uint32_t set_index)
+    : pass{std::addressof(pass)},
+      arena{std::addressof(arena)},
+      push_constant_range_index{push_constant_range_index},
+      set_index{set_index}
+    {}
+    DrawDataWriter(const DrawDataWriter&) = delete;
+    DrawDataWriter(DrawDataWriter&&) noexcept = default;
+    ~DrawDataWriter() noexcept = default;
+    DrawDataWriter& operator=(const DrawDataWriter&) = delete;
+    DrawDataWriter& operator=(DrawDataWriter&&) noexcept = default;
+
+    template <typename T>
+    void Write(vk::raii::CommandBuffer& command_buffer, const T& data) {
+        if (push_constant_range_index.has_value() &&
+            pass->FitsPushConstants(push_constant_range_index.value(), sizeof(T))) {
+            pass->PushConstants(command_buffer, push_constant_range_index.value(), data);
+            return;
+        }
+        DrawDataAllocation allocation = arena->Push(data);
+        command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, **pass->pipeline_layout, set_index,
+                                          {allocation.set}, {allocation.dynamic_offset});
+    }
+};
+
+
+}
+}
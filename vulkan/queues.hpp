@@ -0,0 +1,200 @@
+#pragma once
+
+
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "jms/vulkan/vulkan.hpp"
+
+
+namespace jms {
+namespace vulkan {
+
+
+enum class QueueRole {
+    GRAPHICS,
+    PRESENT,
+    COMPUTE,
+    TRANSFER
+};
+
+
+/***
+ * compute  - async compute family; has compute but not graphics.
+ * transfer - dedicated transfer (DMA) family; has transfer but neither graphics nor compute.
+ * Both are nullopt when the device only exposes a single family (e.g. lavapipe); work then falls back to graphics.
+ */
+struct QueueFamilySelection {
+    uint32_t graphics{0};
+    std::optional<uint32_t> compute{};
+    std::optional<uint32_t> transfer{};
+};
+
+
+// The graphics family must also support present when a surface is given; graphics and present share the family.
+QueueFamilySelection SelectQueueFamilies(const vk::raii::PhysicalDevice& physical_device,
+                                         const vk::raii::SurfaceKHR* surface = nullptr) {
+    std::vector<vk::QueueFamilyProperties> props = physical_device.getQueueFamilyProperties();
+    auto Has = [](const vk::QueueFamilyProperties& p, vk::QueueFlags flags) {
+        return p.queueCount > 0 && (p.queueFlags & flags) == flags;
+    };
+    auto Lacks = [](const vk::QueueFamilyProperties& p, vk::QueueFlags flags) {
+        return !static_cast<bool>(p.queueFlags & flags);
+    };
+
+    QueueFamilySelection out{};
+    std::optional<uint32_t> graphics{};
+    for (uint32_t i : std::views::iota(static_cast<uint32_t>(0), static_cast<uint32_t>(props.size()))) {
+        if (!Has(props[i], vk::QueueFlagBits::eGraphics)) { continue; }
+        if (surface && !physical_device.getSurfaceSupportKHR(i, **surface)) { continue; }
+        graphics = i;
+        break;
+    }
+    if (!graphics) { throw std::runtime_error{"SelectQueueFamilies: no graphics (and present) queue family."}; }
+    out.graphics = graphics.value();
+
+    for (uint32_t i : std::views::iota(static_cast<uint32_t>(0), static_cast<uint32_t>(props.size()))) {
+        if (!out.compute && Has(props[i], vk::QueueFlagBits::eCompute) &&
+            Lacks(props[i], vk::QueueFlagBits::eGraphics)) {
+            out.compute = i;
+        }
+        if (!out.transfer && Has(props[i], vk::QueueFlagBits::eTransfer) &&
+            Lacks(props[i], vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute)) {
+            out.transfer = i;
+        }
+    }
+    return out;
+}
+
+
+/***
+ * Queues of a device by role.  Roles without a dedicated queue resolve to the next most capable queue:
+ * TRANSFER -> COMPUTE -> GRAPHICS, COMPUTE -> GRAPHICS and PRESENT -> GRAPHICS.
+ */
+class QueueRegistry {
+    struct Entry {
+        QueueRole role;
+        uint32_t family_index;
+        uint32_t queue_index;
+        vk::raii::Queue queue;
+    };
+
+    std::vector<Entry> entries{};
+
+public:
+    void Add(QueueRole role, vk::raii::Device& device, uint32_t family_index, uint32_t queue_index) {
+        if (std::ranges::find(entries, role, &Entry::role) != entries.end()) {
+            throw std::runtime_error{std::format("QueueRegistry: role {} already registered.\n",
+                                                 static_cast<int>(role))};
+        }
+        entries.push_back({
+            .role=role,
+            .family_index=family_index,
+            .queue_index=queue_index,
+            .queue=vk::raii::Queue{device, family_index, queue_index}
+        });
+    }
+
+    vk::raii::Queue& Get(QueueRole role) { return Find(role).queue; }
+    uint32_t FamilyIndex(QueueRole role) const { return Find(role).family_index; }
+
+    // True when the role has its own family; i.e. resources shared with graphics need ownership transfers.
+    bool IsDedicated(QueueRole role) const { return FamilyIndex(role) != FamilyIndex(QueueRole::GRAPHICS); }
+
+    bool Contains(QueueRole role) const noexcept {
+        return std::ranges::find(entries, role, &Entry::role) != entries.end();
+    }
+
+private:
+    Entry& Find(QueueRole role) { return const_cast<Entry&>(std::as_const(*this).Find(role)); }
+
+    const Entry& Find(QueueRole role) const {
+        std::vector<QueueRole> fallbacks{role};
+        if (role == QueueRole::TRANSFER) { fallbacks.push_back(QueueRole::COMPUTE); }
+        if (role != QueueRole::GRAPHICS) { fallbacks.push_back(QueueRole::GRAPHICS); }
+        for (QueueRole r : fallbacks) {
+            auto it = std::ranges::find(entries, r, &Entry::role);
+            if (it != entries.end()) { return *it; }
+        }
+        throw std::runtime_error{"QueueRegistry: no graphics queue registered."};
+    }
+};
+
+
+/***
+ * Queue family ownership transfer for exclusive resources.  The release barrier is recorded on the source queue and
+ * the acquire barrier on the destination queue; the submits must be ordered with a semaphore (e.g.
+ * SubmissionTracker::WaitInfo).  Any layout transition is given to both and performed once.
+ * Only needed when the families differ; see QueueRegistry::IsDedicated.
+ */
+struct OwnershipTransferScope {
+    uint32_t family_index{0};
+    vk::PipelineStageFlags2 stage{};
+    vk::AccessFlags2 access{};
+};
+
+
+std::pair<vk::BufferMemoryBarrier2, vk::BufferMemoryBarrier2> BufferOwnershipTransfer(
+    vk::Buffer buffer,
+    const OwnershipTransferScope& src,
+    const OwnershipTransferScope& dst,
+    vk::DeviceSize offset = 0,
+    vk::DeviceSize size = vk::WholeSize)
+{
+    vk::BufferMemoryBarrier2 release{
+        .srcStageMask=src.stage,
+        .srcAccessMask=src.access,
+        .dstStageMask=vk::PipelineStageFlagBits2::eNone,
+        .dstAccessMask=vk::AccessFlagBits2::eNone,
+        .srcQueueFamilyIndex=src.family_index,
+        .dstQueueFamilyIndex=dst.family_index,
+        .buffer=buffer,
+        .offset=offset,
+        .size=size
+    };
+    vk::BufferMemoryBarrier2 acquire = release;
+    acquire.srcStageMask = vk::PipelineStageFlagBits2::eNone;
+    acquire.srcAccessMask = vk::AccessFlagBits2::eNone;
+    acquire.dstStageMask = dst.stage;
+    acquire.dstAccessMask = dst.access;
+    return {release, acquire};
+}
+
+
+std::pair<vk::ImageMemoryBarrier2, vk::ImageMemoryBarrier2> ImageOwnershipTransfer(
+    vk::Image image,
+    const vk::ImageSubresourceRange& range,
+    vk::ImageLayout old_layout,
+    vk::ImageLayout new_layout,
+    const OwnershipTransferScope& src,
+    const OwnershipTransferScope& dst)
+{
+    vk::ImageMemoryBarrier2 release{
+        .srcStageMask=src.stage,
+        .srcAccessMask=src.access,
+        .dstStageMask=vk::PipelineStageFlagBits2::eNone,
+        .dstAccessMask=vk::AccessFlagBits2::eNone,
+        .oldLayout=old_layout,
+        .newLayout=new_layout,
+        .srcQueueFamilyIndex=src.family_index,
+        .dstQueueFamilyIndex=dst.family_index,
+        .image=image,
+        .subresourceRange=range
+    };
+    vk::ImageMemoryBarrier2 acquire = release;
+    acquire.srcStageMask = vk::PipelineStageFlagBits2::eNone;
+    acquire.srcAccessMask = vk::AccessFlagBits2::eNone;
+    acquire.dstStageMask = dst.stage;
+    acquire.dstAccessMask = dst.access;
+    return {release, acquire};
+}
+
+
+}
+}
@@ -0,0 +1,508 @@
+#pragma once
+
+
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <functional>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "jms/vulkan/vulkan.hpp"
+#include "jms/vulkan/info.hpp"
+#include "jms/vulkan/utils.hpp"
+
+
+namespace jms {
+namespace vulkan {
+
+
+constexpr vk::AccessFlags2 WRITE_ACCESS_FLAGS = vk::AccessFlagBits2::eShaderWrite |
+                                                vk::AccessFlagBits2::eShaderStorageWrite |
+                                                vk::AccessFlagBits2::eColorAttachmentWrite |
+                                                vk::AccessFlagBits2::eDepthStencilAttachmentWrite |
+                                                vk::AccessFlagBits2::eTransferWrite |
+                                                vk::AccessFlagBits2::eHostWrite |
+                                                vk::AccessFlagBits2::eMemoryWrite;
+
+
+bool IsWriteAccess(vk::AccessFlags2 access) noexcept { return static_cast<bool>(access & WRITE_ACCESS_FLAGS); }
+
+
+/***
+ * Transient images are created and owned for the graph; their contents do not live past the passes using them and
+ * images with identical create info and non overlapping lifetimes share one physical image.
+ * Imported (non transient) resources are graph outputs; passes writing them are never culled.
+ */
+struct RenderGraphResource {
+    std::string name{};
+    bool is_image{true};
+    bool transient{false};
+    ImageInfo image_info{};
+    vk::ImageSubresourceRange range{
+        .aspectMask{vk::ImageAspectFlagBits::eColor},
+        .baseMipLevel{0},
+        .levelCount{1},
+        .baseArrayLayer{0},
+        .layerCount{1}
+    };
+    // Imported only; state of the resource at the start of the graph, e.g. the swapchain acquire wait stage.
+    vk::ImageLayout initial_layout{vk::ImageLayout::eUndefined};
+    vk::PipelineStageFlags2 initial_stage{vk::PipelineStageFlagBits2::eNone};
+    vk::AccessFlags2 initial_access{vk::AccessFlagBits2::eNone};
+    std::optional<vk::ImageLayout> final_layout{};
+};
+
+
+struct RenderGraphAccess {
+    size_t resource{0};
+    vk::PipelineStageFlags2 stage{};
+    vk::AccessFlags2 access{};
+    vk::ImageLayout layout{vk::ImageLayout::eUndefined};
+};
+
+
+struct RenderGraphPass {
+    std::string name{};
+    std::vector<RenderGraphAccess> reads{};
+    std::vector<RenderGraphAccess> writes{};
+    // Never culled; e.g. readback or debug output.
+    bool has_side_effects{false};
+    // Typically calls GraphicsPass::ToCommands.
+    std::function<void(vk::raii::CommandBuffer&)> record{};
+};
+
+
+struct RenderGraphBarrier {
+    size_t physical{0};
+    vk::PipelineStageFlags2 src_stage{};
+    vk::AccessFlags2 src_access{};
+    vk::PipelineStageFlags2 dst_stage{};
+    vk::AccessFlags2 dst_access{};
+    vk::ImageLayout old_layout{vk::ImageLayout::eUndefined};
+    vk::ImageLayout new_layout{vk::ImageLayout::eUndefined};
+};
+
+
+struct RenderGraphPhysical {
+    size_t first_resource{0};
+    bool is_image{true};
+    bool transient{false};
+    vk::ImageSubresourceRange range{};
+    // Union of the lifetimes of the resources assigned to it.
+    std::optional<std::pair<size_t, size_t>> lifetime{};
+    // Stages/writes still outstanding at the end of the graph; see RenderGraph::AddMemoryAliasBarriers
+    vk::PipelineStageFlags2 last_stages{};
+    vk::AccessFlags2 last_access{};
+};
+
+
+/***
+ * Output of RenderGraph::Compile; only plain data so compiling can be checked without a device.
+ *
+ * order           - pass indices in execution order; culled passes are absent.
+ * barriers        - barriers recorded before order[i] in a single vkCmdPipelineBarrier2.
+ * final_barriers  - transitions of imported images to their final layouts.
+ * physical_of     - resource index to physical index; transient images may share a physical index and unused
+ *                   transients have none.
+ * lifetimes       - per resource [first, last] position in order; nullopt when unused.
+ */
+struct CompiledRenderGraph {
+    std::vector<size_t> order{};
+    std::vector<std::vector<RenderGraphBarrier>> barriers{};
+    std::vector<RenderGraphBarrier> final_barriers{};
+    std::vector<std::optional<size_t>> physical_of{};
+    std::vector<RenderGraphPhysical> physicals{};
+    std::vector<std::optional<std::pair<size_t, size_t>>> lifetimes{};
+
+    size_t NumBarrierCalls() const noexcept {
+        return std::ranges::count_if(barriers, [](const auto& b) { return !b.empty(); }) +
+               (final_barriers.empty() ? 0 : 1);
+    }
+};
+
+
+// Per physical handle given to Execute; vk::Image for image physicals and vk::Buffer for buffer physicals.
+using RenderGraphHandle = std::variant<vk::Image, vk::Buffer>;
+
+
+/***
+ * Declaration order is execution order: passes run in the order they were added, so declare producers before their
+ * consumers.  Hazards follow from that order; a pass depends on the last earlier writer of everything it accesses and,
+ * when writing, on the earlier readers since that write.  Compile culls passes that do not contribute to an imported
+ * resource (or have side effects), assigns transient images to physical images and computes the minimal barriers with
+ * exact stage and access masks.
+ */
+class RenderGraph {
+    std::vector<RenderGraphResource> resources{};
+    std::vector<RenderGraphPass> passes{};
+
+public:
+    size_t AddResource(const RenderGraphResource& resource) {
+        if (resource.transient && !resource.is_image) {
+            throw std::runtime_error{std::format("RenderGraph: transient buffer {} is not supported.\n",
+                                                 resource.name)};
+        }
+        resources.push_back(resource);
+        return resources.size() - 1;
+    }
+
+    size_t AddPass(RenderGraphPass pass) {
+        for (const auto& access : pass.reads) { ValidateAccess(pass, access, false); }
+        for (const auto& access : pass.writes) { ValidateAccess(pass, access, true); }
+        passes.push_back(std::move(pass));
+        return passes.size() - 1;
+    }
+
+    const std::vector<RenderGraphResource>& Resources() const noexcept { return resources; }
+    const std::vector<RenderGraphPass>& Passes() const noexcept { return passes; }
+
+    CompiledRenderGraph Compile() const {
+        CompiledRenderGraph out{};
+        std::vector<bool> kept = Cull();
+        out.order = ExecutionOrder(kept);
+        out.lifetimes = Lifetimes(out.order);
+        AssignPhysicals(out);
+        ComputeBarriers(out);
+        return out;
+    }
+
+    void Execute(vk::raii::CommandBuffer& command_buffer,
+                 const CompiledRenderGraph& compiled,
+                 const std::vector<RenderGraphHandle>& physical_handles) const {
+        if (physical_handles.size() != compiled.physicals.size()) {
+            throw std::runtime_error{std::format("RenderGraph::Execute: {} handles given for {} physical resources\n",
+                                                 physical_handles.size(), compiled.physicals.size())};
+        }
+        for (auto [pass_index, barriers] : std::views::zip(compiled.order, compiled.barriers)) {
+            RecordBarriers(command_buffer, compiled, physical_handles, barriers);
+            const RenderGraphPass& pass = passes.at(pass_index);
+            if (pass.record) { pass.record(command_buffer); }
+        }
+        RecordBarriers(command_buffer, compiled, physical_handles, compiled.final_barriers);
+    }
+
+    /***
+     * Transient physical images placed in shared memory (see TransientImageHeap) need an execution and memory
+     * dependency between the last use of the earlier image and the first use of the later one.  Each pair is
+     * (earlier, later) physical index; the later image's first barrier (always an UNDEFINED transition) is widened.
+     */
+    static void AddMemoryAliasBarriers(CompiledRenderGraph& compiled,
+                                       const std::vector<std::pair<size_t, size_t>>& physical_pairs) {
+        for (const auto& [earlier, later] : physical_pairs) {
+            const RenderGraphPhysical& src = compiled.physicals.at(earlier);
+            const RenderGraphPhysical& dst = compiled.physicals.at(later);
+            if (!src.lifetime || !dst.lifetime || src.lifetime->second >= dst.lifetime->first) {
+                throw std::runtime_error{std::format("RenderGraph: physicals {} and {} cannot alias memory\n",
+                                                     earlier, later)};
+            }
+            auto& barriers = compiled.barriers.at(dst.lifetime->first);
+            auto it = std::ranges::find_if(barriers, [later](const auto& b) {
+                return b.physical == later && b.old_layout == vk::ImageLayout::eUndefined;
+            });
+            if (it == barriers.end()) {
+                throw std::runtime_error{std::format("RenderGraph: missing first use barrier for physical {}\n",
+                                                     later)};
+            }
+            it->src_stage |= src.last_stages;
+            it->src_access |= src.last_access;
+        }
+    }
+
+private:
+    void ValidateAccess(const RenderGraphPass& pass, const RenderGraphAccess& access, bool is_write) const {
+        if (access.resource >= resources.size()) {
+            throw std::runtime_error{std::format("RenderGraph: pass {} uses unknown resource {}\n",
+                                                 pass.name, access.resource)};
+        }
+        if (is_write != IsWriteAccess(access.access)) {
+            throw std::runtime_error{std::format("RenderGraph: pass {} {} of {} has mismatched access flags\n",
+                                                 pass.name, (is_write ? "write" : "read"),
+                                                 resources[access.resource].name)};
+        }
+        if (resources[access.resource].is_image && access.layout == vk::ImageLayout::eUndefined) {
+            throw std::runtime_error{std::format("RenderGraph: pass {} requires a layout for image {}\n",
+                                                 pass.name, resources[access.resource].name)};
+        }
+    }
+
+    static std::vector<RenderGraphAccess> AllAccesses(const RenderGraphPass& pass) {
+        std::vector<RenderGraphAccess> accesses{pass.reads};
+        accesses.insert(accesses.end(), pass.writes.begin(), pass.writes.end());
+        return accesses;
+    }
+
+    // All accesses of a pass to a resource merged into one; a pass may only use one layout per image.
+    std::vector<RenderGraphAccess> MergedAccesses(const RenderGraphPass& pass) const {
+        std::vector<RenderGraphAccess> merged{};
+        merged.reserve(pass.reads.size() + pass.writes.size());
+        for (const auto& access : AllAccesses(pass)) {
+            auto it = std::ranges::find(merged, access.resource, &RenderGraphAccess::resource);
+            if (it == merged.end()) {
+                merged.push_back(access);
+                continue;
+            }
+            if (it->layout != access.layout) {
+                throw std::runtime_error{std::format("RenderGraph: pass {} uses {} in two layouts\n",
+                                                     pass.name, resources[access.resource].name)};
+            }
+            it->stage |= access.stage;
+            it->access |= access.access;
+        }
+        return merged;
+    }
+
+    std::vector<bool> Cull() const {
+        std::vector<bool> kept(passes.size(), false);
+        std::vector<bool> needed(resources.size(), false);
+        for (size_t i = passes.size(); i-- > 0;) {
+            const RenderGraphPass& pass = passes[i];
+            kept[i] = pass.has_side_effects || std::ranges::any_of(pass.writes, [this, &needed](const auto& access) {
+                return !resources[access.resource].transient || needed[access.resource];
+            });
+            if (!kept[i]) { continue; }
+            for (const auto& access : pass.reads) { needed[access.resource] = true; }
+        }
+        return kept;
+    }
+
+    // Kept passes in declaration order; see the class comment.
+    static std::vector<size_t> ExecutionOrder(const std::vector<bool>& kept) {
+        std::vector<size_t> order{};
+        for (size_t i = 0; i < kept.size(); ++i) {
+            if (kept[i]) { order.push_back(i); }
+        }
+        return order;
+    }
+
+    std::vector<std::optional<std::pair<size_t, size_t>>> Lifetimes(const std::vector<size_t>& order) const {
+        std::vector<std::optional<std::pair<size_t, size_t>>> lifetimes(resources.size());
+        for (size_t position = 0; position < order.size(); ++position) {
+            const RenderGraphPass& pass = passes[order[position]];
+            for (const auto& access : AllAccesses(pass)) {
+                auto& lifetime = lifetimes[access.resource];
+                if (!lifetime) { lifetime = std::pair{position, position}; }
+                else { lifetime->second = position; }
+            }
+        }
+        return lifetimes;
+    }
+
+    static bool IsAliasCompatible(const ImageInfo& a, const ImageInfo& b) noexcept {
+        return a.flags == b.flags && a.image_type == b.image_type && a.format == b.format &&
+               a.extent == b.extent && a.mip_levels == b.mip_levels && a.array_layers == b.array_layers &&
+               a.samples == b.samples && a.tiling == b.tiling && a.usage == b.usage;
+    }
+
+    void AssignPhysicals(CompiledRenderGraph& out) const {
+        out.physical_of.assign(resources.size(), std::nullopt);
+        // Last position each transient physical is in use.
+        std::vector<std::optional<size_t>> physical_last_use{};
+
+        std::vector<size_t> by_first_use{};
+        for (size_t i = 0; i < resources.size(); ++i) {
+            if (resources[i].transient && out.lifetimes[i]) { by_first_use.push_back(i); }
+        }
+        std::ranges::sort(by_first_use, {}, [&out](size_t i) { return out.lifetimes[i]->first; });
+
+        auto AddPhysical = [&out, &physical_last_use](size_t resource_index, const RenderGraphResource& resource) {
+            out.physicals.push_back({
+                .first_resource=resource_index,
+                .is_image=resource.is_image,
+                .transient=resource.transient,
+                .range=resource.range
+            });
+            physical_last_use.emplace_back();
+            return out.physicals.size() - 1;
+        };
+
+        for (size_t i = 0; i < resources.size(); ++i) {
+            if (!resources[i].transient) { out.physical_of[i] = AddPhysical(i, resources[i]); }
+        }
+        for (size_t i : by_first_use) {
+            const auto& lifetime = out.lifetimes[i].value();
+            std::optional<size_t> reuse{};
+            for (size_t p = 0; p < out.physicals.size() && !reuse; ++p) {
+                const auto& physical = out.physicals[p];
+                if (physical.transient && physical_last_use[p] && *physical_last_use[p] < lifetime.first &&
+                    physical.range == resources[i].range &&
+                    IsAliasCompatible(resources[physical.first_resource].image_info, resources[i].image_info)) {
+                    reuse = p;
+                }
+            }
+            size_t physical = reuse.has_value() ? reuse.value() : AddPhysical(i, resources[i]);
+            out.physical_of[i] = physical;
+            physical_last_use[physical] = lifetime.second;
+        }
+
+        for (size_t i = 0; i < resources.size(); ++i) {
+            if (!out.physical_of[i] || !out.lifetimes[i]) { continue; }
+            auto& physical_lifetime = out.physicals[out.physical_of[i].value()].lifetime;
+            const auto& lifetime = out.lifetimes[i].value();
+            if (!physical_lifetime) { physical_lifetime = lifetime; }
+            physical_lifetime->first = std::min(physical_lifetime->first, lifetime.first);
+            physical_lifetime->second = std::max(physical_lifetime->second, lifetime.second);
+        }
+    }
+
+    void ComputeBarriers(CompiledRenderGraph& out) const {
+        struct State {
+            vk::PipelineStageFlags2 write_stages{};
+            vk::AccessFlags2 write_access{};
+            vk::PipelineStageFlags2 read_stages{};
+            vk::PipelineStageFlags2 visible_stages{};
+            vk::AccessFlags2 visible_access{};
+            vk::ImageLayout layout{vk::ImageLayout::eUndefined};
+            std::optional<size_t> owner{};
+        };
+        std::vector<State> states(out.physicals.size());
+        for (size_t p = 0; p < out.physicals.size(); ++p) {
+            const RenderGraphResource& resource = resources[out.physicals[p].first_resource];
+            if (resource.transient) { continue; }
+            states[p] = {
+                .write_stages=resource.initial_stage,
+                .write_access=(resource.initial_access & WRITE_ACCESS_FLAGS),
+                .read_stages=(IsWriteAccess(resource.initial_access) ?
+                              vk::PipelineStageFlags2{} : resource.initial_stage),
+                .layout=resource.initial_layout,
+                .owner=out.physicals[p].first_resource
+            };
+        }
+
+        out.barriers.resize(out.order.size());
+        for (size_t position = 0; position < out.order.size(); ++position) {
+            for (const auto& access : MergedAccesses(passes[out.order[position]])) {
+                size_t physical = out.physical_of[access.resource].value();
+                State& state = states[physical];
+                bool is_image = resources[access.resource].is_image;
+                bool is_write = IsWriteAccess(access.access);
+                if (state.owner != access.resource) {
+                    // Transient taking over a physical image; previous contents are discarded.
+                    state.layout = vk::ImageLayout::eUndefined;
+                    state.write_access = {};
+                    state.read_stages |= state.write_stages;
+                    state.write_stages = {};
+                    state.owner = access.resource;
+                }
+                bool layout_change = is_image && state.layout != access.layout;
+
+                if (!is_write && !layout_change) {
+                    bool visible = (access.stage & state.visible_stages) == access.stage &&
+                                   (access.access & state.visible_access) == access.access;
+                    if (state.write_access && !visible) {
+                        out.barriers[position].push_back({
+                            .physical=physical,
+                            .src_stage=state.write_stages,
+                            .src_access=state.write_access,
+                            .dst_stage=access.stage,
+                            .dst_access=access.access,
+                            .old_layout=state.layout,
+                            .new_layout=state.layout
+                        });
+                        state.visible_stages |= access.stage;
+                        state.visible_access |= access.access;
+                    }
+                    state.read_stages |= access.stage;
+                    continue;
+                }
+
+                vk::PipelineStageFlags2 src_stage = state.write_stages | state.read_stages;
+                if (layout_change || src_stage) {
+                    out.barriers[position].push_back({
+                        .physical=physical,
+                        .src_stage=src_stage,
+                        .src_access=state.write_access,
+                        .dst_stage=access.stage,
+                        .dst_access=access.access,
+                        .old_layout=(is_image ? state.layout : vk::ImageLayout::eUndefined),
+                        .new_layout=(is_image ? access.layout : vk::ImageLayout::eUndefined)
+                    });
+                }
+                state.layout = access.layout;
+                if (is_write) {
+                    state.write_stages = access.stage;
+                    state.write_access = access.access & WRITE_ACCESS_FLAGS;
+                    state.read_stages = {};
+                    state.visible_stages = {};
+                    state.visible_access = {};
+                } else {
+                    // Layout transition for a read; the barrier made it visible to this access.
+                    state.write_stages = {};
+                    state.write_access = {};
+                    state.read_stages = access.stage;
+                    state.visible_stages = access.stage;
+                    state.visible_access = access.access;
+                }
+            }
+        }
+
+        for (size_t p = 0; p < out.physicals.size(); ++p) {
+            out.physicals[p].last_stages = states[p].write_stages | states[p].read_stages;
+            out.physicals[p].last_access = states[p].write_access;
+            const RenderGraphResource& resource = resources[out.physicals[p].first_resource];
+            if (resource.transient || !resource.final_layout || resource.final_layout == states[p].layout) { continue; }
+            out.final_barriers.push_back({
+                .physical=p,
+                .src_stage=(states[p].write_stages | states[p].read_stages),
+                .src_access=states[p].write_access,
+                .dst_stage=vk::PipelineStageFlagBits2::eNone,
+                .dst_access=vk::AccessFlagBits2::eNone,
+                .old_layout=states[p].layout,
+                .new_layout=resource.final_layout.value()
+            });
+        }
+    }
+
+    void RecordBarriers(vk::raii::CommandBuffer& command_buffer,
+                        const CompiledRenderGraph& compiled,
+                        const std::vector<RenderGraphHandle>& physical_handles,
+                        const std::vector<RenderGraphBarrier>& barriers) const {
+        if (barriers.empty()) { return; }
+        std::vector<vk::ImageMemoryBarrier2> image_barriers{};
+        std::vector<vk::BufferMemoryBarrier2> buffer_barriers{};
+        for (const auto& barrier : barriers) {
+            const RenderGraphPhysical& physical = compiled.physicals.at(barrier.physical);
+            const RenderGraphHandle& handle = physical_handles.at(barrier.physical);
+            if (physical.is_image) {
+                image_barriers.push_back({
+                    .srcStageMask=barrier.src_stage,
+                    .srcAccessMask=barrier.src_access,
+                    .dstStageMask=barrier.dst_stage,
+                    .dstAccessMask=barrier.dst_access,
+                    .oldLayout=barrier.old_layout,
+                    .newLayout=barrier.new_layout,
+                    .srcQueueFamilyIndex=vk::QueueFamilyIgnored,
+                    .dstQueueFamilyIndex=vk::QueueFamilyIgnored,
+                    .image=std::get<vk::Image>(handle),
+                    .subresourceRange=physical.range
+                });
+            } else {
+                buffer_barriers.push_back({
+                    .srcStageMask=barrier.src_stage,
+                    .srcAccessMask=barrier.src_access,
+                    .dstStageMask=barrier.dst_stage,
+                    .dstAccessMask=barrier.dst_access,
+                    .srcQueueFamilyIndex=vk::QueueFamilyIgnored,
+                    .dstQueueFamilyIndex=vk::QueueFamilyIgnored,
+                    .buffer=std::get<vk::Buffer>(handle),
+                    .offset=0,
+                    .size=vk::WholeSize
+                });
+            }
+        }
+        command_buffer.pipelineBarrier2({
+            .bufferMemoryBarrierCount=static_cast<uint32_t>(buffer_barriers.size()),
+            .pBufferMemoryBarriers=VectorAsPtr(buffer_barriers),
+            .imageMemoryBarrierCount=static_cast<uint32_t>(image_barriers.size()),
+            .pImageMemoryBarriers=VectorAsPtr(image_barriers)
+        });
+    }
+};
+
+
+}
+}
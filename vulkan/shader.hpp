@@ -2,15 +2,20 @@
 
 
 #include <algorithm>
+#include <cstddef>
 #include <filesystem>
 #include <format>
 #include <fstream>
+#include <future>
+#include <numeric>
 #include <optional>
 #include <ranges>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "jms/utils/executor.hpp"
 #include "jms/vulkan/vulkan.hpp"
 #include "jms/vulkan/utils.hpp"
 
@@ -27,43 +32,196 @@ struct ShaderGroup {
         vk::ShaderStageFlags next_stage{};
         vk::ShaderCodeTypeEXT code_type{vk::ShaderCodeTypeEXT::eSpirv};
         std::vector<uint32_t> code{};
+        // Borrowed SPIR-V (e.g. from a ShaderPack) used when code is empty; must outlive shader creation.
+        std::span<const uint32_t> code_view{};
         std::string entry_point_name{};
         std::vector<size_t> set_info_indices{};
         std::vector<size_t> push_constant_ranges_indices{};
         std::optional<vk::SpecializationInfo> specialization_info{};
+
+        std::span<const uint32_t> Code() const noexcept { return code.empty() ? code_view : std::span{code}; }
     };
 
     std::vector<vk::VertexInputAttributeDescription2EXT> vertex_attribute_desc{};
     std::vector<vk::VertexInputBindingDescription2EXT> vertex_binding_desc{};
     std::vector<vk::PushConstantRange> push_constant_ranges{};
     std::vector<std::vector<vk::DescriptorSetLayoutBinding>> set_layout_bindings{};
+    // Optional; indexed the same as set_layout_bindings.  Missing entries mean no flags.
+    std::vector<vk::DescriptorSetLayoutCreateFlags> set_layout_flags{};
+    std::vector<std::vector<vk::DescriptorBindingFlags>> set_layout_binding_flags{};
     std::vector<ShaderInfo> shader_infos{};
 
+    vk::DescriptorSetLayoutCreateFlags SetLayoutFlags(size_t set_index) const {
+        return set_index < set_layout_flags.size() ? set_layout_flags[set_index] : vk::DescriptorSetLayoutCreateFlags{};
+    }
+
+    const std::vector<vk::DescriptorBindingFlags>& SetLayoutBindingFlags(size_t set_index) const {
+        static const std::vector<vk::DescriptorBindingFlags> none{};
+        return set_index < set_layout_binding_flags.size() ? set_layout_binding_flags[set_index] : none;
+    }
+
+    // Sets from update after bind pools are allocated by their owner rather than from a pass descriptor pool.
+    bool IsExternalSet(size_t set_index) const {
+        return static_cast<bool>(SetLayoutFlags(set_index) &
+                                 vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool);
+    }
+
     // May want to switch to C api to take advantage of failure handles for retry.  Wait to see raii failures first.
     std::vector<vk::raii::ShaderEXT> CreateShaders(
         vk::raii::Device& device,
-        const std::vector<vk::raii::DescriptorSetLayout>& layouts,
+        const std::vector<vk::DescriptorSetLayout>& layouts,
+        std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt)
+    {
+        return CreateShaders(device, layouts, {}, vk_allocation_callbacks);
+    }
+
+    /***
+     * binaries is either empty or indexed the same as shader_infos; a non empty binary replaces the SPIR-V with
+     * vkGetShaderBinaryDataEXT output (code type eBinary) from the same shader info and device.  Linked shaders must
+     * all be binary or all SPIR-V.  See ShaderBinaryCache.
+     */
+    std::vector<vk::raii::ShaderEXT> CreateShaders(
+        vk::raii::Device& device,
+        const std::vector<vk::DescriptorSetLayout>& layouts,
+        const std::vector<std::span<const std::byte>>& binaries,
+        std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt)
+    {
+        if (!binaries.empty() && binaries.size() != shader_infos.size()) {
+            throw std::runtime_error{"ShaderGroup::CreateShaders: binaries must match shader_infos."};
+        }
+        std::vector<size_t> indices(shader_infos.size());
+        std::iota(indices.begin(), indices.end(), static_cast<size_t>(0));
+        return CreateShaderSubset(device, layouts, indices, binaries, vk_allocation_callbacks);
+    }
+
+    /***
+     * Same result as CreateShaders with the work spread over pool.  Each unlinked shader is its own task and all
+     * linked shaders form a single task since they must be created together.  Shaders are returned in shader_infos
+     * order; failures of every task are gathered into one exception after all tasks finish.
+     */
+    std::vector<vk::raii::ShaderEXT> CreateShadersParallel(
+        vk::raii::Device& device,
+        const std::vector<vk::DescriptorSetLayout>& layouts,
+        jms::ThreadPool& pool,
         std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt)
     {
+        std::vector<std::vector<size_t>> tasks{};
+        std::vector<size_t> linked{};
+        for (size_t i = 0; i < shader_infos.size(); ++i) {
+            if (shader_infos[i].flags & vk::ShaderCreateFlagBitsEXT::eLinkStage) {
+                linked.push_back(i);
+            } else {
+                tasks.push_back({i});
+            }
+        }
+        if (!linked.empty()) { tasks.push_back(std::move(linked)); }
+
+        std::vector<std::future<std::vector<vk::raii::ShaderEXT>>> futures{};
+        futures.reserve(tasks.size());
+        for (const auto& indices : tasks) {
+            futures.push_back(pool.Submit([this, &device, &layouts, &indices, vk_allocation_callbacks]() {
+                return CreateShaderSubset(device, layouts, indices, {}, vk_allocation_callbacks);
+            }));
+        }
+
+        std::vector<vk::raii::ShaderEXT> shaders{};
+        shaders.reserve(shader_infos.size());
+        for (size_t i = 0; i < shader_infos.size(); ++i) { shaders.emplace_back(nullptr); }
+        std::string errors{};
+        for (auto [indices, future] : std::views::zip(tasks, futures)) {
+            try {
+                for (auto [index, shader] : std::views::zip(indices, future.get())) {
+                    shaders[index] = std::move(shader);
+                }
+            } catch (const std::exception& e) {
+                std::string joined{};
+                for (size_t index : indices) { joined += std::format("{}{}", joined.empty() ? "" : ", ", index); }
+                errors += std::format("shader_infos [{}]: {}\n", joined, e.what());
+            }
+        }
+        if (!errors.empty()) {
+            throw std::runtime_error{std::format("ShaderGroup::CreateShadersParallel failed;\n{}", errors)};
+        }
+        return shaders;
+    }
+
+    // shader_infos[index] with its specialization replaced; the SPIR-V is borrowed, not copied.  Unlinked only.
+    vk::raii::ShaderEXT CreateSpecializedShader(
+        vk::raii::Device& device,
+        const std::vector<vk::DescriptorSetLayout>& layouts,
+        size_t index,
+        const vk::SpecializationInfo& specialization_info,
+        std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt) const
+    {
+        const ShaderInfo& base = shader_infos.at(index);
+        if (base.flags & vk::ShaderCreateFlagBitsEXT::eLinkStage) {
+            throw std::runtime_error{
+                "ShaderGroup::CreateSpecializedShader: linked shaders can't be specialized alone."};
+        }
+        ShaderGroup single{.push_constant_ranges=push_constant_ranges};
+        single.shader_infos.push_back({
+            .subgroup_size=base.subgroup_size,
+            .flags=base.flags,
+            .stage=base.stage,
+            .next_stage=base.next_stage,
+            .code_type=base.code_type,
+            .code_view=base.Code(),
+            .entry_point_name=base.entry_point_name,
+            .set_info_indices=base.set_info_indices,
+            .push_constant_ranges_indices=base.push_constant_ranges_indices,
+            .specialization_info=specialization_info
+        });
+        auto shaders = single.CreateShaders(device, layouts, vk_allocation_callbacks);
+        return std::move(shaders.at(0));
+    }
+
+    // Consider an uber validation function with custom exceptions vs current approach with individual validations.
+    void Validate(const std::vector<ShaderInfo>& shader_infos) {
+        if (auto it = std::ranges::find_if(shader_infos, ShaderGroup::IsUnlinkable); it != shader_infos.end()) {
+            throw std::runtime_error{"Shader info cannot be linked; invalid stage provided."};
+        }
+        if (auto it = std::ranges::find_if(shader_infos, ShaderGroup::IsBadFragment); it != shader_infos.end()) {
+            throw std::runtime_error{"ShaderExtInfo has bad fragment related flags."};
+        }
+        if (auto it = std::ranges::find_if(shader_infos, ShaderGroup::IsBadSubgroupSize, &ShaderInfo::subgroup_size);
+            it != shader_infos.end()) {
+            throw std::runtime_error{
+                "vk::PipelineShaderStageRequiredSubgroupSizeCreateInfo requires power of two size."};
+        }
+        // Do more of the rest of the required validation here ...
+    }
+
+private:
+    // binaries is either empty or indexed the same as shader_infos.
+    std::vector<vk::raii::ShaderEXT> CreateShaderSubset(
+        vk::raii::Device& device,
+        const std::vector<vk::DescriptorSetLayout>& layouts,
+        const std::vector<size_t>& indices,
+        const std::vector<std::span<const std::byte>>& binaries,
+        std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks) const
+    {
+        auto subset = indices | std::views::transform([this](size_t i) -> const ShaderInfo& {
+            return shader_infos.at(i);
+        });
         std::vector<vk::PipelineShaderStageRequiredSubgroupSizeCreateInfo> pnexts{};
-        pnexts.reserve(shader_infos.size());
-        std::ranges::transform(shader_infos, std::back_inserter(pnexts), [](auto& info) {
+        pnexts.reserve(indices.size());
+        std::ranges::transform(subset, std::back_inserter(pnexts), [](auto& info) {
             return vk::PipelineShaderStageRequiredSubgroupSizeCreateInfo{.requiredSubgroupSize=info.subgroup_size};
         });
 
         std::vector<std::vector<vk::DescriptorSetLayout>> info_vk_layouts{};
-        info_vk_layouts.reserve(shader_infos.size());
-        std::ranges::transform(shader_infos, std::back_inserter(info_vk_layouts),
+        info_vk_layouts.reserve(indices.size());
+        std::ranges::transform(subset, std::back_inserter(info_vk_layouts),
             [&layouts](auto& info) {
                 std::vector<vk::DescriptorSetLayout> vk_layouts{};
                 vk_layouts.reserve(info.set_info_indices.size());
-                for (size_t index : info.set_info_indices) { vk_layouts.push_back(*layouts.at(index)); }
+                for (size_t index : info.set_info_indices) { vk_layouts.push_back(layouts.at(index)); }
                 return vk_layouts;
             });
 
         std::vector<std::vector<vk::PushConstantRange>> info_pcrs{};
-        info_pcrs.reserve(shader_infos.size());
-        std::ranges::transform(shader_infos, std::back_inserter(info_pcrs),
+        info_pcrs.reserve(indices.size());
+        std::ranges::transform(subset, std::back_inserter(info_pcrs),
             [&pcr=push_constant_ranges](auto& info) {
                 std::vector<vk::PushConstantRange> pcrs{};
                 pcrs.reserve(info.push_constant_ranges_indices.size());
@@ -72,9 +230,9 @@ struct ShaderGroup {
             });
 
         std::vector<vk::ShaderCreateInfoEXT> create_infos{};
-        create_infos.reserve(shader_infos.size());
+        create_infos.reserve(indices.size());
         std::ranges::transform(
-            shader_infos,
+            subset,
             std::views::zip(pnexts, info_vk_layouts, info_pcrs),
             std::back_inserter(create_infos),
             [](auto& info, auto&& tup) -> vk::ShaderCreateInfoEXT {
@@ -85,8 +243,8 @@ struct ShaderGroup {
                     .stage=info.stage,
                     .nextStage=info.next_stage,
                     .codeType=info.code_type,
-                    .codeSize=(info.code.size() * sizeof(typename decltype(info.code)::value_type)),
-                    .pCode=info.code.data(),
+                    .codeSize=info.Code().size_bytes(),
+                    .pCode=info.Code().data(),
                     .pName=info.entry_point_name.c_str(),
                     .setLayoutCount=static_cast<uint32_t>(vk_layouts.size()),
                     .pSetLayouts=VectorAsPtr(vk_layouts),
@@ -96,27 +254,19 @@ struct ShaderGroup {
                                           std::addressof(info.specialization_info.value()) : nullptr)
                 };
             });
+        if (!binaries.empty()) {
+            for (auto [create_info, index] : std::views::zip(create_infos, indices)) {
+                const std::span<const std::byte>& binary = binaries.at(index);
+                if (binary.empty()) { continue; }
+                create_info.codeType = vk::ShaderCodeTypeEXT::eBinary;
+                create_info.codeSize = binary.size();
+                create_info.pCode = binary.data();
+            }
+        }
 
         return device.createShadersEXT(create_infos, vk_allocation_callbacks.value_or(nullptr));
     }
 
-    // Consider an uber validation function with custom exceptions vs current approach with individual validations.
-    void Validate(const std::vector<ShaderInfo>& shader_infos) {
-        if (auto it = std::ranges::find_if(shader_infos, ShaderGroup::IsUnlinkable); it != shader_infos.end()) {
-            throw std::runtime_error{"Shader info cannot be linked; invalid stage provided."};
-        }
-        if (auto it = std::ranges::find_if(shader_infos, ShaderGroup::IsBadFragment); it != shader_infos.end()) {
-            throw std::runtime_error{"ShaderExtInfo has bad fragment related flags."};
-        }
-        if (auto it = std::ranges::find_if(shader_infos, ShaderGroup::IsBadSubgroupSize, &ShaderInfo::subgroup_size);
-            it != shader_infos.end()) {
-            throw std::runtime_error{
-                "vk::PipelineShaderStageRequiredSubgroupSizeCreateInfo requires power of two size."};
-        }
-        // Do more of the rest of the required validation here ...
-    }
-
-private:
     static constexpr vk::ShaderStageFlags UNLINKABLE_STAGES = ~(vk::ShaderStageFlagBits::eAllGraphics |
                                                                 vk::ShaderStageFlagBits::eTaskEXT |
                                                                 vk::ShaderStageFlagBits::eMeshEXT);
@@ -147,24 +297,21 @@ private:
 };
 
 
+// Copies the file; prefer a ShaderPack when loading many shaders.
 std::vector<uint32_t> Load(const std::filesystem::path& path) {
-    if (!std::filesystem::exists(path)) {
-        throw std::runtime_error(std::format("Shader file does not exist: {}\n", path.string()));
-    }
     std::ifstream file{path, std::ios::ate | std::ios::binary};
     if (!file.is_open()) {
-        throw std::runtime_error(std::format("Filed to open shader file: {}\n", path.string()));
+        throw std::runtime_error(std::format("Failed to open shader file: {}\n", path.string()));
     }
     file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
     size_t num_bytes = static_cast<size_t>(file.tellg());
+    if (num_bytes == 0) {
+        throw std::runtime_error(std::format("Shader has no code; i.e. empty: {}\n", path.string()));
+    }
     size_t num_uint32 = (num_bytes / sizeof(uint32_t)) + ((num_bytes % sizeof(uint32_t) ? 1 : 0));
-    size_t total_bytes = num_uint32 * sizeof(uint32_t);
     std::vector<uint32_t> buffer(num_uint32, 0);
     file.seekg(0);
-    file.read(reinterpret_cast<char*>(buffer.data()), num_bytes);
-    if (buffer.empty()) {
-        throw std::runtime_error(std::format("Shader has no code; i.e. empty: {}\n", path.string()));
-    }
+    file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(num_bytes));
     return buffer;
 }
 
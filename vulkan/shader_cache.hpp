@@ -0,0 +1,357 @@
+#pragma once
+
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "jms/utils/hash.hpp"
+#include "jms/utils/mapped_file.hpp"
+#include "jms/vulkan/vulkan.hpp"
+#include "jms/vulkan/descriptor_buffer.hpp"
+#include "jms/vulkan/shader.hpp"
+
+
+namespace jms {
+namespace vulkan {
+
+
+constexpr uint32_t SHADER_CACHE_MAGIC = 0x43534d4a; // "JMSC"
+constexpr uint32_t SHADER_CACHE_FORMAT_VERSION = 1;
+// vkCreateShadersEXT requires pCode of binary shaders to be 16 byte aligned.
+constexpr size_t SHADER_CACHE_BLOB_ALIGNMENT = 16;
+
+
+/***
+ * File layout: header, entry table, then blobs at SHADER_CACHE_BLOB_ALIGNMENT; offsets are from the file start.
+ * The pipeline cache blob is the vkGetPipelineCacheData output for the pipeline path.
+ */
+struct ShaderCacheHeader {
+    uint32_t magic{SHADER_CACHE_MAGIC};
+    uint32_t format_version{SHADER_CACHE_FORMAT_VERSION};
+    std::array<uint8_t, vk::UuidSize> shader_binary_uuid{};
+    uint32_t shader_binary_version{0};
+    uint32_t num_entries{0};
+    uint64_t pipeline_cache_offset{0};
+    uint64_t pipeline_cache_size{0};
+};
+static_assert(sizeof(ShaderCacheHeader) == 48);
+
+
+struct ShaderCacheEntry {
+    uint64_t key{0};
+    uint64_t offset{0};
+    uint64_t size{0};
+};
+static_assert(sizeof(ShaderCacheEntry) == 24);
+
+
+/***
+ * Persistent cache of shader object binaries keyed by everything that affects the compiled shader: SPIR-V, stage,
+ * flags, entry point, set layouts, push constant ranges, specialization and the driver's shaderBinaryUUID.
+ *
+ * The file is memory mapped and binaries are handed to vkCreateShadersEXT straight from the mapping.  A file written
+ * by a different driver (shaderBinaryUUID or shaderBinaryVersion mismatch) is ignored as a whole and replaced on the
+ * next Save.  Not thread safe; look up and store from the thread creating the shaders.
+ */
+class ShaderBinaryCache {
+    std::filesystem::path path{};
+    std::array<uint8_t, vk::UuidSize> shader_binary_uuid{};
+    uint32_t shader_binary_version{0};
+    jms::MappedFile file{};
+    std::unordered_map<uint64_t, std::span<const std::byte>> mapped{};
+    std::unordered_map<uint64_t, std::vector<std::byte>> added{};
+    std::span<const std::byte> mapped_pipeline_cache{};
+    std::optional<std::vector<std::byte>> added_pipeline_cache{};
+    bool is_dirty{false};
+    size_t num_hits{0};
+    size_t num_misses{0};
+
+public:
+    ShaderBinaryCache(const vk::raii::PhysicalDevice& physical_device, std::filesystem::path path)
+    : path{std::move(path)}
+    {
+        auto props = physical_device.getProperties2<vk::PhysicalDeviceProperties2,
+                                                    vk::PhysicalDeviceShaderObjectPropertiesEXT>();
+        const auto& shader_object_props = props.get<vk::PhysicalDeviceShaderObjectPropertiesEXT>();
+        std::ranges::copy(shader_object_props.shaderBinaryUUID, shader_binary_uuid.begin());
+        shader_binary_version = shader_object_props.shaderBinaryVersion;
+        Load();
+    }
+    ShaderBinaryCache(const ShaderBinaryCache&) = delete;
+    ShaderBinaryCache(ShaderBinaryCache&&) noexcept = default;
+    ~ShaderBinaryCache() noexcept = default;
+    ShaderBinaryCache& operator=(const ShaderBinaryCache&) = delete;
+    ShaderBinaryCache& operator=(ShaderBinaryCache&&) noexcept = default;
+
+    // descriptor_model is the one the layouts were created for; it adds to their create flags (see GraphicsPass).
+    uint64_t Key(const ShaderGroup& group, size_t info_index, DescriptorModel descriptor_model) const {
+        const ShaderGroup::ShaderInfo& info = group.shader_infos.at(info_index);
+        jms::Fnv1a64 hash{};
+        hash.AddRange(shader_binary_uuid).Add(shader_binary_version);
+        hash.Add(static_cast<uint32_t>(info.flags)).Add(info.stage).Add(static_cast<uint32_t>(info.next_stage));
+        hash.Add(info.code_type).Add(info.subgroup_size).AddRange(info.Code()).Add(info.entry_point_name);
+        hash.Add(static_cast<uint64_t>(info.set_info_indices.size()));
+        for (size_t set_index : info.set_info_indices) {
+            hash.Add(static_cast<uint32_t>(group.SetLayoutFlags(set_index) |
+                                           DescriptorModelLayoutFlags(descriptor_model)));
+            for (const auto& binding : group.set_layout_bindings.at(set_index)) {
+                hash.Add(binding.binding).Add(binding.descriptorType).Add(binding.descriptorCount);
+                hash.Add(static_cast<uint32_t>(binding.stageFlags));
+            }
+            for (auto flags : group.SetLayoutBindingFlags(set_index)) { hash.Add(static_cast<uint32_t>(flags)); }
+        }
+        hash.Add(static_cast<uint64_t>(info.push_constant_ranges_indices.size()));
+        for (size_t index : info.push_constant_ranges_indices) {
+            const vk::PushConstantRange& range = group.push_constant_ranges.at(index);
+            hash.Add(static_cast<uint32_t>(range.stageFlags)).Add(range.offset).Add(range.size);
+        }
+        if (info.specialization_info) {
+            const vk::SpecializationInfo& spec = info.specialization_info.value();
+            for (uint32_t i = 0; i < spec.mapEntryCount; ++i) {
+                hash.Add(spec.pMapEntries[i].constantID).Add(spec.pMapEntries[i].offset);
+                hash.Add(static_cast<uint64_t>(spec.pMapEntries[i].size));
+            }
+            hash.AddBytes({static_cast<const std::byte*>(spec.pData), spec.dataSize});
+        }
+        return hash.Value();
+    }
+
+    std::optional<std::span<const std::byte>> Find(uint64_t key) const {
+        if (auto it = added.find(key); it != added.end()) { return std::span<const std::byte>{it->second}; }
+        if (auto it = mapped.find(key); it != mapped.end()) { return it->second; }
+        return std::nullopt;
+    }
+
+    void Store(uint64_t key, std::vector<std::byte>&& binary) {
+        added.insert_or_assign(key, std::move(binary));
+        is_dirty = true;
+    }
+
+    /***
+     * ShaderGroup::CreateShaders through the cache with layouts created for descriptor_model; e.g. a GraphicsPass's
+     * vk_layouts and descriptor_model.  Hits are created from their binaries; misses from SPIR-V and their binaries
+     * stored.  Linked shaders are only created from binaries when every shader of the link hits.
+     *
+     * The driver rejects a binary with VK_INCOMPATIBLE_SHADER_BINARY_EXT, a success code, and a null handle for that
+     * shader (e.g. after a driver update mid run).  Those shaders, and the whole link when one of them is linked, are
+     * rebuilt from SPIR-V and their stale entries replaced.  Older drivers report it as an error instead; then every
+     * mapped entry is dropped and the group is retried from SPIR-V.
+     */
+    std::vector<vk::raii::ShaderEXT> CreateShaders(
+        ShaderGroup& group,
+        vk::raii::Device& device,
+        const std::vector<vk::DescriptorSetLayout>& layouts,
+        DescriptorModel descriptor_model,
+        std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt)
+    {
+        size_t num_infos = group.shader_infos.size();
+        std::vector<uint64_t> keys(num_infos, 0);
+        std::vector<std::span<const std::byte>> binaries(num_infos);
+        bool all_linked_hit = true;
+        for (size_t i = 0; i < num_infos; ++i) {
+            keys[i] = Key(group, i, descriptor_model);
+            if (auto binary = Find(keys[i]); binary) {
+                binaries[i] = binary.value();
+            } else if (IsLinked(group.shader_infos[i])) {
+                all_linked_hit = false;
+            }
+        }
+        if (!all_linked_hit) {
+            for (size_t i = 0; i < num_infos; ++i) {
+                if (IsLinked(group.shader_infos[i])) { binaries[i] = {}; }
+            }
+        }
+
+        std::vector<vk::raii::ShaderEXT> shaders{};
+        try {
+            shaders = group.CreateShaders(device, layouts, binaries, vk_allocation_callbacks);
+        } catch (const vk::SystemError&) {
+            if (std::ranges::all_of(binaries, [](const auto& b) { return b.empty(); })) { throw; }
+            mapped.clear();
+            is_dirty = true;
+            binaries.assign(num_infos, {});
+            shaders = group.CreateShaders(device, layouts, binaries, vk_allocation_callbacks);
+        }
+
+        std::vector<size_t> rejected{};
+        bool is_link_rejected = false;
+        for (size_t i = 0; i < num_infos; ++i) {
+            if (binaries[i].empty() || *shaders[i]) { continue; }
+            rejected.push_back(i);
+            is_link_rejected = is_link_rejected || IsLinked(group.shader_infos[i]);
+        }
+        if (!rejected.empty()) {
+            for (size_t i = 0; i < num_infos; ++i) {
+                if (is_link_rejected && IsLinked(group.shader_infos[i])) { rejected.push_back(i); }
+            }
+            for (size_t i : rejected) {
+                binaries[i] = {};
+                mapped.erase(keys[i]);
+                added.erase(keys[i]);
+            }
+            is_dirty = true;
+            shaders = group.CreateShaders(device, layouts, binaries, vk_allocation_callbacks);
+            if (std::ranges::any_of(shaders, [](const auto& shader) { return !*shader; })) {
+                throw std::runtime_error{"ShaderBinaryCache::CreateShaders: shader creation from SPIR-V failed."};
+            }
+        }
+
+        for (size_t i = 0; i < num_infos; ++i) {
+            if (!binaries[i].empty()) {
+                ++num_hits;
+                continue;
+            }
+            ++num_misses;
+            std::vector<uint8_t> data = shaders[i].getBinaryData();
+            std::vector<std::byte> binary(data.size());
+            std::memcpy(binary.data(), data.data(), data.size());
+            Store(keys[i], std::move(binary));
+        }
+        return shaders;
+    }
+
+    vk::raii::PipelineCache CreatePipelineCache(
+        vk::raii::Device& device,
+        std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt) const
+    {
+        // The driver validates the blob header and starts empty when it is incompatible.
+        std::span<const std::byte> data = added_pipeline_cache ? std::span<const std::byte>{*added_pipeline_cache} :
+                                                                 mapped_pipeline_cache;
+        return device.createPipelineCache({
+            .initialDataSize=data.size(),
+            .pInitialData=(data.empty() ? nullptr : data.data())
+        }, vk_allocation_callbacks.value_or(nullptr));
+    }
+
+    void StorePipelineCache(const vk::raii::PipelineCache& pipeline_cache) {
+        std::vector<uint8_t> data = pipeline_cache.getData();
+        std::vector<std::byte> blob(data.size());
+        std::memcpy(blob.data(), data.data(), data.size());
+        added_pipeline_cache = std::move(blob);
+        is_dirty = true;
+    }
+
+    // Writes to a temporary file then renames over the cache so a crash never leaves a truncated cache.
+    void Save() {
+        if (!is_dirty) { return; }
+        std::vector<std::pair<uint64_t, std::span<const std::byte>>> blobs{};
+        blobs.reserve(mapped.size() + added.size());
+        for (const auto& [key, binary] : mapped) {
+            if (!added.contains(key)) { blobs.emplace_back(key, binary); }
+        }
+        for (const auto& [key, binary] : added) { blobs.emplace_back(key, std::span<const std::byte>{binary}); }
+        std::ranges::sort(blobs, {}, [](const auto& p) { return p.first; });
+        std::span<const std::byte> pipeline_cache_data = added_pipeline_cache ?
+            std::span<const std::byte>{*added_pipeline_cache} : mapped_pipeline_cache;
+
+        auto AlignUp = [](size_t v) {
+            return (v + SHADER_CACHE_BLOB_ALIGNMENT - 1) & ~(SHADER_CACHE_BLOB_ALIGNMENT - 1);
+        };
+        ShaderCacheHeader header{
+            .shader_binary_uuid=shader_binary_uuid,
+            .shader_binary_version=shader_binary_version,
+            .num_entries=static_cast<uint32_t>(blobs.size())
+        };
+        std::vector<ShaderCacheEntry> entries{};
+        entries.reserve(blobs.size());
+        size_t offset = AlignUp(sizeof(ShaderCacheHeader) + blobs.size() * sizeof(ShaderCacheEntry));
+        for (const auto& [key, binary] : blobs) {
+            entries.push_back({.key=key, .offset=offset, .size=binary.size()});
+            offset = AlignUp(offset + binary.size());
+        }
+        header.pipeline_cache_offset = offset;
+        header.pipeline_cache_size = pipeline_cache_data.size();
+
+        std::vector<std::byte> out(offset + pipeline_cache_data.size(), std::byte{0});
+        std::memcpy(out.data(), std::addressof(header), sizeof(header));
+        std::memcpy(out.data() + sizeof(header), entries.data(), entries.size() * sizeof(ShaderCacheEntry));
+        for (auto [entry, blob] : std::views::zip(entries, blobs)) {
+            std::ranges::copy(blob.second, out.begin() + static_cast<ptrdiff_t>(entry.offset));
+        }
+        std::ranges::copy(pipeline_cache_data, out.begin() + static_cast<ptrdiff_t>(header.pipeline_cache_offset));
+
+        // Release the mapping first; windows can't replace a mapped file.
+        mapped.clear();
+        mapped_pipeline_cache = {};
+        file.Close();
+        std::filesystem::path tmp_path = path;
+        tmp_path += ".tmp";
+        {
+            std::ofstream stream{tmp_path, std::ios::binary | std::ios::trunc};
+            if (!stream.is_open()) {
+                throw std::runtime_error{std::format("ShaderBinaryCache: failed to open {}\n", tmp_path.string())};
+            }
+            stream.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+            if (!stream) {
+                throw std::runtime_error{std::format("ShaderBinaryCache: failed to write {}\n", tmp_path.string())};
+            }
+        }
+        std::filesystem::rename(tmp_path, path);
+        added.clear();
+        added_pipeline_cache.reset();
+        is_dirty = false;
+        Load();
+    }
+
+    size_t NumEntries() const noexcept { return mapped.size() + added.size(); }
+    size_t NumHits() const noexcept { return num_hits; }
+    size_t NumMisses() const noexcept { return num_misses; }
+
+private:
+    static bool IsLinked(const ShaderGroup::ShaderInfo& info) {
+        return static_cast<bool>(info.flags & vk::ShaderCreateFlagBitsEXT::eLinkStage);
+    }
+
+    // A missing, stale or corrupt file leaves the cache empty; Save replaces it.
+    void Load() {
+        std::error_code ec{};
+        if (!std::filesystem::is_regular_file(path, ec)) { return; }
+        file = jms::MappedFile{path};
+        std::span<const std::byte> bytes = file.Bytes();
+        is_dirty = true;
+        if (bytes.size() < sizeof(ShaderCacheHeader)) { return; }
+        ShaderCacheHeader header{};
+        std::memcpy(std::addressof(header), bytes.data(), sizeof(header));
+        if (header.magic != SHADER_CACHE_MAGIC || header.format_version != SHADER_CACHE_FORMAT_VERSION ||
+            header.shader_binary_uuid != shader_binary_uuid || header.shader_binary_version != shader_binary_version) {
+            return;
+        }
+        auto InRange = [size=bytes.size()](uint64_t offset, uint64_t length) {
+            return offset <= size && length <= size - offset;
+        };
+        uint64_t table_size = static_cast<uint64_t>(header.num_entries) * sizeof(ShaderCacheEntry);
+        if (!InRange(sizeof(ShaderCacheHeader), table_size) ||
+            !InRange(header.pipeline_cache_offset, header.pipeline_cache_size)) { return; }
+
+        std::unordered_map<uint64_t, std::span<const std::byte>> entries{};
+        entries.reserve(header.num_entries);
+        for (uint32_t i = 0; i < header.num_entries; ++i) {
+            ShaderCacheEntry entry{};
+            std::memcpy(std::addressof(entry), bytes.data() + sizeof(header) + i * sizeof(ShaderCacheEntry),
+                        sizeof(entry));
+            if (!InRange(entry.offset, entry.size) || entry.offset % SHADER_CACHE_BLOB_ALIGNMENT) { return; }
+            entries.emplace(entry.key, bytes.subspan(entry.offset, entry.size));
+        }
+        mapped = std::move(entries);
+        mapped_pipeline_cache = bytes.subspan(header.pipeline_cache_offset, header.pipeline_cache_size);
+        is_dirty = false;
+    }
+};
+
+
+}
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "jms/utils/mapped_file.hpp"
+
+
+namespace jms {
+namespace vulkan {
+
+
+constexpr uint32_t SHADER_PACK_MAGIC = 0x50534d4a; // "JMSP"
+constexpr uint32_t SHADER_PACK_FORMAT_VERSION = 1;
+constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+
+/***
+ * File layout: header, entry table, name bytes, then the SPIR-V blobs at 4 byte alignment.  Offsets are from the
+ * file start and sizes in bytes.
+ */
+struct ShaderPackHeader {
+    uint32_t magic{SHADER_PACK_MAGIC};
+    uint32_t format_version{SHADER_PACK_FORMAT_VERSION};
+    uint32_t num_entries{0};
+    uint32_t reserved{0};
+};
+static_assert(sizeof(ShaderPackHeader) == 16);
+
+
+struct ShaderPackEntry {
+    uint64_t name_offset{0};
+    uint64_t name_size{0};
+    uint64_t code_offset{0};
+    uint64_t code_size{0};
+};
+static_assert(sizeof(ShaderPackEntry) == 32);
+
+
+struct ShaderPackSource {
+    std::string name{};
+    std::span<const uint32_t> code{};
+};
+
+
+/***
+ * Many SPIR-V modules in one memory mapped file.  Opening costs one mmap plus a walk of the index; Code returns views
+ * straight into the mapping for ShaderGroup::ShaderInfo::code_view, so nothing is read or copied until the driver
+ * touches the pages.  Views are valid for the lifetime of the pack.
+ */
+class ShaderPack {
+    jms::MappedFile file{};
+    std::unordered_map<std::string_view, std::span<const uint32_t>> shaders{};
+
+public:
+    ShaderPack() noexcept = default;
+    explicit ShaderPack(const std::filesystem::path& path)
+    : file{path}
+    {
+        std::span<const std::byte> bytes = file.Bytes();
+        auto Fail = [&path](std::string_view reason) {
+            return std::runtime_error{std::format("ShaderPack {}: {}\n", path.string(), reason)};
+        };
+        auto InRange = [size=bytes.size()](uint64_t offset, uint64_t length) {
+            return offset <= size && length <= size - offset;
+        };
+        if (bytes.size() < sizeof(ShaderPackHeader)) { throw Fail("too small"); }
+        ShaderPackHeader header{};
+        std::memcpy(std::addressof(header), bytes.data(), sizeof(header));
+        if (header.magic != SHADER_PACK_MAGIC) { throw Fail("not a shader pack"); }
+        if (header.format_version != SHADER_PACK_FORMAT_VERSION) { throw Fail("unsupported version"); }
+        if (!InRange(sizeof(header), static_cast<uint64_t>(header.num_entries) * sizeof(ShaderPackEntry))) {
+            throw Fail("truncated index");
+        }
+
+        shaders.reserve(header.num_entries);
+        for (uint32_t i = 0; i < header.num_entries; ++i) {
+            ShaderPackEntry entry{};
+            std::memcpy(std::addressof(entry), bytes.data() + sizeof(header) + i * sizeof(ShaderPackEntry),
+                        sizeof(entry));
+            if (!InRange(entry.name_offset, entry.name_size) || !InRange(entry.code_offset, entry.code_size)) {
+                throw Fail(std::format("entry {} out of range", i));
+            }
+            if (entry.code_offset % sizeof(uint32_t) || entry.code_size % sizeof(uint32_t) || entry.code_size == 0) {
+                throw Fail(std::format("entry {} is not 4 byte aligned SPIR-V", i));
+            }
+            std::string_view name{reinterpret_cast<const char*>(bytes.data() + entry.name_offset), entry.name_size};
+            std::span<const uint32_t> code{reinterpret_cast<const uint32_t*>(bytes.data() + entry.code_offset),
+                                           entry.code_size / sizeof(uint32_t)};
+            if (code[0] != SPIRV_MAGIC) { throw Fail(std::format("{} is not SPIR-V", name)); }
+            if (!shaders.emplace(name, code).second) { throw Fail(std::format("duplicate shader {}", name)); }
+        }
+    }
+    ShaderPack(const ShaderPack&) = delete;
+    ShaderPack(ShaderPack&&) noexcept = default;
+    ~ShaderPack() noexcept = default;
+    ShaderPack& operator=(const ShaderPack&) = delete;
+    ShaderPack& operator=(ShaderPack&&) noexcept = default;
+
+    std::optional<std::span<const uint32_t>> Find(std::string_view name) const {
+        if (auto it = shaders.find(name); it != shaders.end()) { return it->second; }
+        return std::nullopt;
+    }
+
+    std::span<const uint32_t> Code(std::string_view name) const {
+        if (auto code = Find(name); code) { return code.value(); }
+        throw std::runtime_error{std::format("ShaderPack: no shader named {}\n", name)};
+    }
+
+    size_t NumShaders() const noexcept { return shaders.size(); }
+};
+
+
+// Offline side; e.g. a build step packing every compiled .spv.
+void WriteShaderPack(const std::filesystem::path& path, const std::vector<ShaderPackSource>& sources) {
+    ShaderPackHeader header{.num_entries=static_cast<uint32_t>(sources.size())};
+    std::vector<ShaderPackEntry> entries{};
+    entries.reserve(sources.size());
+    uint64_t offset = sizeof(header) + sources.size() * sizeof(ShaderPackEntry);
+    for (const auto& source : sources) {
+        entries.push_back({.name_offset=offset, .name_size=source.name.size()});
+        offset += source.name.size();
+    }
+    for (size_t i = 0; i < sources.size(); ++i) {
+        offset = (offset + sizeof(uint32_t) - 1) & ~static_cast<uint64_t>(sizeof(uint32_t) - 1);
+        entries[i].code_offset = offset;
+        entries[i].code_size = sources[i].code.size_bytes();
+        offset += entries[i].code_size;
+    }
+
+    std::vector<std::byte> out(offset, std::byte{0});
+    std::memcpy(out.data(), std::addressof(header), sizeof(header));
+    std::memcpy(out.data() + sizeof(header), entries.data(), entries.size() * sizeof(ShaderPackEntry));
+    for (size_t i = 0; i < sources.size(); ++i) {
+        std::memcpy(out.data() + entries[i].name_offset, sources[i].name.data(), sources[i].name.size());
+        std::memcpy(out.data() + entries[i].code_offset, sources[i].code.data(), sources[i].code.size_bytes());
+    }
+
+    std::ofstream stream{path, std::ios::binary | std::ios::trunc};
+    if (!stream.is_open()) { throw std::runtime_error{std::format("Failed to open shader pack {}\n", path.string())}; }
+    stream.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+    if (!stream) { throw std::runtime_error{std::format("Failed to write shader pack {}\n", path.string())}; }
+}
+
+
+}
+}
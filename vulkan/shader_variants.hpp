@@ -0,0 +1,227 @@
+#pragma once
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "jms/utils/executor.hpp"
+#include "jms/utils/hash.hpp"
+#include "jms/vulkan/vulkan.hpp"
+#include "jms/vulkan/shader.hpp"
+#include "jms/vulkan/submission.hpp"
+#include "jms/vulkan/utils.hpp"
+
+
+namespace jms {
+namespace vulkan {
+
+
+/***
+ * Specialization constant values of a variant.  Every constant is 32 bits (bool, int, uint and float in GLSL/HLSL);
+ * floats are given by their bit pattern, e.g. std::bit_cast<uint32_t>(1.0f).  Canonical sorts by constant id so the
+ * order constants are set in doesn't create duplicate variants.
+ */
+struct ShaderVariantKey {
+    std::vector<std::pair<uint32_t, uint32_t>> constants{};
+
+    ShaderVariantKey& Set(uint32_t constant_id, uint32_t value) {
+        auto it = std::ranges::find(constants, constant_id, &std::pair<uint32_t, uint32_t>::first);
+        if (it != constants.end()) {
+            it->second = value;
+        } else {
+            constants.emplace_back(constant_id, value);
+        }
+        return *this;
+    }
+
+    ShaderVariantKey Canonical() const {
+        ShaderVariantKey out{*this};
+        std::ranges::sort(out.constants);
+        return out;
+    }
+
+    // Hash of (shader_index, constants); call on the canonical key.
+    uint64_t Hash(size_t shader_index) const noexcept {
+        jms::Fnv1a64 hash{};
+        hash.Add(static_cast<uint64_t>(shader_index)).Add(static_cast<uint64_t>(constants.size()));
+        for (const auto& [constant_id, value] : constants) { hash.Add(constant_id).Add(value); }
+        return hash.Value();
+    }
+};
+
+
+// The full identity of a variant; the hash only picks the bucket so colliding keys stay distinct variants.
+struct ShaderVariantId {
+    size_t shader_index{0};
+    ShaderVariantKey canonical_key{};
+
+    bool operator==(const ShaderVariantId& other) const noexcept {
+        return shader_index == other.shader_index && canonical_key.constants == other.canonical_key.constants;
+    }
+};
+
+
+struct ShaderVariantIdHash {
+    size_t operator()(const ShaderVariantId& id) const noexcept {
+        return static_cast<size_t>(id.canonical_key.Hash(id.shader_index));
+    }
+};
+
+
+/***
+ * Lazily created specializations of the unlinked shaders of a ShaderGroup.
+ *
+ * Variants are deduplicated by (shader index, canonical constants) and only created on the first Get that
+ * asks for them.  With a thread pool creation happens in the background and Get returns the fallback (e.g. the
+ * unspecialized shader of the pass) until the variant is ready.  Variants unused for a number of frames can be
+ * evicted; their shaders are handed to a DeferredDeletionQueue since command buffers in flight may still use them.
+ *
+ * group, layouts and pool must outlive the manager.
+ */
+template <typename Mutex_t/*=jms::NoMutex*/>
+class ShaderVariantManager {
+    struct Variant {
+        size_t shader_index{0};
+        std::vector<vk::SpecializationMapEntry> map_entries{};
+        std::vector<uint32_t> data{};
+        vk::raii::ShaderEXT shader{nullptr};
+        std::future<vk::raii::ShaderEXT> pending{};
+        uint64_t last_used{0};
+    };
+
+    vk::raii::Device* device{nullptr};
+    const ShaderGroup* group{nullptr};
+    const std::vector<vk::DescriptorSetLayout>* layouts{nullptr};
+    jms::ThreadPool* pool{nullptr};
+    std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks{std::nullopt};
+    std::unordered_map<ShaderVariantId, Variant, ShaderVariantIdHash> variants{};
+    Mutex_t mutex{};
+
+public:
+    ShaderVariantManager(vk::raii::Device& device,
+                         const ShaderGroup& group,
+                         const std::vector<vk::DescriptorSetLayout>& layouts,
+                         jms::ThreadPool* pool = nullptr,
+                         std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt)
+    : device{std::addressof(device)},
+      group{std::addressof(group)},
+      layouts{std::addressof(layouts)},
+      pool{pool},
+      vk_allocation_callbacks{vk_allocation_callbacks}
+    {}
+    ShaderVariantManager(const ShaderVariantManager&) = delete;
+    ShaderVariantManager(ShaderVariantManager&&) = delete;
+    // Background creations reference the variants; wait for them.
+    ~ShaderVariantManager() noexcept {
+        for (auto& [key, variant] : variants) {
+            if (variant.pending.valid()) { variant.pending.wait(); }
+        }
+    }
+    ShaderVariantManager& operator=(const ShaderVariantManager&) = delete;
+    ShaderVariantManager& operator=(ShaderVariantManager&&) = delete;
+
+    static uint64_t Key(size_t shader_index, const ShaderVariantKey& canonical_key) noexcept {
+        return canonical_key.Hash(shader_index);
+    }
+
+    /***
+     * Shader to bind for the variant; frame is any monotonic use counter (e.g. FrameRing::FrameNumber) for eviction.
+     * Returns fallback while a background creation is pending.  Creation errors are rethrown from the Get that sees
+     * them.
+     */
+    vk::ShaderEXT Get(size_t shader_index, const ShaderVariantKey& key, uint64_t frame, vk::ShaderEXT fallback = {}) {
+        ShaderVariantId id{.shader_index=shader_index, .canonical_key=key.Canonical()};
+        std::scoped_lock lock{mutex};
+        auto [it, is_new] = variants.try_emplace(std::move(id));
+        Variant& variant = it->second;
+        variant.last_used = frame;
+        if (is_new) {
+            try {
+                Create(variant, shader_index, it->first.canonical_key);
+            } catch (...) {
+                variants.erase(it);
+                throw;
+            }
+        }
+        if (variant.pending.valid()) {
+            if (variant.pending.wait_for(std::chrono::seconds{0}) != std::future_status::ready) { return fallback; }
+            try {
+                variant.shader = variant.pending.get();
+            } catch (...) {
+                variants.erase(it);
+                throw;
+            }
+        }
+        return *variant.shader;
+    }
+
+    /***
+     * Retires variants not used since frame - max_unused_frames.  retire_value is the timeline value after which no
+     * submitted work can reference them; e.g. SubmissionTracker::LastSubmitted.  Returns the number evicted.
+     */
+    size_t Evict(uint64_t frame, uint64_t max_unused_frames, DeferredDeletionQueue& deletion_queue,
+                 uint64_t retire_value) {
+        std::scoped_lock lock{mutex};
+        size_t count = 0;
+        for (auto it = variants.begin(); it != variants.end();) {
+            Variant& variant = it->second;
+            bool is_stale = variant.last_used + max_unused_frames < frame;
+            if (!is_stale || variant.pending.valid()) {
+                ++it;
+                continue;
+            }
+            deletion_queue.Retire(retire_value, std::move(variant.shader));
+            it = variants.erase(it);
+            ++count;
+        }
+        return count;
+    }
+
+    size_t NumVariants() {
+        std::scoped_lock lock{mutex};
+        return variants.size();
+    }
+
+private:
+    void Create(Variant& variant, size_t shader_index, const ShaderVariantKey& canonical_key) {
+        variant.shader_index = shader_index;
+        variant.map_entries.reserve(canonical_key.constants.size());
+        variant.data.reserve(canonical_key.constants.size());
+        for (const auto& [constant_id, value] : canonical_key.constants) {
+            variant.map_entries.push_back({
+                .constantID=constant_id,
+                .offset=static_cast<uint32_t>(variant.data.size() * sizeof(uint32_t)),
+                .size=sizeof(uint32_t)
+            });
+            variant.data.push_back(value);
+        }
+        // The variant's storage is stable; unordered_map never moves its nodes.
+        auto CreateFn = [this, &variant]() {
+            vk::SpecializationInfo specialization_info{
+                .mapEntryCount=static_cast<uint32_t>(variant.map_entries.size()),
+                .pMapEntries=VectorAsPtr(variant.map_entries),
+                .dataSize=variant.data.size() * sizeof(uint32_t),
+                .pData=VectorAsPtr(variant.data)
+            };
+            return group->CreateSpecializedShader(*device, *layouts, variant.shader_index, specialization_info,
+                                                  vk_allocation_callbacks);
+        };
+        if (pool) {
+            variant.pending = pool->Submit(std::move(CreateFn));
+        } else {
+            variant.shader = CreateFn();
+        }
+    }
+};
+
+
+}
+}
@@ -0,0 +1,518 @@
+#pragma once
+
+
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "jms/vulkan/vulkan.hpp"
+#include "jms/vulkan/shader.hpp"
+
+
+namespace jms {
+namespace vulkan {
+
+
+struct SpirvDescriptorBinding {
+    uint32_t set{0};
+    uint32_t binding{0};
+    vk::DescriptorType type{};
+    // 0 for runtime arrays (e.g. bindless); the real count must be set before creating the layout.
+    uint32_t count{1};
+    vk::ShaderStageFlags stages{};
+};
+
+
+struct SpirvPushConstantBlock {
+    uint32_t offset{0};
+    uint32_t size{0};
+};
+
+
+struct SpirvVertexInput {
+    uint32_t location{0};
+    vk::Format format{vk::Format::eUndefined};
+    uint32_t size{0};
+};
+
+
+struct SpirvReflection {
+    vk::ShaderStageFlagBits stage{};
+    std::string entry_point_name{};
+    std::vector<SpirvDescriptorBinding> bindings{};
+    std::optional<SpirvPushConstantBlock> push_constants{};
+    // Vertex stage only; sorted by location.
+    std::vector<SpirvVertexInput> vertex_inputs{};
+};
+
+
+namespace spirv {
+
+
+constexpr uint32_t MAGIC = 0x07230203;
+constexpr size_t HEADER_WORDS = 5;
+
+enum Op : uint32_t {
+    OP_ENTRY_POINT = 15,
+    OP_TYPE_BOOL = 20,
+    OP_TYPE_INT = 21,
+    OP_TYPE_FLOAT = 22,
+    OP_TYPE_VECTOR = 23,
+    OP_TYPE_MATRIX = 24,
+    OP_TYPE_IMAGE = 25,
+    OP_TYPE_SAMPLER = 26,
+    OP_TYPE_SAMPLED_IMAGE = 27,
+    OP_TYPE_ARRAY = 28,
+    OP_TYPE_RUNTIME_ARRAY = 29,
+    OP_TYPE_STRUCT = 30,
+    OP_TYPE_POINTER = 32,
+    OP_CONSTANT = 43,
+    OP_SPEC_CONSTANT = 50,
+    OP_VARIABLE = 59,
+    OP_DECORATE = 71,
+    OP_MEMBER_DECORATE = 72,
+    OP_TYPE_ACCELERATION_STRUCTURE_KHR = 5341
+};
+
+enum Decoration : uint32_t {
+    DECORATION_BLOCK = 2,
+    DECORATION_BUFFER_BLOCK = 3,
+    DECORATION_ARRAY_STRIDE = 6,
+    DECORATION_MATRIX_STRIDE = 7,
+    DECORATION_BUILT_IN = 11,
+    DECORATION_LOCATION = 30,
+    DECORATION_BINDING = 33,
+    DECORATION_DESCRIPTOR_SET = 34,
+    DECORATION_OFFSET = 35
+};
+
+enum StorageClass : uint32_t {
+    STORAGE_CLASS_UNIFORM_CONSTANT = 0,
+    STORAGE_CLASS_INPUT = 1,
+    STORAGE_CLASS_UNIFORM = 2,
+    STORAGE_CLASS_PUSH_CONSTANT = 9,
+    STORAGE_CLASS_STORAGE_BUFFER = 12
+};
+
+constexpr uint32_t DIM_BUFFER = 5;
+constexpr uint32_t DIM_SUBPASS_DATA = 6;
+
+
+// Only what descriptor, push constant and vertex input reflection needs.
+struct Module {
+    struct Type {
+        uint32_t op{0};
+        std::vector<uint32_t> operands{};
+    };
+
+    struct Decorations {
+        std::optional<uint32_t> set{};
+        std::optional<uint32_t> binding{};
+        std::optional<uint32_t> location{};
+        std::optional<uint32_t> array_stride{};
+        bool is_block{false};
+        bool is_buffer_block{false};
+        bool is_built_in{false};
+        // member index -> (offset, matrix stride)
+        std::map<uint32_t, std::pair<uint32_t, uint32_t>> members{};
+    };
+
+    struct Variable {
+        uint32_t id{0};
+        uint32_t pointer_type{0};
+        uint32_t storage_class{0};
+    };
+
+    uint32_t execution_model{0};
+    std::string entry_point_name{};
+    std::unordered_map<uint32_t, Type> types{};
+    std::unordered_map<uint32_t, uint32_t> constants{};
+    std::unordered_map<uint32_t, Decorations> decorations{};
+    std::vector<Variable> variables{};
+
+    explicit Module(std::span<const uint32_t> code) {
+        if (code.size() < HEADER_WORDS || code[0] != MAGIC) {
+            throw std::runtime_error{"ReflectSpirv: code is not SPIR-V."};
+        }
+        size_t i = HEADER_WORDS;
+        bool has_entry_point = false;
+        while (i < code.size()) {
+            uint32_t word_count = code[i] >> 16;
+            uint32_t op = code[i] & 0xffff;
+            if (word_count == 0 || i + word_count > code.size()) {
+                throw std::runtime_error{std::format("ReflectSpirv: malformed instruction at word {}\n", i)};
+            }
+            std::span<const uint32_t> args = code.subspan(i + 1, word_count - 1);
+            switch (op) {
+            case OP_ENTRY_POINT:
+                // Only the first entry point is reflected; one entry point per ShaderInfo.
+                if (!has_entry_point && args.size() >= 3) {
+                    has_entry_point = true;
+                    execution_model = args[0];
+                    entry_point_name = DecodeString(args.subspan(2));
+                }
+                break;
+            case OP_TYPE_BOOL: case OP_TYPE_INT: case OP_TYPE_FLOAT: case OP_TYPE_VECTOR: case OP_TYPE_MATRIX:
+            case OP_TYPE_IMAGE: case OP_TYPE_SAMPLER: case OP_TYPE_SAMPLED_IMAGE: case OP_TYPE_ARRAY:
+            case OP_TYPE_RUNTIME_ARRAY: case OP_TYPE_STRUCT: case OP_TYPE_POINTER:
+            case OP_TYPE_ACCELERATION_STRUCTURE_KHR:
+                if (!args.empty()) { types[args[0]] = {.op=op, .operands={args.begin() + 1, args.end()}}; }
+                break;
+            case OP_CONSTANT: case OP_SPEC_CONSTANT:
+                // Low word is enough for array lengths.
+                if (args.size() >= 3) { constants[args[1]] = args[2]; }
+                break;
+            case OP_VARIABLE:
+                if (args.size() >= 3) {
+                    variables.push_back({.id=args[1], .pointer_type=args[0], .storage_class=args[2]});
+                }
+                break;
+            case OP_DECORATE:
+                if (args.size() >= 2) { Decorate(decorations[args[0]], args[1], args.subspan(2)); }
+                break;
+            case OP_MEMBER_DECORATE:
+                if (args.size() >= 4) {
+                    auto& member = decorations[args[0]].members[args[1]];
+                    if (args[2] == DECORATION_OFFSET) { member.first = args[3]; }
+                    if (args[2] == DECORATION_MATRIX_STRIDE) { member.second = args[3]; }
+                }
+                break;
+            default:
+                break;
+            }
+            i += word_count;
+        }
+        if (!has_entry_point) { throw std::runtime_error{"ReflectSpirv: no entry point."}; }
+    }
+
+    const Type& GetType(uint32_t id) const {
+        auto it = types.find(id);
+        if (it == types.end()) { throw std::runtime_error{std::format("ReflectSpirv: unknown type id {}\n", id)}; }
+        return it->second;
+    }
+
+    const Decorations& GetDecorations(uint32_t id) const {
+        static const Decorations none{};
+        auto it = decorations.find(id);
+        return it != decorations.end() ? it->second : none;
+    }
+
+    // Size in bytes of an explicitly laid out type (push constant blocks).
+    uint32_t Size(uint32_t type_id, uint32_t matrix_stride = 0) const {
+        const Type& type = GetType(type_id);
+        switch (type.op) {
+        case OP_TYPE_BOOL: return 4;
+        case OP_TYPE_INT: case OP_TYPE_FLOAT: return type.operands.at(0) / 8;
+        case OP_TYPE_VECTOR: return Size(type.operands.at(0)) * type.operands.at(1);
+        case OP_TYPE_MATRIX: {
+            uint32_t column_size = matrix_stride ? matrix_stride : Size(type.operands.at(0));
+            return column_size * type.operands.at(1);
+        }
+        case OP_TYPE_ARRAY: {
+            uint32_t length = constants.at(type.operands.at(1));
+            auto stride = GetDecorations(type_id).array_stride;
+            return (stride ? stride.value() : Size(type.operands.at(0))) * length;
+        }
+        case OP_TYPE_STRUCT: {
+            const Decorations& decorations = GetDecorations(type_id);
+            uint32_t size = 0;
+            for (uint32_t m = 0; m < type.operands.size(); ++m) {
+                auto it = decorations.members.find(m);
+                uint32_t offset = it != decorations.members.end() ? it->second.first : size;
+                uint32_t stride = it != decorations.members.end() ? it->second.second : 0;
+                size = std::max(size, offset + Size(type.operands[m], stride));
+            }
+            return size;
+        }
+        default:
+            throw std::runtime_error{std::format("ReflectSpirv: type {} has no explicit size\n", type_id)};
+        }
+    }
+
+    uint32_t MinMemberOffset(uint32_t struct_type_id) const {
+        const Decorations& decorations = GetDecorations(struct_type_id);
+        uint32_t offset = std::numeric_limits<uint32_t>::max();
+        for (const auto& [member, layout] : decorations.members) { offset = std::min(offset, layout.first); }
+        return offset == std::numeric_limits<uint32_t>::max() ? 0 : offset;
+    }
+
+private:
+    static std::string DecodeString(std::span<const uint32_t> words) {
+        std::string out{};
+        for (uint32_t word : words) {
+            for (int b = 0; b < 4; ++b) {
+                char c = static_cast<char>((word >> (8 * b)) & 0xff);
+                if (c == '\0') { return out; }
+                out.push_back(c);
+            }
+        }
+        return out;
+    }
+
+    static void Decorate(Decorations& d, uint32_t decoration, std::span<const uint32_t> values) {
+        auto Value = [&values]() { return values.empty() ? 0 : values[0]; };
+        switch (decoration) {
+        case DECORATION_BLOCK: d.is_block = true; break;
+        case DECORATION_BUFFER_BLOCK: d.is_buffer_block = true; break;
+        case DECORATION_ARRAY_STRIDE: d.array_stride = Value(); break;
+        case DECORATION_BUILT_IN: d.is_built_in = true; break;
+        case DECORATION_LOCATION: d.location = Value(); break;
+        case DECORATION_BINDING: d.binding = Value(); break;
+        case DECORATION_DESCRIPTOR_SET: d.set = Value(); break;
+        default: break;
+        }
+    }
+};
+
+
+vk::ShaderStageFlagBits StageOf(uint32_t execution_model) {
+    switch (execution_model) {
+    case 0: return vk::ShaderStageFlagBits::eVertex;
+    case 1: return vk::ShaderStageFlagBits::eTessellationControl;
+    case 2: return vk::ShaderStageFlagBits::eTessellationEvaluation;
+    case 3: return vk::ShaderStageFlagBits::eGeometry;
+    case 4: return vk::ShaderStageFlagBits::eFragment;
+    case 5: return vk::ShaderStageFlagBits::eCompute;
+    case 5267: return vk::ShaderStageFlagBits::eTaskEXT;
+    case 5268: return vk::ShaderStageFlagBits::eMeshEXT;
+    default:
+        throw std::runtime_error{std::format("ReflectSpirv: unsupported execution model {}\n", execution_model)};
+    }
+}
+
+
+// 16, 32 and 64 bit scalars and vectors; anything else is eUndefined.
+std::pair<vk::Format, uint32_t> VertexFormatOf(const Module& module, uint32_t type_id) {
+    const Module::Type& type = module.GetType(type_id);
+    uint32_t components = 1;
+    const Module::Type* scalar = std::addressof(type);
+    if (type.op == OP_TYPE_VECTOR) {
+        components = type.operands.at(1);
+        scalar = std::addressof(module.GetType(type.operands.at(0)));
+    }
+    if (scalar->op != OP_TYPE_FLOAT && scalar->op != OP_TYPE_INT) { return {vk::Format::eUndefined, 0}; }
+    uint32_t width = scalar->operands.at(0);
+    bool is_float = scalar->op == OP_TYPE_FLOAT;
+    bool is_signed = !is_float && scalar->operands.at(1) != 0;
+    static constexpr vk::Format F32[] = {vk::Format::eR32Sfloat, vk::Format::eR32G32Sfloat,
+                                         vk::Format::eR32G32B32Sfloat, vk::Format::eR32G32B32A32Sfloat};
+    static constexpr vk::Format S32[] = {vk::Format::eR32Sint, vk::Format::eR32G32Sint,
+                                         vk::Format::eR32G32B32Sint, vk::Format::eR32G32B32A32Sint};
+    static constexpr vk::Format U32[] = {vk::Format::eR32Uint, vk::Format::eR32G32Uint,
+                                         vk::Format::eR32G32B32Uint, vk::Format::eR32G32B32A32Uint};
+    static constexpr vk::Format F16[] = {vk::Format::eR16Sfloat, vk::Format::eR16G16Sfloat,
+                                         vk::Format::eR16G16B16Sfloat, vk::Format::eR16G16B16A16Sfloat};
+    static constexpr vk::Format S16[] = {vk::Format::eR16Sint, vk::Format::eR16G16Sint,
+                                         vk::Format::eR16G16B16Sint, vk::Format::eR16G16B16A16Sint};
+    static constexpr vk::Format U16[] = {vk::Format::eR16Uint, vk::Format::eR16G16Uint,
+                                         vk::Format::eR16G16B16Uint, vk::Format::eR16G16B16A16Uint};
+    static constexpr vk::Format F64[] = {vk::Format::eR64Sfloat, vk::Format::eR64G64Sfloat,
+                                         vk::Format::eR64G64B64Sfloat, vk::Format::eR64G64B64A64Sfloat};
+    if (components < 1 || components > 4) { return {vk::Format::eUndefined, 0}; }
+    uint32_t size = (width / 8) * components;
+    size_t c = components - 1;
+    if (width == 32) { return {is_float ? F32[c] : (is_signed ? S32[c] : U32[c]), size}; }
+    if (width == 16) { return {is_float ? F16[c] : (is_signed ? S16[c] : U16[c]), size}; }
+    if (width == 64 && is_float) { return {F64[c], size}; }
+    return {vk::Format::eUndefined, 0};
+}
+
+
+} // namespace spirv
+
+
+/***
+ * Minimal SPIR-V reflection of the first entry point: descriptor bindings, the push constant block and vertex inputs.
+ * Every global variable is reflected, used or not, which matches what the layout must declare for the module.
+ */
+SpirvReflection ReflectSpirv(std::span<const uint32_t> code) {
+    using namespace spirv;
+    Module module{code};
+    SpirvReflection out{.stage=StageOf(module.execution_model), .entry_point_name=module.entry_point_name};
+
+    for (const Module::Variable& variable : module.variables) {
+        const Module::Type& pointer = module.GetType(variable.pointer_type);
+        uint32_t type_id = pointer.operands.at(1);
+        const Module::Decorations& decorations = module.GetDecorations(variable.id);
+
+        if (variable.storage_class == STORAGE_CLASS_PUSH_CONSTANT) {
+            uint32_t offset = module.MinMemberOffset(type_id);
+            out.push_constants = SpirvPushConstantBlock{.offset=offset, .size=module.Size(type_id) - offset};
+            continue;
+        }
+
+        if (variable.storage_class == STORAGE_CLASS_INPUT) {
+            if (out.stage != vk::ShaderStageFlagBits::eVertex || decorations.is_built_in || !decorations.location) {
+                continue;
+            }
+            auto [format, size] = VertexFormatOf(module, type_id);
+            if (format == vk::Format::eUndefined) {
+                throw std::runtime_error{std::format("ReflectSpirv: unsupported vertex input at location {}\n",
+                                                     decorations.location.value())};
+            }
+            out.vertex_inputs.push_back({.location=decorations.location.value(), .format=format, .size=size});
+            continue;
+        }
+
+        bool is_resource = variable.storage_class == STORAGE_CLASS_UNIFORM_CONSTANT ||
+                           variable.storage_class == STORAGE_CLASS_UNIFORM ||
+                           variable.storage_class == STORAGE_CLASS_STORAGE_BUFFER;
+        if (!is_resource || !decorations.binding) { continue; }
+
+        uint32_t count = 1;
+        const Module::Type* type = std::addressof(module.GetType(type_id));
+        if (type->op == OP_TYPE_ARRAY) {
+            count = module.constants.at(type->operands.at(1));
+            type_id = type->operands.at(0);
+            type = std::addressof(module.GetType(type_id));
+        } else if (type->op == OP_TYPE_RUNTIME_ARRAY) {
+            count = 0;
+            type_id = type->operands.at(0);
+            type = std::addressof(module.GetType(type_id));
+        }
+
+        vk::DescriptorType descriptor_type{};
+        if (variable.storage_class == STORAGE_CLASS_STORAGE_BUFFER) {
+            descriptor_type = vk::DescriptorType::eStorageBuffer;
+        } else if (variable.storage_class == STORAGE_CLASS_UNIFORM) {
+            descriptor_type = module.GetDecorations(type_id).is_buffer_block ? vk::DescriptorType::eStorageBuffer :
+                                                                               vk::DescriptorType::eUniformBuffer;
+        } else if (type->op == OP_TYPE_SAMPLER) {
+            descriptor_type = vk::DescriptorType::eSampler;
+        } else if (type->op == OP_TYPE_SAMPLED_IMAGE) {
+            const Module::Type& image = module.GetType(type->operands.at(0));
+            descriptor_type = image.operands.at(1) == DIM_BUFFER ? vk::DescriptorType::eUniformTexelBuffer :
+                                                                   vk::DescriptorType::eCombinedImageSampler;
+        } else if (type->op == OP_TYPE_IMAGE) {
+            // operands: sampled type, dim, depth, arrayed, ms, sampled (1 sampled, 2 storage), format
+            uint32_t dim = type->operands.at(1);
+            bool is_storage = type->operands.at(5) == 2;
+            if (dim == DIM_SUBPASS_DATA) {
+                descriptor_type = vk::DescriptorType::eInputAttachment;
+            } else if (dim == DIM_BUFFER) {
+                descriptor_type = is_storage ? vk::DescriptorType::eStorageTexelBuffer :
+                                               vk::DescriptorType::eUniformTexelBuffer;
+            } else {
+                descriptor_type = is_storage ? vk::DescriptorType::eStorageImage : vk::DescriptorType::eSampledImage;
+            }
+        } else if (type->op == OP_TYPE_ACCELERATION_STRUCTURE_KHR) {
+            descriptor_type = vk::DescriptorType::eAccelerationStructureKHR;
+        } else {
+            continue;
+        }
+        out.bindings.push_back({
+            .set=decorations.set.value_or(0),
+            .binding=decorations.binding.value(),
+            .type=descriptor_type,
+            .count=count,
+            .stages=out.stage
+        });
+    }
+    std::ranges::sort(out.vertex_inputs, {}, &SpirvVertexInput::location);
+    return out;
+}
+
+
+/***
+ * Fills set_layout_bindings, push_constant_ranges, vertex descriptions and each shader's set and push constant
+ * indices from the SPIR-V of every shader_info.
+ *
+ * - Bindings are merged across stages by (set, binding); the type must agree, the count is the max and stages are
+ *   combined.  Every shader gets every set so all shaders share one pipeline layout.
+ * - Push constant blocks merge into a single range covering all stages that declare one.
+ * - Vertex inputs become one interleaved binding 0 in location order; set the descriptions by hand for anything else.
+ */
+void ReflectShaderGroup(ShaderGroup& group) {
+    std::vector<SpirvReflection> reflections{};
+    reflections.reserve(group.shader_infos.size());
+    for (const auto& info : group.shader_infos) { reflections.push_back(ReflectSpirv(info.Code())); }
+
+    std::map<std::pair<uint32_t, uint32_t>, vk::DescriptorSetLayoutBinding> merged{};
+    std::optional<vk::PushConstantRange> push_range{};
+    for (const auto& reflection : reflections) {
+        for (const auto& b : reflection.bindings) {
+            auto [it, is_new] = merged.try_emplace(std::pair{b.set, b.binding}, vk::DescriptorSetLayoutBinding{
+                .binding=b.binding,
+                .descriptorType=b.type,
+                .descriptorCount=b.count,
+                .stageFlags=b.stages
+            });
+            if (is_new) { continue; }
+            if (it->second.descriptorType != b.type) {
+                throw std::runtime_error{std::format("ReflectShaderGroup: set {} binding {} has conflicting types\n",
+                                                     b.set, b.binding)};
+            }
+            it->second.descriptorCount = std::max(it->second.descriptorCount, b.count);
+            it->second.stageFlags |= b.stages;
+        }
+        if (reflection.push_constants) {
+            const auto& block = reflection.push_constants.value();
+            if (!push_range) {
+                push_range = vk::PushConstantRange{
+                    .stageFlags=reflection.stage,
+                    .offset=block.offset,
+                    .size=block.size
+                };
+            } else {
+                uint32_t begin = std::min(push_range->offset, block.offset);
+                uint32_t end = std::max(push_range->offset + push_range->size, block.offset + block.size);
+                push_range->stageFlags |= reflection.stage;
+                push_range->offset = begin;
+                push_range->size = end - begin;
+            }
+        }
+    }
+
+    size_t num_sets = merged.empty() ? 0 : static_cast<size_t>(merged.rbegin()->first.first) + 1;
+    group.set_layout_bindings.assign(num_sets, {});
+    for (const auto& [key, binding] : merged) { group.set_layout_bindings[key.first].push_back(binding); }
+    group.push_constant_ranges.clear();
+    if (push_range) { group.push_constant_ranges.push_back(push_range.value()); }
+
+    group.vertex_attribute_desc.clear();
+    group.vertex_binding_desc.clear();
+    for (const auto& reflection : reflections) {
+        if (reflection.stage != vk::ShaderStageFlagBits::eVertex || reflection.vertex_inputs.empty()) { continue; }
+        uint32_t offset = 0;
+        for (const auto& input : reflection.vertex_inputs) {
+            group.vertex_attribute_desc.push_back({
+                .location=input.location,
+                .binding=0,
+                .format=input.format,
+                .offset=offset
+            });
+            offset += input.size;
+        }
+        group.vertex_binding_desc.push_back({
+            .binding=0,
+            .stride=offset,
+            .inputRate=vk::VertexInputRate::eVertex,
+            .divisor=1
+        });
+        break;
+    }
+
+    for (auto [info, reflection] : std::views::zip(group.shader_infos, reflections)) {
+        info.set_info_indices.resize(num_sets);
+        std::iota(info.set_info_indices.begin(), info.set_info_indices.end(), static_cast<size_t>(0));
+        info.push_constant_ranges_indices.clear();
+        if (push_range) { info.push_constant_ranges_indices.push_back(0); }
+        if (info.entry_point_name.empty()) { info.entry_point_name = reflection.entry_point_name; }
+    }
+}
+
+
+}
+}
@@ -8,8 +8,10 @@
 #include <optional>
 #include <ranges>
 #include <set>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -18,6 +20,7 @@
 #include "jms/vulkan/debug/default.hpp"
 #include "jms/vulkan/info.hpp"
 #include "jms/vulkan/memory.hpp"
+#include "jms/vulkan/queues.hpp"
 #include "jms/vulkan/shader.hpp"
 #include "jms/vulkan/types.hpp"
 #include "jms/vulkan/variants.hpp"
@@ -45,6 +48,9 @@ struct alignas(16) DeviceConfig {
     vk::PhysicalDeviceFeatures features{};
     uint32_t queue_family_index{};
     std::vector<float> queue_priority{};
+    // Dedicated families; see SelectQueueFamilies.  One queue is created for each distinct family.
+    std::optional<uint32_t> compute_queue_family_index{};
+    std::optional<uint32_t> transfer_queue_family_index{};
     std::vector<vk::DeviceQueueCreateInfo> queue_infos{};
     std::vector<DeviceCreateInfo2Variant> pnext_features{};
 };
@@ -61,6 +67,7 @@ struct State {
     std::vector<vk::raii::Device> devices{};
     std::vector<vk::raii::Queue> graphics_queue{};
     std::vector<vk::raii::Queue> present_queue{};
+    std::vector<QueueRegistry> queues{};
     std::vector<vk::raii::CommandPool> command_pools{};
     std::vector<std::vector<vk::raii::CommandBuffer>> command_buffers{};
     std::vector<vk::raii::Semaphore> semaphores{};
@@ -87,6 +94,11 @@ struct State {
                        const jms::vulkan::RenderInfo& render_info,
                        //std::optional<vk::RenderPass> render_pass = std::nullopt,
                        std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt);
+    void RecreateSwapchain(vk::raii::Device& device,
+                           vk::raii::Queue& present_queue,
+                           vk::raii::SurfaceKHR& surface,
+                           const jms::vulkan::RenderInfo& render_info,
+                           std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt);
 };
 
 
@@ -112,14 +124,37 @@ vk::raii::Device& State::InitDevice(vk::raii::PhysicalDevice& physical_device,
         pnext = static_cast<const void*>(&features2);
     }
 
+    // Graphics + presentation queues share a family; a second queue is only used when the family has one (lavapipe
+    // exposes a single family with a single queue).
+    std::vector<vk::QueueFamilyProperties> family_props = physical_device.getQueueFamilyProperties();
+    uint32_t graphics_family = device_config.queue_family_index;
+    if (graphics_family >= family_props.size()) {
+        throw std::runtime_error{std::format("InitDevice: invalid queue family index {}\n", graphics_family)};
+    }
+    if (device_config.queue_priority.empty()) { device_config.queue_priority.push_back(1.0f); }
+    if (device_config.queue_priority.size() > family_props[graphics_family].queueCount) {
+        device_config.queue_priority.resize(family_props[graphics_family].queueCount);
+    }
     device_config.queue_infos = std::vector<vk::DeviceQueueCreateInfo>{
-        // graphics queue + presentation queue
         {
-            .queueFamilyIndex=device_config.queue_family_index,
+            .queueFamilyIndex=graphics_family,
             .queueCount=static_cast<uint32_t>(device_config.queue_priority.size()),
             .pQueuePriorities=device_config.queue_priority.data()
         }
     };
+    static constexpr float DEDICATED_QUEUE_PRIORITY = 1.0f;
+    auto AddDedicated = [&device_config](std::optional<uint32_t> family) {
+        if (!family) { return; }
+        if (std::ranges::find(device_config.queue_infos, family.value(), &vk::DeviceQueueCreateInfo::queueFamilyIndex)
+            != device_config.queue_infos.end()) { return; }
+        device_config.queue_infos.push_back({
+            .queueFamilyIndex=family.value(),
+            .queueCount=1,
+            .pQueuePriorities=std::addressof(DEDICATED_QUEUE_PRIORITY)
+        });
+    };
+    AddDedicated(device_config.compute_queue_family_index);
+    AddDedicated(device_config.transfer_queue_family_index);
 
     vk::raii::Device& device = devices.emplace_back(physical_device, vk::DeviceCreateInfo{
         .pNext=pnext,
@@ -132,12 +167,26 @@ vk::raii::Device& State::InitDevice(vk::raii::PhysicalDevice& physical_device,
         .pEnabledFeatures=features
     }, vk_allocation_callbacks.value_or(nullptr));
 
-    graphics_queue.emplace_back(device, 0, 0);
-    present_queue.emplace_back(device, 0, 1);
+    uint32_t present_index = std::min(static_cast<uint32_t>(device_config.queue_priority.size()) - 1, 1u);
+    graphics_queue.emplace_back(device, graphics_family, 0);
+    present_queue.emplace_back(device, graphics_family, present_index);
+
+    // A family equal to graphics is not dedicated; the registry falls back to the graphics queue.
+    QueueRegistry& registry = queues.emplace_back();
+    registry.Add(QueueRole::GRAPHICS, device, graphics_family, 0);
+    registry.Add(QueueRole::PRESENT, device, graphics_family, present_index);
+    auto compute_family = device_config.compute_queue_family_index;
+    auto transfer_family = device_config.transfer_queue_family_index;
+    if (compute_family && compute_family.value() != graphics_family) {
+        registry.Add(QueueRole::COMPUTE, device, compute_family.value(), 0);
+    }
+    if (transfer_family && transfer_family.value() != graphics_family && transfer_family != compute_family) {
+        registry.Add(QueueRole::TRANSFER, device, transfer_family.value(), 0);
+    }
 
     command_pools.push_back(device.createCommandPool({
         .flags=vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
-        .queueFamilyIndex=cfg.queue_family_index
+        .queueFamilyIndex=graphics_family
     }, vk_allocation_callbacks.value_or(nullptr)));
 
     return device;
@@ -218,6 +267,10 @@ void State::InitSwapchain(vk::raii::Device& device,
                           const jms::vulkan::RenderInfo& render_info,
                           //std::optional<vk::RenderPass> render_pass,
                           std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks) {
+    // Views of the old images go before the old swapchain that owns the images.  The old swapchain is still passed
+    // as oldSwapchain so the driver can reuse its resources, then destroyed on return once the new one exists.
+    swapchain_image_views.clear();
+    vk::raii::SwapchainKHR old_swapchain = std::move(swapchain);
     swapchain = device.createSwapchainKHR({
         .flags=vk::SwapchainCreateFlagsKHR(),
         .surface=*surface,
@@ -234,7 +287,7 @@ void State::InitSwapchain(vk::raii::Device& device,
         .compositeAlpha=vk::CompositeAlphaFlagBitsKHR::eOpaque,
         .presentMode=render_info.present_mode,
         .clipped=VK_TRUE,
-        .oldSwapchain=VK_NULL_HANDLE
+        .oldSwapchain=*old_swapchain
     }, vk_allocation_callbacks.value_or(nullptr));
 
     ImageViewInfo iv_info{.format=render_info.format};
@@ -262,6 +315,20 @@ void State::InitSwapchain(vk::raii::Device& device,
 #endif
 }
 
+/***
+ * Replaces the swapchain and its image views; the old ones are destroyed before this returns.  The caller must first
+ * wait for every submission that uses the old image views, e.g. FrameRing::WaitIdle.  Frame fences don't cover
+ * presents, so present_queue is waited idle here before the old swapchain and its images go away.
+ */
+void State::RecreateSwapchain(vk::raii::Device& device,
+                              vk::raii::Queue& present_queue,
+                              vk::raii::SurfaceKHR& surface,
+                              const jms::vulkan::RenderInfo& render_info,
+                              std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks) {
+    present_queue.waitIdle();
+    InitSwapchain(device, surface, render_info, vk_allocation_callbacks);
+}
+
 
 }
 }
@@ -0,0 +1,302 @@
+#pragma once
+
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+#include "jms/external/glm.hpp"
+
+
+namespace jms {
+namespace vulkan {
+
+
+/***
+ * std140 and std430 offsets computed at compile time for a declared field list (see the alignment note in
+ * scratch/memory_copy.hpp).  std140 is the uniform block layout: arrays, matrix columns and structs round their
+ * alignment up to 16.  std430 is the storage block (and scalar free push constant) layout using base alignments.
+ *
+ * Fields are scalars (float, int32_t, uint32_t, double), glm vectors and column major matrices of those, and
+ * std::arrays of any field type.  Nothing needs a device; everything but Pack and Unpack is constexpr.
+ *
+ *     using CameraLayout = StructLayout<BufferLayout::STD140, &Camera::view, &Camera::position>;
+ *     static_assert(CameraLayout::IsCppLayout({offsetof(Camera, view), offsetof(Camera, position)}));
+ *     CameraLayout::Pack(cameras, mapped_bytes);
+ */
+enum class BufferLayout {
+    STD140,
+    STD430
+};
+
+
+template <typename T>
+concept StdLayoutScalar_c = std::same_as<T, float> || std::same_as<T, int32_t> || std::same_as<T, uint32_t> ||
+                            std::same_as<T, double>;
+
+
+namespace detail {
+constexpr size_t RoundUp(size_t value, size_t alignment) noexcept {
+    return ((value + alignment - 1) / alignment) * alignment;
+}
+}
+
+
+/***
+ * alignment: base alignment of the field in the layout.
+ * size: bytes the field covers; the next field starts at or after offset + size.
+ * is_dense: the C++ object has exactly the layout's bytes, so the field copies with one memcpy.
+ */
+template <BufferLayout LAYOUT, typename T>
+struct LayoutOf;
+
+
+// Rule 4 and the std140 rounding: array elements and matrix columns are strided by their alignment.
+template <BufferLayout LAYOUT, typename Element_t>
+struct ArrayLayoutOf {
+    static constexpr size_t alignment = (LAYOUT == BufferLayout::STD140) ?
+                                        detail::RoundUp(LayoutOf<LAYOUT, Element_t>::alignment, 16) :
+                                        LayoutOf<LAYOUT, Element_t>::alignment;
+    static constexpr size_t stride = detail::RoundUp(LayoutOf<LAYOUT, Element_t>::size, alignment);
+    static constexpr bool is_dense = LayoutOf<LAYOUT, Element_t>::is_dense && stride == sizeof(Element_t);
+};
+
+
+template <BufferLayout LAYOUT, StdLayoutScalar_c T>
+struct LayoutOf<LAYOUT, T> {
+    static constexpr size_t alignment = sizeof(T);
+    static constexpr size_t size = sizeof(T);
+    static constexpr bool is_dense = true;
+
+    static void Write(std::byte* dst, const T& value) noexcept { std::memcpy(dst, std::addressof(value), size); }
+    static void Read(const std::byte* src, T& value) noexcept { std::memcpy(std::addressof(value), src, size); }
+};
+
+
+template <BufferLayout LAYOUT, glm::length_t N, StdLayoutScalar_c T, glm::qualifier Q>
+struct LayoutOf<LAYOUT, glm::vec<N, T, Q>> {
+    // vec3 aligns as vec4 but only covers 12 bytes; a following scalar fills the gap.
+    static constexpr size_t alignment = ((N == 3) ? 4 : N) * sizeof(T);
+    static constexpr size_t size = N * sizeof(T);
+    static constexpr bool is_dense = sizeof(glm::vec<N, T, Q>) == size;
+
+    static void Write(std::byte* dst, const glm::vec<N, T, Q>& value) noexcept {
+        std::memcpy(dst, std::addressof(value), size);
+    }
+    static void Read(const std::byte* src, glm::vec<N, T, Q>& value) noexcept {
+        std::memcpy(std::addressof(value), src, size);
+    }
+};
+
+
+template <BufferLayout LAYOUT, typename T, size_t N>
+struct LayoutOf<LAYOUT, std::array<T, N>> {
+    using Element_t = ArrayLayoutOf<LAYOUT, T>;
+    static constexpr size_t alignment = Element_t::alignment;
+    static constexpr size_t stride = Element_t::stride;
+    static constexpr size_t size = N * stride;
+    static constexpr bool is_dense = Element_t::is_dense && sizeof(std::array<T, N>) == size;
+
+    static void Write(std::byte* dst, const std::array<T, N>& value) noexcept {
+        if constexpr (is_dense) {
+            std::memcpy(dst, value.data(), size);
+        } else {
+            for (size_t i = 0; i < N; ++i) { LayoutOf<LAYOUT, T>::Write(dst + i * stride, value[i]); }
+        }
+    }
+    static void Read(const std::byte* src, std::array<T, N>& value) noexcept {
+        if constexpr (is_dense) {
+            std::memcpy(value.data(), src, size);
+        } else {
+            for (size_t i = 0; i < N; ++i) { LayoutOf<LAYOUT, T>::Read(src + i * stride, value[i]); }
+        }
+    }
+};
+
+
+// Column major matrices are laid out as an array of C column vectors; e.g. a mat3 is three 16 byte strided columns.
+template <BufferLayout LAYOUT, glm::length_t C, glm::length_t R, StdLayoutScalar_c T, glm::qualifier Q>
+struct LayoutOf<LAYOUT, glm::mat<C, R, T, Q>> {
+    using Column_t = ArrayLayoutOf<LAYOUT, glm::vec<R, T, Q>>;
+    static constexpr size_t alignment = Column_t::alignment;
+    static constexpr size_t stride = Column_t::stride;
+    static constexpr size_t size = C * stride;
+    static constexpr bool is_dense = Column_t::is_dense && sizeof(glm::mat<C, R, T, Q>) == size;
+
+    static void Write(std::byte* dst, const glm::mat<C, R, T, Q>& value) noexcept {
+        if constexpr (is_dense) {
+            std::memcpy(dst, std::addressof(value), size);
+        } else {
+            for (glm::length_t c = 0; c < C; ++c) {
+                LayoutOf<LAYOUT, glm::vec<R, T, Q>>::Write(dst + c * stride, value[c]);
+            }
+        }
+    }
+    static void Read(const std::byte* src, glm::mat<C, R, T, Q>& value) noexcept {
+        if constexpr (is_dense) {
+            std::memcpy(std::addressof(value), src, size);
+        } else {
+            for (glm::length_t c = 0; c < C; ++c) {
+                LayoutOf<LAYOUT, glm::vec<R, T, Q>>::Read(src + c * stride, value[c]);
+            }
+        }
+    }
+};
+
+
+/***
+ * Offsets of a struct or block with the given fields in declaration order.
+ * size: end of the last field; the minimum range of a block holding one.
+ * stride: size rounded up to the struct alignment; the array stride and the offset of whatever follows it.
+ */
+template <BufferLayout LAYOUT, typename... Fields_t>
+struct BlockLayout {
+    static constexpr size_t NUM_FIELDS = sizeof...(Fields_t);
+    static_assert(NUM_FIELDS > 0, "BlockLayout requires at least one field.");
+
+    static constexpr size_t alignment = (LAYOUT == BufferLayout::STD140) ?
+                                        detail::RoundUp(std::max({LayoutOf<LAYOUT, Fields_t>::alignment...}), 16) :
+                                        std::max({LayoutOf<LAYOUT, Fields_t>::alignment...});
+    static constexpr std::array<size_t, NUM_FIELDS> alignments{LayoutOf<LAYOUT, Fields_t>::alignment...};
+    static constexpr std::array<size_t, NUM_FIELDS> sizes{LayoutOf<LAYOUT, Fields_t>::size...};
+    static constexpr std::array<size_t, NUM_FIELDS> offsets = [] {
+        std::array<size_t, NUM_FIELDS> out{};
+        size_t offset = 0;
+        for (size_t i = 0; i < NUM_FIELDS; ++i) {
+            out[i] = detail::RoundUp(offset, alignments[i]);
+            offset = out[i] + sizes[i];
+        }
+        return out;
+    }();
+    static constexpr size_t size = offsets.back() + sizes.back();
+    static constexpr size_t stride = detail::RoundUp(size, alignment);
+    static constexpr bool are_fields_dense = (LayoutOf<LAYOUT, Fields_t>::is_dense && ...);
+};
+
+
+template <typename T>
+struct MemberPointerTraits;
+
+
+template <typename Class_t_, typename Member_t_>
+struct MemberPointerTraits<Member_t_ Class_t_::*> {
+    using Class_t = Class_t_;
+    using Member_t = Member_t_;
+};
+
+
+/***
+ * BlockLayout of a C++ struct from pointers to its members in declaration order, plus packing into and out of mapped
+ * memory.  Members left out are not copied.
+ *
+ * When the struct already has the layout's bytes (checked at compile time with IsCppLayout, and by Pack and Unpack
+ * against the actual member offsets) arrays copy with one memcpy, or one per element when the buffer stride differs;
+ * otherwise each field is written to its offset.
+ */
+template <BufferLayout LAYOUT, auto FIRST_MEMBER, auto... MEMBERS>
+struct StructLayout : BlockLayout<LAYOUT,
+                                  typename MemberPointerTraits<decltype(FIRST_MEMBER)>::Member_t,
+                                  typename MemberPointerTraits<decltype(MEMBERS)>::Member_t...> {
+    using Struct_t = typename MemberPointerTraits<decltype(FIRST_MEMBER)>::Class_t;
+    using Block_t = BlockLayout<LAYOUT,
+                                typename MemberPointerTraits<decltype(FIRST_MEMBER)>::Member_t,
+                                typename MemberPointerTraits<decltype(MEMBERS)>::Member_t...>;
+    static_assert((std::same_as<Struct_t, typename MemberPointerTraits<decltype(MEMBERS)>::Class_t> && ...),
+                  "StructLayout members must belong to one struct.");
+
+    static constexpr bool is_copyable = std::is_trivially_copyable_v<Struct_t> && Block_t::are_fields_dense &&
+                                        sizeof(Struct_t) == Block_t::stride;
+
+    // cpp_offsets are offsetof of each member; true when a Struct_t array is byte for byte the layout's array.
+    static constexpr bool IsCppLayout(const std::array<size_t, Block_t::NUM_FIELDS>& cpp_offsets) noexcept {
+        return is_copyable && cpp_offsets == Block_t::offsets;
+    }
+
+    static void Pack(std::span<const Struct_t> in, std::span<std::byte> out, size_t out_stride = Block_t::stride) {
+        CheckRange("Pack", in.size(), out.size(), out_stride);
+        if (in.empty()) { return; }
+        if constexpr (is_copyable) {
+            if (HasCppOffsets(in.front())) {
+                // The last element's tail padding may lie past the end of out.
+                if (out_stride == sizeof(Struct_t)) {
+                    std::memcpy(out.data(), in.data(), (in.size() - 1) * out_stride + Block_t::size);
+                } else {
+                    for (size_t i = 0; i < in.size(); ++i) {
+                        std::memcpy(out.data() + i * out_stride, std::addressof(in[i]), Block_t::size);
+                    }
+                }
+                return;
+            }
+        }
+        for (size_t i = 0; i < in.size(); ++i) { PackOne(in[i], out.data() + i * out_stride); }
+    }
+
+    static void Unpack(std::span<const std::byte> in, std::span<Struct_t> out, size_t in_stride = Block_t::stride) {
+        CheckRange("Unpack", out.size(), in.size(), in_stride);
+        if (out.empty()) { return; }
+        if constexpr (is_copyable) {
+            if (HasCppOffsets(out.front())) {
+                if (in_stride == sizeof(Struct_t)) {
+                    std::memcpy(out.data(), in.data(), (out.size() - 1) * in_stride + Block_t::size);
+                } else {
+                    for (size_t i = 0; i < out.size(); ++i) {
+                        std::memcpy(std::addressof(out[i]), in.data() + i * in_stride, Block_t::size);
+                    }
+                }
+                return;
+            }
+        }
+        for (size_t i = 0; i < out.size(); ++i) { UnpackOne(in.data() + i * in_stride, out[i]); }
+    }
+
+private:
+    // Offsets are constants; the compiler folds this to the compile time answer.
+    static bool HasCppOffsets(const Struct_t& value) noexcept {
+        const auto* base = reinterpret_cast<const std::byte*>(std::addressof(value));
+        const auto offset = [&](auto member) {
+            return static_cast<size_t>(reinterpret_cast<const std::byte*>(std::addressof(value.*member)) - base);
+        };
+        return IsCppLayout({offset(FIRST_MEMBER), offset(MEMBERS)...});
+    }
+
+    static void PackOne(const Struct_t& value, std::byte* dst) noexcept {
+        size_t i = 0;
+        const auto write = [&]<typename Member_t>(const Member_t& member) {
+            LayoutOf<LAYOUT, Member_t>::Write(dst + Block_t::offsets[i++], member);
+        };
+        write(value.*FIRST_MEMBER);
+        (write(value.*MEMBERS), ...);
+    }
+
+    static void UnpackOne(const std::byte* src, Struct_t& value) noexcept {
+        size_t i = 0;
+        const auto read = [&]<typename Member_t>(Member_t& member) {
+            LayoutOf<LAYOUT, Member_t>::Read(src + Block_t::offsets[i++], member);
+        };
+        read(value.*FIRST_MEMBER);
+        (read(value.*MEMBERS), ...);
+    }
+
+    static void CheckRange(const char* name, size_t count, size_t num_bytes, size_t stride) {
+        if (stride < Block_t::size) {
+            throw std::runtime_error{std::format("StructLayout::{}: stride {} is less than {}.\n",
+                                                 name, stride, Block_t::size)};
+        }
+        if (count && num_bytes < (count - 1) * stride + Block_t::size) {
+            throw std::runtime_error{std::format("StructLayout::{}: {} bytes can't hold {} elements.\n",
+                                                 name, num_bytes, count)};
+        }
+    }
+};
+
+
+}
+}
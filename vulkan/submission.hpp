@@ -0,0 +1,166 @@
+#pragma once
+
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "jms/vulkan/vulkan.hpp"
+#include "jms/vulkan/utils.hpp"
+
+
+namespace jms {
+namespace vulkan {
+
+
+/***
+ * One timeline semaphore per queue (or per device when a single queue is used); every Submit signals the next value
+ * so any resource used by a submit can be tagged with its value and freed once CompletedValue reaches it.
+ *
+ * Requires the timelineSemaphore (1.2) and synchronization2 (1.3) features.
+ */
+class SubmissionTracker {
+    vk::raii::Device* device{nullptr};
+    vk::raii::Semaphore timeline{nullptr};
+    uint64_t last_submitted{0};
+    uint64_t completed{0};
+
+public:
+    SubmissionTracker(vk::raii::Device& device,
+                      std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt)
+    : device{std::addressof(device)}
+    {
+        vk::SemaphoreTypeCreateInfo type_info{
+            .semaphoreType=vk::SemaphoreType::eTimeline,
+            .initialValue=0
+        };
+        timeline = device.createSemaphore({.pNext=std::addressof(type_info)},
+                                          vk_allocation_callbacks.value_or(nullptr));
+    }
+    SubmissionTracker(const SubmissionTracker&) = delete;
+    SubmissionTracker(SubmissionTracker&&) noexcept = default;
+    ~SubmissionTracker() noexcept = default;
+    SubmissionTracker& operator=(const SubmissionTracker&) = delete;
+    SubmissionTracker& operator=(SubmissionTracker&&) noexcept = default;
+
+    // Returns the value signaled when the submitted work completes.  Binary semaphores (e.g. swapchain acquire and
+    // present) can still be given in waits/signals.
+    uint64_t Submit(vk::raii::Queue& queue,
+                    const std::vector<vk::CommandBufferSubmitInfo>& command_buffers,
+                    const std::vector<vk::SemaphoreSubmitInfo>& waits = {},
+                    const std::vector<vk::SemaphoreSubmitInfo>& signals = {},
+                    vk::Fence fence = {}) {
+        uint64_t value = last_submitted + 1;
+        std::vector<vk::SemaphoreSubmitInfo> all_signals{signals};
+        all_signals.push_back({
+            .semaphore=*timeline,
+            .value=value,
+            .stageMask=vk::PipelineStageFlagBits2::eAllCommands
+        });
+        queue.submit2({vk::SubmitInfo2{
+            .waitSemaphoreInfoCount=static_cast<uint32_t>(waits.size()),
+            .pWaitSemaphoreInfos=VectorAsPtr(waits),
+            .commandBufferInfoCount=static_cast<uint32_t>(command_buffers.size()),
+            .pCommandBufferInfos=VectorAsPtr(command_buffers),
+            .signalSemaphoreInfoCount=static_cast<uint32_t>(all_signals.size()),
+            .pSignalSemaphoreInfos=VectorAsPtr(all_signals)
+        }}, fence);
+        last_submitted = value;
+        return value;
+    }
+
+    // Wait info so work on another queue can depend on value; e.g. graphics waiting on an async upload.
+    vk::SemaphoreSubmitInfo WaitInfo(uint64_t value, vk::PipelineStageFlags2 stage_mask) const noexcept {
+        return {.semaphore=*timeline, .value=value, .stageMask=stage_mask};
+    }
+
+    // Queries the semaphore; cheap enough to call once per frame.
+    uint64_t CompletedValue() {
+        completed = std::max(completed, timeline.getCounterValue());
+        return completed;
+    }
+
+    bool IsComplete(uint64_t value) { return value <= completed || value <= CompletedValue(); }
+
+    // Returns false on timeout.
+    bool Wait(uint64_t value, uint64_t timeout = std::numeric_limits<uint64_t>::max()) {
+        if (value <= completed) { return true; }
+        vk::Semaphore semaphore = *timeline;
+        vk::Result result = device->waitSemaphores({
+            .semaphoreCount=1,
+            .pSemaphores=std::addressof(semaphore),
+            .pValues=std::addressof(value)
+        }, timeout);
+        if (result == vk::Result::eTimeout) { return false; }
+        completed = std::max(completed, value);
+        return true;
+    }
+
+    void WaitIdle() { Wait(last_submitted); }
+
+    uint64_t LastSubmitted() const noexcept { return last_submitted; }
+    const vk::raii::Semaphore& Semaphore() const noexcept { return timeline; }
+};
+
+
+/***
+ * Destruction deferred until the GPU has passed a timeline value.  Retire takes ownership of any movable resource
+ * (Buffer, Image, vk::raii handles, ...) and destroys it from Collect once completed_value >= retire_value; no
+ * waitIdle is needed to unload or stream resources.
+ *
+ * Destroying the queue destroys everything still pending so the device must be idle by then.
+ */
+class DeferredDeletionQueue {
+    std::deque<std::pair<uint64_t, std::move_only_function<void()>>> pending{};
+
+public:
+    DeferredDeletionQueue() noexcept = default;
+    DeferredDeletionQueue(const DeferredDeletionQueue&) = delete;
+    DeferredDeletionQueue(DeferredDeletionQueue&&) noexcept = default;
+    ~DeferredDeletionQueue() noexcept { Collect(std::numeric_limits<uint64_t>::max()); }
+    DeferredDeletionQueue& operator=(const DeferredDeletionQueue&) = delete;
+    DeferredDeletionQueue& operator=(DeferredDeletionQueue&&) noexcept = default;
+
+    // Kept sorted by retire_value; pushes are almost always in order so this is an append.
+    void Push(uint64_t retire_value, std::move_only_function<void()> destroy_fn) {
+        auto it = std::ranges::upper_bound(pending, retire_value, {}, [](const auto& p) { return p.first; });
+        pending.emplace(it, retire_value, std::move(destroy_fn));
+    }
+
+    template <typename T>
+    void Retire(uint64_t retire_value, T&& resource) {
+        Push(retire_value, [r=std::forward<T>(resource)]() mutable { [[maybe_unused]] auto destroyed = std::move(r); });
+    }
+
+    // Resources used by everything submitted so far.
+    template <typename T>
+    void Retire(const SubmissionTracker& tracker, T&& resource) {
+        Retire(tracker.LastSubmitted(), std::forward<T>(resource));
+    }
+
+    // Returns the number of resources destroyed.
+    size_t Collect(uint64_t completed_value) {
+        size_t count = 0;
+        while (!pending.empty() && pending.front().first <= completed_value) {
+            auto destroy_fn = std::move(pending.front().second);
+            pending.pop_front();
+            destroy_fn();
+            ++count;
+        }
+        return count;
+    }
+
+    size_t Collect(SubmissionTracker& tracker) { return Collect(tracker.CompletedValue()); }
+
+    size_t NumPending() const noexcept { return pending.size(); }
+};
+
+
+}
+}
@@ -0,0 +1,227 @@
+#pragma once
+
+
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "jms/memory/aliasing.hpp"
+#include "jms/vulkan/vulkan.hpp"
+#include "jms/vulkan/info.hpp"
+#include "jms/vulkan/render_graph.hpp"
+
+
+namespace jms {
+namespace vulkan {
+
+
+// Lifetime [first, last] in pass positions; see CompiledRenderGraph::lifetimes
+struct TransientImageRequest {
+    ImageInfo info{};
+    size_t first{0};
+    size_t last{0};
+};
+
+
+constexpr vk::ImageUsageFlags LAZY_COMPATIBLE_USAGE = vk::ImageUsageFlagBits::eColorAttachment |
+                                                     vk::ImageUsageFlagBits::eDepthStencilAttachment |
+                                                     vk::ImageUsageFlagBits::eInputAttachment |
+                                                     vk::ImageUsageFlagBits::eTransientAttachment;
+
+
+/***
+ * Images with non overlapping lifetimes packed into shared VkDeviceMemory; one allocation per memory type used.
+ *
+ * Images only used as attachments are created with eTransientAttachment and placed in LAZILY_ALLOCATED memory when
+ * the device has it (tilers), so they may never be backed by physical memory at all.  Everything else goes to the
+ * first DEVICE_LOCAL type the image accepts.
+ *
+ * All images are optimal tiling so bufferImageGranularity does not apply.  Contents of an image are undefined at
+ * its first use; pair with RenderGraph::AddMemoryAliasBarriers (see AllocateRenderGraphTransients).
+ */
+class TransientImageHeap {
+    struct Heap {
+        uint32_t memory_type_index{0};
+        bool is_lazy{false};
+        vk::DeviceSize size{0};
+        vk::DeviceSize unaliased_size{0};
+        vk::raii::DeviceMemory memory{nullptr};
+    };
+
+    std::vector<vk::raii::Image> images{};
+    std::vector<size_t> image_heap{};
+    std::vector<vk::DeviceSize> image_offset{};
+    std::vector<Heap> heaps{};
+    std::vector<std::pair<size_t, size_t>> aliased_pairs{};
+
+public:
+    TransientImageHeap() noexcept = default;
+    TransientImageHeap(const vk::raii::PhysicalDevice& physical_device,
+                       vk::raii::Device& device,
+                       const std::vector<TransientImageRequest>& requests,
+                       std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt)
+    {
+        vk::PhysicalDeviceMemoryProperties props = physical_device.getMemoryProperties();
+        auto FindType = [&props](uint32_t type_bits, vk::MemoryPropertyFlags required) -> std::optional<uint32_t> {
+            for (uint32_t i : std::views::iota(static_cast<uint32_t>(0), props.memoryTypeCount)) {
+                if ((type_bits & (static_cast<uint32_t>(1) << i)) &&
+                    (props.memoryTypes[i].propertyFlags & required) == required) { return i; }
+            }
+            return std::nullopt;
+        };
+        constexpr vk::MemoryPropertyFlags LAZY_FLAGS = vk::MemoryPropertyFlagBits::eDeviceLocal |
+                                                       vk::MemoryPropertyFlagBits::eLazilyAllocated;
+
+        // memory type index -> (request indices, intervals)
+        std::map<uint32_t, std::pair<std::vector<size_t>, std::vector<jms::memory::AliasInterval<vk::DeviceSize>>>>
+            groups{};
+        images.reserve(requests.size());
+        image_heap.resize(requests.size());
+        image_offset.resize(requests.size());
+        for (size_t i = 0; i < requests.size(); ++i) {
+            const TransientImageRequest& request = requests[i];
+            if (request.info.tiling != vk::ImageTiling::eOptimal) {
+                throw std::runtime_error{"TransientImageHeap only supports optimal tiling images."};
+            }
+            vk::ImageCreateInfo create_info = request.info.ToCreateInfo();
+            bool is_lazy_candidate = (create_info.usage & ~LAZY_COMPATIBLE_USAGE) == vk::ImageUsageFlags{};
+            std::optional<uint32_t> type_index{};
+            if (is_lazy_candidate) {
+                create_info.usage |= vk::ImageUsageFlagBits::eTransientAttachment;
+                images.push_back(device.createImage(create_info, vk_allocation_callbacks.value_or(nullptr)));
+                type_index = FindType(images.back().getMemoryRequirements().memoryTypeBits, LAZY_FLAGS);
+                if (!type_index) {
+                    create_info.usage = request.info.usage;
+                    images.back() = device.createImage(create_info, vk_allocation_callbacks.value_or(nullptr));
+                }
+            } else {
+                images.push_back(device.createImage(create_info, vk_allocation_callbacks.value_or(nullptr)));
+            }
+            vk::MemoryRequirements reqs = images.back().getMemoryRequirements();
+            if (!type_index) { type_index = FindType(reqs.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal); }
+            if (!type_index) {
+                throw std::runtime_error{std::format("TransientImageHeap: no device local memory for image {}\n", i)};
+            }
+            auto& [indices, intervals] = groups[type_index.value()];
+            indices.push_back(i);
+            intervals.push_back({.size=reqs.size, .alignment=reqs.alignment, .first=request.first, .last=request.last});
+        }
+
+        heaps.reserve(groups.size());
+        for (auto& [type_index, group] : groups) {
+            auto& [indices, intervals] = group;
+            jms::memory::AliasPacking<vk::DeviceSize> packing = jms::memory::PackAliasIntervals(intervals);
+            heaps.push_back({
+                .memory_type_index=type_index,
+                .is_lazy=static_cast<bool>(props.memoryTypes[type_index].propertyFlags &
+                                           vk::MemoryPropertyFlagBits::eLazilyAllocated),
+                .size=packing.total_size,
+                .unaliased_size=jms::memory::UnaliasedSize(intervals),
+                .memory=device.allocateMemory({
+                    .allocationSize=packing.total_size,
+                    .memoryTypeIndex=type_index
+                }, vk_allocation_callbacks.value_or(nullptr))
+            });
+            for (auto [local, request_index] : std::views::enumerate(indices)) {
+                image_heap[request_index] = heaps.size() - 1;
+                image_offset[request_index] = packing.offsets[local];
+                images[request_index].bindMemory(*heaps.back().memory, packing.offsets[local]);
+            }
+            for (const auto& [a, b] : jms::memory::AliasedPairs(intervals, packing)) {
+                aliased_pairs.emplace_back(indices[a], indices[b]);
+            }
+        }
+    }
+    TransientImageHeap(const TransientImageHeap&) = delete;
+    TransientImageHeap(TransientImageHeap&&) noexcept = default;
+    ~TransientImageHeap() noexcept = default;
+    TransientImageHeap& operator=(const TransientImageHeap&) = delete;
+    TransientImageHeap& operator=(TransientImageHeap&&) noexcept = default;
+
+    vk::Image AsVkImage(size_t index) const { return *images.at(index); }
+
+    vk::raii::ImageView CreateView(
+        vk::raii::Device& device,
+        size_t index,
+        const ImageViewInfo& info,
+        std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt) const
+    {
+        return device.createImageView(info.ToCreateInfo(*images.at(index)), vk_allocation_callbacks.value_or(nullptr));
+    }
+
+    // (earlier, later) request indices that share memory.
+    const std::vector<std::pair<size_t, size_t>>& AliasedPairs() const noexcept { return aliased_pairs; }
+
+    bool IsLazy(size_t index) const { return heaps.at(image_heap.at(index)).is_lazy; }
+    vk::DeviceSize Offset(size_t index) const { return image_offset.at(index); }
+    size_t NumImages() const noexcept { return images.size(); }
+
+    // Committed size excluding lazily allocated heaps; compare with UnaliasedSize for the savings.
+    vk::DeviceSize Size() const noexcept {
+        vk::DeviceSize total = 0;
+        for (const auto& heap : heaps) { if (!heap.is_lazy) { total += heap.size; } }
+        return total;
+    }
+
+    vk::DeviceSize UnaliasedSize() const noexcept {
+        vk::DeviceSize total = 0;
+        for (const auto& heap : heaps) { if (!heap.is_lazy) { total += heap.unaliased_size; } }
+        return total;
+    }
+};
+
+
+// Transient physical images of a compiled render graph; physicals[i] is the physical index of heap image i.
+struct RenderGraphTransients {
+    TransientImageHeap heap{};
+    std::vector<size_t> physicals{};
+
+    void SetHandles(std::vector<RenderGraphHandle>& physical_handles) const {
+        for (auto [index, physical] : std::views::enumerate(physicals)) {
+            physical_handles.at(physical) = heap.AsVkImage(static_cast<size_t>(index));
+        }
+    }
+};
+
+
+// Allocates every used transient physical image of compiled and adds the memory aliasing barriers to it.
+RenderGraphTransients AllocateRenderGraphTransients(
+    const vk::raii::PhysicalDevice& physical_device,
+    vk::raii::Device& device,
+    const RenderGraph& graph,
+    CompiledRenderGraph& compiled,
+    std::optional<vk::AllocationCallbacks*> vk_allocation_callbacks = std::nullopt)
+{
+    RenderGraphTransients out{};
+    std::vector<TransientImageRequest> requests{};
+    for (size_t p = 0; p < compiled.physicals.size(); ++p) {
+        const RenderGraphPhysical& physical = compiled.physicals[p];
+        if (!physical.transient || !physical.lifetime) { continue; }
+        out.physicals.push_back(p);
+        requests.push_back({
+            .info=graph.Resources().at(physical.first_resource).image_info,
+            .first=physical.lifetime->first,
+            .last=physical.lifetime->second
+        });
+    }
+    out.heap = TransientImageHeap{physical_device, device, requests, vk_allocation_callbacks};
+
+    std::vector<std::pair<size_t, size_t>> physical_pairs{};
+    physical_pairs.reserve(out.heap.AliasedPairs().size());
+    std::ranges::transform(out.heap.AliasedPairs(), std::back_inserter(physical_pairs), [&out](const auto& pair) {
+        return std::pair{out.physicals[pair.first], out.physicals[pair.second]};
+    });
+    RenderGraph::AddMemoryAliasBarriers(compiled, physical_pairs);
+    return out;
+}
+
+
+}
+}